@@ -0,0 +1,142 @@
+// cpp/apps/mc_sweep.cpp
+//
+// Sweep driver: runs params_list.txt rows in one process (see sim/sweep.hpp).
+//
+//   mc_sweep quarter|eighth [--params FILE] [--task N | --rows FIRST-LAST]
+//            [--out-root DIR] [--threads N] [--seed S] [--philox] [--pack N]
+//            [--local [--chunk N]]
+//
+// Rows are 0-based like SLURM_ARRAY_TASK_ID; without --task/--rows every row runs. Each row
+// writes <out-root>/<Quarter_plane|Eighth_Wedge>/.../results.txt and logs one line to stderr.
+// --pack N simulates selected rows with equal nsteps together, up to N particles per pack
+// (sim::run_sweep_pack(); each row's results are unchanged).
+// --local runs the selected rows without SLURM on a work-stealing pool of --threads workers
+// (default: all cores), cut into chunks of --chunk particles (default 10000; 0 = whole rows);
+// see sim::run_sweep_local().
+
+#include <chrono>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "sim/sweep.hpp"
+
+namespace {
+
+    int usage(const char* argv0) {
+        std::cerr << "usage: " << argv0 << " quarter|eighth [--params FILE] [--task N | --rows FIRST-LAST]\n"
+                  << "       [--out-root DIR] [--threads N] [--seed S] [--philox] [--pack N]\n"
+                  << "       [--local [--chunk N]]\n";
+        return 2;
+    }
+
+    std::size_t to_count(const std::string& s) {
+        std::size_t used = 0;
+        const unsigned long long v = std::stoull(s, &used);
+        if (used != s.size()) throw std::invalid_argument("not a number: " + s);
+        return static_cast<std::size_t>(v);
+    }
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2) return usage(argv[0]);
+
+    sim::SweepOptions opt;
+    const std::string geometry = argv[1];
+    if (geometry == "quarter") {
+        opt.geometry = sim::SweepGeometry::Quarter;
+    } else if (geometry == "eighth") {
+        opt.geometry = sim::SweepGeometry::Eighth;
+    } else {
+        return usage(argv[0]);
+    }
+
+    std::string params = "params_list.txt";
+    std::size_t first = 0, last = static_cast<std::size_t>(-1);
+    bool local = false, threads_given = false;
+    opt.chunk_particles = 10000;
+    try {
+        for (int a = 2; a < argc; ++a) {
+            const std::string arg = argv[a];
+            const bool has_value = a + 1 < argc;
+            if (arg == "--philox") {
+                opt.rng_engine = sim::RngEngine::Philox4x32;
+            } else if (arg == "--local") {
+                local = true;
+            } else if (!has_value) {
+                return usage(argv[0]);
+            } else if (arg == "--params") {
+                params = argv[++a];
+            } else if (arg == "--task") {
+                first = last = to_count(argv[++a]);
+            } else if (arg == "--rows") {
+                const std::string range = argv[++a];
+                const auto dash = range.find('-');
+                if (dash == std::string::npos) return usage(argv[0]);
+                first = to_count(range.substr(0, dash));
+                last = to_count(range.substr(dash + 1));
+            } else if (arg == "--out-root") {
+                opt.out_root = argv[++a];
+            } else if (arg == "--threads") {
+                opt.n_threads = to_count(argv[++a]);
+                threads_given = true;
+            } else if (arg == "--seed") {
+                opt.base_seed = static_cast<unsigned int>(to_count(argv[++a]));
+            } else if (arg == "--pack") {
+                opt.pack_particles = to_count(argv[++a]);
+            } else if (arg == "--chunk") {
+                opt.chunk_particles = to_count(argv[++a]);
+            } else {
+                return usage(argv[0]);
+            }
+        }
+    } catch (const std::exception&) {
+        return usage(argv[0]);
+    }
+
+    try {
+        const auto rows = sim::read_params_list(params);
+        if (rows.empty() || first >= rows.size() || first > last) {
+            std::cerr << "[ERROR] no rows selected from " << params << " (" << rows.size() << " rows)\n";
+            return 1;
+        }
+        if (last >= rows.size()) last = rows.size() - 1;
+
+        const std::vector<sim::SweepParams> selected(rows.begin() + static_cast<std::ptrdiff_t>(first),
+                                                     rows.begin() + static_cast<std::ptrdiff_t>(last) + 1);
+        using clock = std::chrono::steady_clock;
+        if (local) {
+            if (!threads_given) opt.n_threads = 0;
+            const auto t0 = clock::now();
+            std::mutex log_mtx;
+            sim::run_sweep_local(selected, opt, [&](std::size_t r, const sim::SweepResult& result) {
+                const std::string path = sim::save_sweep_results(selected[r], opt, result);
+                const double s = std::chrono::duration<double>(clock::now() - t0).count();
+                std::lock_guard<std::mutex> lock(log_mtx);
+                std::cerr << "[INFO] row " << first + r << " -> " << path << " (done at " << s << " s)\n";
+            });
+            return 0;
+        }
+        for (const auto& pack : sim::plan_sweep_packs(selected, opt.pack_particles)) {
+            const auto t0 = clock::now();
+            std::vector<sim::SweepParams> members;
+            for (std::size_t j : pack) members.push_back(selected[j]);
+            const auto results = sim::run_sweep_pack(members, opt);
+            const double ms = std::chrono::duration<double, std::milli>(clock::now() - t0).count();
+            for (std::size_t j = 0; j < pack.size(); ++j) {
+                const std::string path = sim::save_sweep_results(members[j], opt, results[j]);
+                std::cerr << "[INFO] row " << first + pack[j] << " -> " << path << " (" << ms << " ms";
+                if (pack.size() > 1) std::cerr << ", pack of " << pack.size();
+                std::cerr << ")\n";
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "[ERROR] " << e.what() << '\n';
+        return 1;
+    }
+    return 0;
+}
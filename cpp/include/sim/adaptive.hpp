@@ -0,0 +1,83 @@
+#pragma once
+/**
+ * @file adaptive.hpp
+ * @brief Adaptive stopping: run particles in batches until estimators reach a target precision.
+ *
+ * What the file is for:
+ *   A fixed n_particles (nreals) has to be sized for the hardest parameter set, so easy sets
+ *   waste cluster time. run_adaptive() runs batches of particles through the same
+ *   MomentObserver (and any other observers) and stops as soon as every StopTarget's
+ *   standard error is small enough, or a batch cap or wall-clock budget is hit.
+ *
+ * Reproducibility:
+ *   Batch b runs with first_particle = cfg.first_particle + b * batch_size, so with
+ *   deterministic seeding the batches draw exactly the particles of one larger run, and the
+ *   stopping test only reads the merged moments after each whole batch. A rerun therefore
+ *   stops after the same batch with the same results, unless the wall-clock budget ended it.
+ *
+ * See also: observers.hpp (MomentObserver, Moments::required_samples()).
+ */
+
+#include <cstddef>
+#include <functional>
+#include <limits>
+#include <vector>
+
+#include "sim/observers.hpp"
+#include "sim/reflecting_world.hpp"
+#include "sim/simulation.hpp"
+
+namespace sim {
+
+    /// Precision requirement on one MomentObserver estimator.
+    struct StopTarget {
+        static constexpr std::size_t kLastOutput = std::numeric_limits<std::size_t>::max();
+
+        MomentObserver::Quantity quantity{MomentObserver::X};
+        std::size_t output{kLastOutput};    ///< Output index (kLastOutput = state after the last step).
+        double      abs_error{0.0};         ///< Met when std_error() <= abs_error (0 = not used).
+        double      rel_error{0.0};         ///< Met when std_error() <= rel_error * |mean| (0 = not used).
+
+        /// True if @p m satisfies either bound (and has at least two samples).
+        bool met(const Moments& m) const noexcept;
+    };
+
+    /// Batching and stopping rules for run_adaptive().
+    struct AdaptiveConfig {
+        std::size_t             batch_size{1000};   ///< Particles per batch. @pre batch_size >= 2.
+        std::size_t             min_batches{2};     ///< Never stop before this many batches.
+        std::size_t             max_batches{1000};  ///< Always stop after this many batches.
+        double                  max_seconds{0.0};   ///< Wall-clock budget checked after each batch (0 = none).
+        std::vector<StopTarget> targets;            ///< All must be met to stop early; empty = run max_batches.
+    };
+
+    enum class StopReason {
+        Converged,      ///< Every target was met.
+        MaxBatches,     ///< max_batches reached first.
+        TimeBudget      ///< max_seconds exceeded first.
+    };
+
+    struct AdaptiveResult {
+        std::size_t n_batches{0};
+        std::size_t n_particles{0};     ///< n_batches * batch_size.
+        StopReason  reason{StopReason::MaxBatches};
+        double      seconds{0.0};       ///< Wall-clock time of all batches.
+    };
+
+    /// Prepares a batch simulation (positions, step types, callbacks); receives its first_particle.
+    using BatchSetup = std::function<void(Simulation& sim, std::size_t first_particle)>;
+
+    /**
+     * @brief Run batches of cfg.n_steps steps until the targets on @p moments are met.
+     *
+     * Each batch is a fresh Simulation with cfg, except n_particles = batch_size,
+     * first_particle as in the file notes and record_history = false. @p moments and
+     * @p observers are attached to every batch, so they accumulate over all batches (their
+     * outputs are indexed from the start of a batch). @p setup runs before each batch.
+     */
+    AdaptiveResult run_adaptive(const ReflectingWorld& world, const SimulationConfig& cfg,
+                                const AdaptiveConfig& acfg, MomentObserver& moments,
+                                const BatchSetup& setup = {},
+                                const std::vector<PositionObserver*>& observers = {});
+
+} // namespace sim
@@ -0,0 +1,80 @@
+#pragma once
+/**
+ * @file analytic_worlds.hpp
+ * @brief Closed-form reflecting geometries: axis-aligned box, half-plane and wedge.
+ *
+ * What the file is for:
+ *   ReflectingWorld reduces every domain to finite segments and traces bounces one at a time.
+ *   For the simple domains used by the production runs (quarter and eighth planes, boxes) the
+ *   final position after any number of specular bounces has a closed form:
+ *     - Box:        fold each coordinate into [lo, hi] (triangle wave of period 2 (hi - lo)).
+ *     - Half-plane: mirror the endpoint across the line if it ended on the wrong side.
+ *     - Wedge:      unfold the path through mirrored copies of the wedge; the polar angle
+ *                   swept by a straight line is known, so fold it into [0, angle].
+ *   These are O(1) per step with no segment scan and no reflection cap.
+ *
+ * Selection:
+ *   Each type has its own advance_with_reflections() overload, so code templated on the
+ *   world type (e.g. a policy-templated driver) picks the closed form at compile time.
+ *   Arbitrary polygons keep using ReflectingWorld.
+ *
+ * Agreement with the generic engine:
+ *   A step that hits no wall returns x + d exactly, as the generic engine does. After a bounce
+ *   the generic engine nudges the point EPS_POS off the wall and the closed forms do not, so the
+ *   results differ by at most about EPS_POS per bounce (plus roundoff for the wedge, which
+ *   works in polar coordinates).
+ *
+ * Conventions:
+ *   - Box bounds may be infinite (e.g. BoxWorld{0, inf, 0, inf} is the quarter plane).
+ *   - The wedge has its apex at the origin and spans polar angles [0, angle], angle in (0, pi]
+ *     (pi/2: quarter plane, pi/4: eighth plane).
+ *   - Positions are assumed to start inside the domain.
+ *
+ * See also: reflecting_world.hpp (generic segment engine).
+ */
+
+#include "sim/vec2.hpp"
+
+namespace sim {
+
+    /// Axis-aligned reflecting box [xmin, xmax] x [ymin, ymax]; bounds may be +-infinity.
+    struct BoxWorld {
+        double xmin{0.0};   ///< Left bound
+        double xmax{1.0};   ///< Right bound  (require xmin < xmax)
+        double ymin{0.0};   ///< Bottom bound
+        double ymax{1.0};   ///< Top bound    (require ymin < ymax)
+    };
+
+    /// Reflecting half-plane { x | n_hat·x >= c }.
+    struct HalfPlaneWorld {
+        Vec2   n_hat{0.0, 1.0}; ///< Unit normal pointing into the allowed side
+        double c{0.0};          ///< Line offset: boundary is { x | n_hat·x = c }
+
+        /// Build from any non-zero normal (normalized here; c is scaled to match).
+        static HalfPlaneWorld from_normal(const Vec2& n, double c);
+    };
+
+    /// Reflecting wedge with apex at the origin spanning polar angles [0, angle].
+    struct WedgeWorld {
+        double angle{1.5707963267948966};   ///< Opening angle in (0, pi]; default pi/2 (quarter plane)
+    };
+
+    /**
+     * @brief Closed-form specular reflection in an axis-aligned box.
+     * @post x lies in the box; x + d exactly if no wall is crossed.
+     */
+    void advance_with_reflections(Vec2& x, Vec2 d, const BoxWorld& world);
+
+    /**
+     * @brief Closed-form specular reflection at a single line.
+     * @post n_hat·x >= c (up to roundoff); x + d exactly if the line is not crossed.
+     */
+    void advance_with_reflections(Vec2& x, Vec2 d, const HalfPlaneWorld& world);
+
+    /**
+     * @brief Closed-form specular reflection in a wedge (any number of bounces off both rays).
+     * @post x lies in the wedge; x + d exactly if neither ray is crossed.
+     */
+    void advance_with_reflections(Vec2& x, Vec2 d, const WedgeWorld& world);
+
+} // namespace sim
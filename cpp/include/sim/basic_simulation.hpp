@@ -0,0 +1,1503 @@
+// SPDX-License_Identifier: MIT
+#pragma once
+/**
+ * @file basic_simulation.hpp
+ * @brief Policy-templated simulation core: step model, geometry and RNG fixed at compile time.
+ *
+ * @details BasicSimulation<Step, World, Rng> owns the particle state and runs the step loop:
+ *  1) the Step policy fills the displacements of a sub-batch of particles,
+ *  2) each displacement is applied through the World's advance_with_reflections() overload,
+ *  3) history is recorded at a stride (store_every), in memory or streamed to a HistorySink,
+ *     and attached PositionObservers see the positions at their own output stride.
+ * With concrete policies (e.g. BrownianStep + BoxWorld + PhiloxRng) the compiler sees the
+ * whole step: no per-particle switch, no std::function, no out-of-line RNG calls.
+ *
+ * Policies:
+ *  - Step: callable as step(store, batch) with a StepBatch; writes batch.dx/dy for particles
+ *    [first, first + count) at step index batch.step. Must be const-callable and thread-safe
+ *    (ranges run concurrently). Provided: BrownianStep, SpecifiedParamsStep, CallbackStep<Fn>,
+ *    and MixedStep (per-particle StepType switch + std::function; used by sim::Simulation).
+ *  - World: any type with an advance_with_reflections(Vec2&, Vec2, const World&) overload:
+ *    ReflectingWorld (generic; uses the clearance cache when enabled), BoxWorld,
+ *    HalfPlaneWorld, WedgeWorld (analytic_worlds.hpp).
+ *  - Rng: provides gauss(), uniform() and seek_step(k); seeded by seed_rngs(). sim::RNG (runtime
+ *    engine selection) or PhiloxRng (philox_rng.hpp).
+ *
+ * Absorbing walls: when the ReflectingWorld has walls with absorb > 0 (set_absorbing()), each
+ * displacement goes through advance_to_absorbing(). A hit absorbs the particle with the wall's
+ * probability (drawn from the particle's own RNG, else it reflects); the particle is retired at
+ * the contact point with its fractional exit step and the wall id (store columns alive,
+ * exit_step, exit_wall). Retired particles are swapped behind the active ones of their worker's
+ * block, so later steps only visit active particles; they stay in history at their exit point
+ * and are not passed to observers. Without absorbing walls the step loop is unchanged.
+ *
+ * Grouping: run_grouped() partitions a mixed population by step model (and Brownian particles by
+ * identical BrownianParams), reorders the SoA store so each group is contiguous, advances each
+ * group with its homogeneous policy, then restores the caller's order.
+ *
+ * Reproducibility: for the same seeds, policies that draw the same numbers produce bit-identical
+ * results regardless of n_threads, loop_order, tile_size and grouping (see SimulationConfig),
+ * including which particles are absorbed and when.
+ *
+ * Checkpoints: save_checkpoint() writes the particle columns (in the caller's order), every
+ * RNG state, the in-memory history or the number of streamed frames, observer state and the
+ * progress of an interrupted run() (checkpoint.hpp). With cfg.checkpoint_every, run() writes
+ * one every that many steps. After load_checkpoint() into a simulation built with the same
+ * world, config, step policy and observers, run() finishes the interrupted run; the result is
+ * bit-identical to an uninterrupted one.
+ *
+ * Segments: run_until(k) / run_steps(k) advance the current run incrementally. A run split into
+ * segments is bit-identical to run(): step indices (callbacks, Philox counters, exit_step),
+ * history frames and observer outputs keep their in-run numbering, and the store order a run
+ * builds up (grouping, absorbed particles) is carried from one segment to the next. Between
+ * segments positions(), history() and observer results are current and in the caller's order.
+ * Per-run state is set up once per run, not per segment: run_grouped() keeps its groups and a
+ * streamed run keeps its HistoryWriter and fill buffer until the run completes, fails or the
+ * sink changes. Frames a paused run has buffered reach the sink when the buffer fills, at the
+ * end of the run, on set_history_sink() or save_checkpoint(), or when the simulation is destroyed.
+ *
+ * Key types: sim::BasicSimulation, sim::SimulationConfig, sim::StepBatch.
+ * @see sim::simulation.hpp (runtime-dispatched facade), sim::particle_store.hpp
+ */
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "sim/vec2.hpp"
+#include "sim/rng.hpp"
+#include "sim/reflecting_world.hpp"
+#include "sim/analytic_worlds.hpp"
+#include "sim/step_generators.hpp"
+#include "sim/parallel.hpp"
+#include "sim/particle_store.hpp"
+#include "sim/history_sink.hpp"
+#include "sim/observers.hpp"
+#include "sim/checkpoint.hpp"
+
+namespace sim {
+
+    /**
+     * @enum LoopOrder
+     * @brief Order in which run() visits (step, particle) pairs.
+     *
+     * Both orders produce identical results because per-particle RNG streams,
+     * parameters and positions are independent; they differ only in memory traffic.
+     *
+     * - LoopOrder::StepMajor     - for each step, advance every particle (original order).
+     * - LoopOrder::ParticleMajor - for each tile of @ref SimulationConfig::tile_size particles,
+     *                              run all steps before moving on, keeping that tile's RNG,
+     *                              params and position resident in cache.
+     */
+    enum class LoopOrder {
+        StepMajor,      ///< Outer loop over steps, inner loop over particles.
+        ParticleMajor   ///< Outer loop over particle tiles, inner loop over steps.
+    };
+
+    /**
+     * @struct SimulationConfig
+     * @brief Run-wide settings for a simulation.
+     *
+     * Notes:
+     * - History storage can be memory-intensive; use 'store_every' to decimate, or stream
+     *   frames to a HistorySink (resident memory ~ 'history_buffer_bytes').
+     * - If 'deterministic == true', each particle's RNG is seeded with
+     *   'base_seed + particle_index', ensuring reproducible runs. 'first_particle' offsets
+     *   that index, so a batch with first_particle = b draws exactly the numbers of particles
+     *   [b, b + n_particles) of one larger run (adaptive.hpp).
+     * - With 'rng_engine == RngEngine::Philox4x32', particle i at step k draws from the
+     *   counter stream (base_seed, i, k): a few bytes of state per particle, and any step
+     *   can be regenerated without replaying the earlier ones.
+     * - 'n_threads', 'loop_order' and 'tile_size' only change how work is scheduled;
+     *   results are bit-identical to the serial step-major run for the same seeds.
+     * - 'use_clearance' caches a per-particle distance-to-boundary bound so interior steps
+     *   skip the wall scan (advance_with_clearance()); results are bit-identical either way.
+     *   Indexed worlds (ReflectingWorld::build_index()) ignore it: their grid trace already
+     *   touches only nearby walls and costs less than keeping the bound up to date.
+     * - 'rng_engine' and 'normal_method' apply to sim::RNG; compile-time RNG policies
+     *   (e.g. PhiloxRng) fix both and only use base_seed / deterministic.
+     * - 'checkpoint_every' > 0 with a 'checkpoint_path' makes run() save a checkpoint after
+     *   every that many steps of the run (not after the last one); a job restarted after
+     *   being killed calls load_checkpoint() and run() to finish the interrupted run.
+     */
+    struct SimulationConfig {
+        std::size_t n_particles     {1};        ///< Number of independent particles to simulate. @pre n_particles >=1.
+        std::size_t n_steps         {0};        ///< Total number of integration steps to run. @pre n_steps >= 0.
+
+        bool        record_history  {true};     ///< If true, store particle trajectories for post-analysis.
+        std::size_t store_every     {1};        ///< Keep 1 of every k frames (decimation factor). @pre store_every >= 1.
+        std::size_t history_buffer_bytes {64u << 20}; ///< Total size of the two frame buffers used when streaming to a HistorySink.
+
+        // RNG policy
+        unsigned int base_seed      {5489u};    ///< Base seed used to derive per-particle seeds.
+        bool         deterministic  {true};     ///< If true, per-particle seed = base_seed + i; if false, use hardware seeding.
+        std::size_t  first_particle {0};        ///< Global index of particle 0 for seeding: particle i uses stream first_particle + i.
+        RngEngine    rng_engine     {RngEngine::MT19937}; ///< MT19937 (legacy streams) or counter-based Philox4x32.
+        NormalMethod normal_method  {NormalMethod::Legacy}; ///< Legacy (bit-compatible with old runs) or portable Ziggurat sampler.
+
+        // Execution policy
+        std::size_t n_threads       {1};        ///< Threads used by run(); 0 = hardware concurrency. Particles are split in contiguous ranges.
+        LoopOrder   loop_order      {LoopOrder::StepMajor}; ///< Step-major (default) or particle-major traversal.
+        std::size_t tile_size       {1};        ///< Particles per tile for ParticleMajor (1 = run each particle to completion). @pre tile_size >= 1.
+        bool        use_clearance   {true};     ///< Skip the wall scan for steps shorter than the cached clearance (unindexed worlds).
+
+        // Checkpointing
+        std::size_t checkpoint_every{0};        ///< Steps between automatic checkpoints during run() (0 = none).
+        std::string checkpoint_path {};         ///< File replaced atomically by each automatic checkpoint.
+
+        // Default Brownian parameters (can be overridden per particle if desired)
+        BrownianParams brownian{};              ///< Default Gaussian step configuration for StepType::Brownian.
+    };
+
+    /**
+     * @brief Callback that produces a displacement for @c StepType::Specified particles.
+     *
+     * Receives the particle index, the step index, the particle's position before the step
+     * and that particle's RNG; returns the proposed displacement (reflections are applied
+     * afterwards). With n_threads > 1 it is invoked concurrently for different particles.
+     */
+    using SpecifiedCallback =
+        std::function<Vec2(std::size_t particle_index,
+                           std::size_t step_index,
+                           const Vec2& position,
+                           RNG& rng)>;
+
+    /**
+     * @brief One sub-batch of particles handed to a step policy.
+     *
+     * The policy writes dx[j], dy[j] for store entry first + j, j < count, at step index 'step'.
+     * While a run is grouped (BasicSimulation::run_grouped()) the store is reordered; callbacks
+     * must then be given particle(j), the caller's original particle index.
+     */
+    struct StepBatch {
+        std::size_t           first{0};         ///< Store index of the first particle in the batch.
+        std::size_t           count{0};         ///< Number of particles (<= kStepBatch).
+        std::size_t           step{0};          ///< Step index k.
+        const BrownianCoeffs* shared{nullptr};  ///< Coefficients shared by every particle, or nullptr.
+        const std::size_t*    index{nullptr};   ///< Original particle index per entry, or nullptr (identity).
+        double*               dx{nullptr};      ///< [out] Displacement x-components, length count.
+        double*               dy{nullptr};      ///< [out] Displacement y-components, length count.
+
+        /// Caller-visible particle index of batch entry j.
+        std::size_t particle(std::size_t j) const noexcept { return index ? index[j] : first + j; }
+    };
+
+    /// Particles per step-policy sub-batch (policy scratch lives on the stack).
+    constexpr std::size_t kStepBatch = 256;
+
+    namespace detail {
+        /// Brownian displacements for a batch from pre-drawn normals (shared or per-particle params).
+        template <class Store>
+        inline void brownian_batch(const Store& s, const StepBatch& b, const double* gx, const double* gy) {
+            if (b.shared) {
+                brownian_fill(*b.shared, b.count, gx, gy, b.dx, b.dy);
+            } else {
+                brownian_fill(b.count, s.dt.data() + b.first, s.D.data() + b.first,
+                              s.mu_x.data() + b.first, s.mu_y.data() + b.first,
+                              gx, gy, b.dx, b.dy);
+            }
+        }
+    } // namespace detail
+
+    // ===============================
+    // Step policies
+    // ===============================
+
+    /// Every particle takes a Brownian step (step_type column is ignored).
+    struct BrownianStep {
+        template <class Store>
+        void operator()(Store& s, const StepBatch& b) const {
+            alignas(64) double gx[kStepBatch];
+            alignas(64) double gy[kStepBatch];
+            for (std::size_t j = 0; j < b.count; ++j) {
+                auto& rng = s.rng[b.first + j];
+                rng.seek_step(b.step);
+                gx[j] = rng.gauss();    // x then y, same order as brownian_step()
+                gy[j] = rng.gauss();
+            }
+            detail::brownian_batch(s, b, gx, gy);
+        }
+    };
+
+    /// Every particle takes specified_step() with its SpecifiedStepParams (requires Rng = RNG).
+    struct SpecifiedParamsStep {
+        template <class Store>
+        void operator()(Store& s, const StepBatch& b) const {
+            for (std::size_t j = 0; j < b.count; ++j) {
+                const std::size_t i = b.first + j;
+                s.rng[i].seek_step(b.step);
+                const Vec2 d = specified_step(s.spec[i], b.step, s.position(i), s.rng[i]);
+                b.dx[j] = d.x;
+                b.dy[j] = d.y;
+            }
+        }
+    };
+
+    /**
+     * @brief Every particle calls @p Fn as fn(i, k, position, rng) -> Vec2.
+     *
+     * With a lambda or function object the call inlines; with SpecifiedCallback it stays
+     * type-erased but the per-particle switch is still gone.
+     */
+    template <class Fn>
+    struct CallbackStep {
+        Fn fn;
+
+        template <class Store>
+        void operator()(Store& s, const StepBatch& b) const {
+            for (std::size_t j = 0; j < b.count; ++j) {
+                const std::size_t i = b.first + j;
+                s.rng[i].seek_step(b.step);
+                const Vec2 d = fn(b.particle(j), b.step, s.position(i), s.rng[i]);
+                b.dx[j] = d.x;
+                b.dy[j] = d.y;
+            }
+        }
+    };
+
+    template <class Fn>
+    CallbackStep<Fn> make_callback_step(Fn fn) { return CallbackStep<Fn>{std::move(fn)}; }
+
+    /**
+     * @brief Runtime dispatch on each particle's StepType (the original Simulation behavior).
+     *
+     * Brownian particles use the batched kernel; Specified particles use 'callback' if set,
+     * else specified_step() with their SpecifiedStepParams. Requires Rng = RNG.
+     */
+    struct MixedStep {
+        SpecifiedCallback callback{};   ///< Optional callback for StepType::Specified.
+
+        template <class Store>
+        void operator()(Store& s, const StepBatch& b) const {
+            alignas(64) double gx[kStepBatch];
+            alignas(64) double gy[kStepBatch];
+
+            // 1. Position counter-based streams at step k (no-op for MT19937), then draw
+            //    normals for Brownian particles (x then y, same order as brownian_step).
+            for (std::size_t j = 0; j < b.count; ++j) {
+                auto& rng = s.rng[b.first + j];
+                rng.seek_step(b.step);
+                if (s.step_type[b.first + j] == StepType::Brownian) {
+                    gx[j] = rng.gauss();
+                    gy[j] = rng.gauss();
+                } else {
+                    gx[j] = 0.0;
+                    gy[j] = 0.0;
+                }
+            }
+
+            // 2. Batched Brownian displacements for the whole sub-batch.
+            detail::brownian_batch(s, b, gx, gy);
+
+            // 3. Specified particles overwrite theirs (callback, else SpecifiedStepParams).
+            for (std::size_t j = 0; j < b.count; ++j) {
+                const std::size_t i = b.first + j;
+                switch (s.step_type[i]) {
+                    case StepType::Brownian:
+                        break;
+                    case StepType::Specified: {
+                        const Vec2 p = s.position(i);
+                        const Vec2 d = callback
+                            ? callback(b.particle(j), b.step, p, s.rng[i])
+                            : specified_step(s.spec[i], b.step, p, s.rng[i]);
+                        b.dx[j] = d.x;
+                        b.dy[j] = d.y;
+                        break;
+                    }
+                    default:
+                        assert(false && "run: unknown StepType");
+                        break;
+                }
+            }
+        }
+    };
+
+    // ===============================
+    // World and RNG hooks
+    // ===============================
+
+    /// Apply displacement @p d in an analytic (or any other) world; no clearance cache needed.
+    template <class World>
+    inline void world_advance(const World& world, Vec2& p, const Vec2& d,
+                              double& /*clearance*/, bool /*use_clearance*/) {
+        advance_with_reflections(p, d, world);
+    }
+
+    /// Generic segment world: optionally skip the full scan for interior steps (clearance cache).
+    inline void world_advance(const ReflectingWorld& world, Vec2& p, const Vec2& d,
+                              double& clearance, bool use_clearance) {
+        if (use_clearance && !world.has_index()) {
+            advance_with_clearance(p, d, world, clearance);
+        } else {
+            advance_with_reflections(p, d, world);
+        }
+    }
+
+    /// Whether @p world has absorbing walls; analytic worlds only reflect.
+    template <class World>
+    inline bool world_absorbs(const World& /*world*/) { return false; }
+
+    inline bool world_absorbs(const ReflectingWorld& world) { return world.has_absorbing(); }
+
+    /// Apply @p d up to the first absorbing wall hit (see advance_to_absorbing()); d = 0 if none.
+    template <class World>
+    inline WallContact world_advance_absorbing(const World& world, Vec2& p, Vec2& d,
+                                               double& clearance, bool use_clearance) {
+        world_advance(world, p, d, clearance, use_clearance);
+        d = Vec2{0.0, 0.0};
+        return WallContact{};
+    }
+
+    inline WallContact world_advance_absorbing(const ReflectingWorld& world, Vec2& p, Vec2& d,
+                                               double& clearance, bool use_clearance) {
+        return advance_to_absorbing(p, d, world, use_clearance && !world.has_index() ? &clearance : nullptr);
+    }
+
+    /**
+     * @brief Seed one sim::RNG per particle following cfg (engine, normal method, seeding policy).
+     * Defined in simulation.cpp; see SimulationConfig for the policy.
+     */
+    void seed_rngs(std::vector<RNG>& rngs, std::size_t n, const SimulationConfig& cfg);
+
+    /// Seed fixed-engine generators: Rng(key, first_particle + i), key = base_seed (or entropy).
+    template <class Rng>
+    void seed_rngs(std::vector<Rng>& rngs, std::size_t n, const SimulationConfig& cfg) {
+        std::uint64_t key = cfg.base_seed;
+        if (!cfg.deterministic) {
+            std::random_device rd;
+            key = (static_cast<std::uint64_t>(rd()) << 32) | rd();
+        }
+        rngs.clear();
+        rngs.reserve(n);
+        for (std::size_t i = 0; i < n; ++i) {
+            rngs.emplace_back(key, static_cast<std::uint64_t>(cfg.first_particle + i));
+        }
+    }
+
+    // ===============================
+    // BasicSimulation
+    // ===============================
+
+    /**
+     * @brief Simulation core with compile-time step, geometry and RNG policies.
+     *
+     * @tparam Step  Step policy (see file notes).
+     * @tparam World Geometry type with an advance_with_reflections() overload (not owned).
+     * @tparam Rng   Per-particle generator type.
+     *
+     * The step_type column and set_step_type*() are only consulted by policies that dispatch
+     * on them (MixedStep).
+     */
+    template <class Step, class World, class Rng = RNG>
+    class BasicSimulation {
+        public:
+            using step_policy_type = Step;
+            using world_type       = World;
+            using rng_type         = Rng;
+            using store_type       = BasicParticleStore<Rng>;
+
+            /**
+             * @brief Construct a simulation bound to a world.
+             * @param world Geometry (not owned; must outlive the simulation).
+             * @param cfg   Run configuration (copied).
+             * @param step  Step policy instance (copied).
+             * @post positions().size() == cfg.n_particles
+             * @post history().size()   == (cfg.record_history ? cfg.n_particles : 0)
+             */
+            BasicSimulation(const World& world, const SimulationConfig& cfg, Step step = Step{});
+
+            /// Delivers the frames a paused streamed run still buffers (sink errors are dropped).
+            ~BasicSimulation();
+            BasicSimulation(BasicSimulation&&) = default;
+            BasicSimulation& operator=(BasicSimulation&&) = default;
+
+            void set_step_type_all(StepType type);
+            void set_step_type(std::size_t i, StepType type);
+            void set_brownian_params(std::size_t i, const BrownianParams& p);
+            void set_specified_params(std::size_t i, const SpecifiedStepParams& p);
+            void set_specified_params_all(const SpecifiedStepParams& p);
+
+            /**
+             * @brief Give particles [first, first + count) the RNG streams that particles
+             *        [stream, stream + count) get from seed_rngs() with this config.
+             *
+             * Independent jobs packed into one population (e.g. sweep rows that each start at
+             * particle 0) keep the random numbers they would draw in a simulation of their own.
+             */
+            void assign_streams(std::size_t first, std::size_t count, std::size_t stream);
+
+            /// Initialize all particle positions; resets history frame 0 when recording.
+            void set_positions(const std::vector<Vec2>& positions);
+
+            /// Initialize one particle position before stepping (overwrites its frame 0).
+            void set_position(std::size_t i, const Vec2& p);
+
+            /**
+             * @brief Stream recorded frames to @p sink (not owned) instead of history().
+             *
+             * With a sink, history() stays empty; the next run() starts the stream with frame 0
+             * (current positions) and later runs continue it. Frames are buffered in blocks of
+             * about cfg.history_buffer_bytes / 2 and written on a background thread while the
+             * next block is computed. Passing nullptr restores the in-memory history (frame 0 =
+             * current positions). Ignored when cfg.record_history is false.
+             *
+             * @param first_frame Frames the sink already holds: continues a stream after
+             *                    load_checkpoint() (pass streamed_frames(); frame 0 is not resent).
+             */
+            void set_history_sink(HistorySink* sink, std::size_t first_frame = 0);
+
+            /**
+             * @brief Attach @p observer (not owned) to every following run().
+             *
+             * Its output 0 is the positions at the start of the next run(); later outputs follow
+             * every observer->every() steps (observers.hpp). Independent of record_history.
+             * Not while a run is paused (run_position() > 0).
+             */
+            void add_observer(PositionObserver* observer);
+
+            /// Detach all observers.
+            void clear_observers() noexcept { observers_.clear(); obs_outputs_.clear(); }
+
+            /// run_with() / run_grouped() stop value: finish the current run.
+            static constexpr std::size_t kRunEnd = static_cast<std::size_t>(-1);
+
+            /// Run config().n_steps steps (or the rest of a run in progress) with the stored step policy.
+            void run() { run_with(step_); }
+
+            /**
+             * @brief Advance the current run to its step @p step with the stored step policy;
+             *        reaching n_steps completes the run.
+             * @throws std::out_of_range unless run_position() < step <= config().n_steps.
+             */
+            void run_until(std::size_t step) { run_with(step_, step); }
+
+            /// Advance @p k steps with the stored policy, completing runs and starting new ones as needed.
+            void run_steps(std::size_t k);
+
+            /**
+             * @brief Run config().n_steps steps with another step policy over the same state.
+             *
+             * Lets a runtime facade pick a specialized policy (e.g. BrownianStep when every
+             * particle is Brownian) without copying the particle state.
+             *
+             * @param until Step of the current run to stop at (see run_until()); kRunEnd = n_steps.
+             * @throws std::out_of_range for an @p until that run_until() rejects.
+             */
+            template <class S>
+            void run_with(const S& step, std::size_t until = kRunEnd);
+
+            /**
+             * @brief Run with particles grouped by step model; each group uses a homogeneous policy.
+             *
+             * Brownian particles run with @p brownian, split further by identical BrownianParams
+             * (hoisted coefficients) when groups average at least kMinParamGroup particles;
+             * Specified particles run with @p specified. The store and history are reordered
+             * for the run and restored afterwards (also if a policy throws), so positions() and
+             * history() keep the caller's particle order. Results equal run_with(MixedStep).
+             */
+            template <class B, class Sp>
+            void run_grouped(const B& brownian, const Sp& specified, std::size_t until = kRunEnd);
+
+            /// Smallest average Brownian group size for which run_grouped() splits by params.
+            static constexpr std::size_t kMinParamGroup = 64;
+
+            /**
+             * @brief Write the complete state to @p path (replaced atomically).
+             *
+             * Between runs, or from inside run() at a checkpoint_every boundary. Every attached
+             * observer must support save_state(). Throws std::runtime_error on I/O errors.
+             */
+            void save_checkpoint(const std::string& path) const;
+
+            /**
+             * @brief Restore a save_checkpoint() state; the next run() finishes an interrupted run.
+             *
+             * The simulation must have the same world, step policy and observers (in the same
+             * order) and a config with the same n_particles, n_steps, store_every,
+             * record_history, rng_engine and normal_method; std::runtime_error otherwise, or if
+             * the file is unreadable. A streamed history continues once the sink is reattached
+             * with set_history_sink(sink, streamed_frames()).
+             */
+            void load_checkpoint(const std::string& path);
+
+            // ---- Accessors ----
+            PositionsView positions() const noexcept { return store_.positions(); }
+            const store_type& particles() const noexcept { return store_; }
+            const std::vector<std::vector<Vec2>>& history() const noexcept { return hist_; }
+            HistorySink* history_sink() const noexcept { return sink_; }
+            const std::vector<PositionObserver*>& observers() const noexcept { return observers_; }
+            const SimulationConfig& config() const noexcept { return cfg_; }
+
+            /// Steps completed by earlier run() calls (exit_step values count from the first run).
+            std::size_t steps_done() const noexcept { return steps_done_; }
+
+            /// Steps of the current run already done (run_until(), load_checkpoint()); 0 between runs.
+            std::size_t run_position() const noexcept { return run_pos_; }
+
+            /// Frames delivered to the history sink so far (including frame 0; a paused run may buffer more).
+            std::size_t streamed_frames() const noexcept { return sink_frames_; }
+
+            /// Particles absorbed so far (particles().alive[i] == 0).
+            std::size_t n_absorbed() const noexcept {
+                return static_cast<std::size_t>(std::count(store_.alive.begin(), store_.alive.end(), std::uint8_t{0}));
+            }
+            const World& world() const noexcept { return *world_; }
+            Step& step_policy() noexcept { return step_; }
+            const Step& step_policy() const noexcept { return step_; }
+
+        private:
+            /// Clear history and record frame 0 from the current positions.
+            void reset_history();
+
+            /**
+             * @brief Per-segment setup up to step @p until of the run (history frame 0, clearance
+             *        reset, store order of a paused run, observers); false if there is nothing to run.
+             */
+            bool begin_run(std::size_t until);
+
+            /// Per-segment teardown: pause at run_stop_ or complete the run (caller's order restored).
+            void end_segment();
+
+            /// Per-run teardown after the steps completed (observers merge their slots).
+            void end_run();
+
+            /// Automatic checkpoint after step @p k of the run: observers merge and reopen, then save.
+            void checkpoint_run(std::size_t k);
+
+            /// Put the store and history back in the caller's particle order (undo index_).
+            void restore_order();
+
+            /// Exchange store entries @p a and @p b together with their history and index_ entries.
+            void swap_particles(std::size_t a, std::size_t b);
+
+            /// Move retired particles of [lo, hi) to its end; returns the end of the active prefix.
+            std::size_t compact_alive(std::size_t lo, std::size_t hi);
+
+            /// True when recorded frames go to sink_ rather than hist_.
+            bool streaming() const noexcept { return cfg_.record_history && sink_ != nullptr; }
+
+            /// Hand the buffered frames of stream_ to the sink and wait until it has stored them.
+            void flush_stream() const;
+
+            /// run_grouped(): order the store by group and fill group_bounds_ / group_split_.
+            void group_store();
+
+            /**
+             * @brief Call advance(k0, k1) over consecutive step ranges covering [run_pos_, run_stop_).
+             *
+             * In memory: one call for all steps. Streaming: ranges are cut so their frames fit
+             * the fill buffer of stream_ (created by the run's first segment), which is submitted
+             * when full and at the end of the run. Ranges also end at checkpoint_every
+             * boundaries, where a checkpoint is written.
+             */
+            template <class F>
+            void drive_steps(F&& advance);
+
+            /// Advance store entries [lo, hi) through steps [k0, k1), split across the thread pool.
+            template <class S>
+            void run_range(const S& step, std::size_t lo, std::size_t hi, const BrownianCoeffs* shared,
+                           std::size_t k0, std::size_t k1);
+
+            /// Advance particles [lo, hi) through steps [k0, k1) following cfg_.loop_order (worker @p slot).
+            template <class S>
+            void advance_range(const S& step, std::size_t lo, std::size_t hi, const BrownianCoeffs* shared,
+                               std::size_t k0, std::size_t k1, std::size_t slot);
+
+            /// Step-major kernel: for each step in [k0, k1), advance particles [lo, hi), record their
+            /// history and hand them to the observers due at that step.
+            template <class S>
+            void advance_block(const S& step, std::size_t lo, std::size_t hi, const BrownianCoeffs* shared,
+                               std::size_t k0, std::size_t k1, std::size_t slot);
+
+            // Not owned; world geometry and reflection policy.
+            const World*                        world_;
+
+            // Effective configuration and step policy for this run.
+            SimulationConfig                    cfg_;
+            Step                                step_;
+
+            // State
+            store_type                          store_;             ///< SoA per-particle state (positions, params, RNGs).
+            std::vector<std::vector<Vec2>>      hist_;              ///< Trajectories (optional; empty while streaming).
+
+            // Streaming history (set_history_sink)
+            /// Writer and fill buffer of a streamed run, kept across its run_until() segments.
+            struct HistoryStream {
+                HistoryStream(HistorySink& sink, std::size_t n, std::size_t frames) : writer(sink, n, frames) {}
+                HistoryWriter writer;
+                std::size_t   used{0};      ///< Frames in the fill buffer.
+            };
+            HistorySink*                        sink_{nullptr};     ///< Not owned; nullptr = in-memory hist_.
+            mutable std::size_t                 sink_frames_{0};    ///< Frames already delivered to sink_ (save_checkpoint() delivers buffered ones).
+            std::unique_ptr<HistoryStream>      stream_;            ///< Streamed run in progress; nullptr between runs.
+            double*                             rec_x_{nullptr};    ///< Fill buffer of the active writer (during run()).
+            double*                             rec_y_{nullptr};
+            std::size_t                         rec_base_{0};       ///< Step k records into buffer frame (k+1)/store_every - rec_base_.
+
+            // Observers (add_observer)
+            std::vector<PositionObserver*>      observers_;         ///< Not owned.
+            std::vector<std::size_t>            obs_outputs_;       ///< Outputs delivered to each observer by completed runs.
+            std::vector<std::size_t>            obs_base_;          ///< This run: step k is output obs_base_ + (k+1)/every - 1.
+
+            // Absorbing walls (set by begin_run)
+            bool                                absorbing_{false};  ///< world_absorbs(world): trace to absorbing contacts.
+            bool                                retiring_{false};   ///< Some particles may be retired: keep them out of the step loop.
+            std::size_t                         steps_done_{0};     ///< Steps completed by earlier runs.
+
+            // Segments (run_until) and resumed runs
+            std::size_t                         run_pos_{0};        ///< Steps of the current run already done.
+            std::size_t                         run_stop_{0};       ///< Step the current segment ends at.
+            std::vector<std::size_t>            run_order_;         ///< index_ of a paused run; reapplied by the next segment.
+            std::vector<std::size_t>            group_bounds_;      ///< run_grouped() of a paused run: group starts, then n_brownian; empty = none.
+            bool                                group_split_{false}; ///< Brownian groups split by params (hoisted coefficients).
+
+            // Execution
+            std::unique_ptr<ThreadPool>         pool_;              ///< Lazily created when n_threads > 1.
+            std::vector<std::size_t>            index_;             ///< Original particle index per store entry while reordered (grouped or retiring); else empty.
+    };
+
+    // ===============================
+    // BasicSimulation implementation
+    // ===============================
+
+    template <class Step, class World, class Rng>
+    BasicSimulation<Step, World, Rng>::BasicSimulation(const World& world, const SimulationConfig& cfg, Step step)
+        : world_(&world), cfg_(cfg), step_(std::move(step))
+    {
+        const std::size_t n = cfg_.n_particles;
+
+        // Basic config sanity (debug-only)
+        assert(cfg_.store_every >= 1 && "SimulationConfig::store_every must be >= 1");
+        assert(cfg_.tile_size >= 1 && "SimulationConfig::tile_size must be >= 1");
+
+        // ---- Initialize particle state ----
+        // Positions start at the origin unless the caller overrides via set_positions(s).
+        // Step types default to Brownian; Brownian columns start from config defaults and
+        // specified-step params are default-constructed. Callers may override per particle.
+        store_.resize(n, cfg_.brownian);
+
+        // ---- RNG setup ---- (one generator per particle; policy in seed_rngs())
+        seed_rngs(store_.rng, n, cfg_);
+
+        // ---- History containers ----
+        if (cfg_.record_history) {
+            reset_history();
+        }
+
+        #ifndef NDEBUG
+            // Invariants: all per-particle columns must have the same size.
+            const bool sizes_ok =
+                store_.y.size()         == n &&
+                store_.step_type.size() == n &&
+                store_.dt.size()        == n &&
+                store_.rng.size()       == n &&
+                store_.clearance.size() == n &&
+                (!cfg_.record_history || hist_.size() == n);
+            assert(sizes_ok && "Per-particle containers must be the same length.");
+        #endif
+    }
+
+    template <class Step, class World, class Rng>
+    BasicSimulation<Step, World, Rng>::~BasicSimulation() {
+        if (!stream_) return;
+        try {
+            flush_stream();
+        } catch (...) {
+            // Like ~HistoryWriter(): a destructor has nowhere to report a sink error.
+        }
+    }
+
+    template <class Step, class World, class Rng>
+    void BasicSimulation<Step, World, Rng>::reset_history() {
+        const std::size_t n = store_.size();
+        hist_.assign(n, {});
+
+        // Record initial positions (time index 0) unconditionally; run() reserves the frames
+        // it is about to append, so nothing is reserved for a sink that is attached later.
+        for (std::size_t i = 0; i < n; ++i) {
+            hist_[i].push_back(store_.position(i));
+        }
+    }
+
+    template <class Step, class World, class Rng>
+    void BasicSimulation<Step, World, Rng>::set_step_type_all(StepType type) {
+        // Assign the same step model to every particle. O(n_particles).
+        for (auto& t : store_.step_type) {
+            t = type;
+        }
+        group_bounds_.clear();
+    }
+
+    template <class Step, class World, class Rng>
+    void BasicSimulation<Step, World, Rng>::set_step_type(std::size_t i, StepType type) {
+        assert(i < store_.size() && "set_step_type: particle index out of range");
+        store_.step_type[i] = type;
+        group_bounds_.clear();
+    }
+
+    template <class Step, class World, class Rng>
+    void BasicSimulation<Step, World, Rng>::set_brownian_params(std::size_t i, const BrownianParams& p) {
+        assert(i < store_.size() && "set_brownian_params: particle index out of range");
+        store_.set_brownian(i, p);
+        group_bounds_.clear();
+    }
+
+    template <class Step, class World, class Rng>
+    void BasicSimulation<Step, World, Rng>::assign_streams(std::size_t first, std::size_t count, std::size_t stream) {
+        assert(first + count <= store_.size() && "assign_streams: particle range out of range");
+        SimulationConfig c = cfg_;
+        c.first_particle = stream;
+        std::vector<Rng> rngs;
+        seed_rngs(rngs, count, c);
+        std::move(rngs.begin(), rngs.end(), store_.rng.begin() + static_cast<std::ptrdiff_t>(first));
+    }
+
+    template <class Step, class World, class Rng>
+    void BasicSimulation<Step, World, Rng>::set_specified_params(std::size_t i, const SpecifiedStepParams& p) {
+        assert(i < store_.size() && "set_specified_params: particle index out of range");
+        store_.spec[i] = p;
+    }
+
+    template <class Step, class World, class Rng>
+    void BasicSimulation<Step, World, Rng>::set_specified_params_all(const SpecifiedStepParams& p) {
+        // Broadcast the same specified-step params to all particles. O(n_particles)
+        for (auto& sp : store_.spec) {
+            sp = p;
+        }
+    }
+
+    template <class Step, class World, class Rng>
+    void BasicSimulation<Step, World, Rng>::set_positions(const std::vector<Vec2>& positions) {
+        assert(positions.size() == store_.size() && "set_positions: size mismatch with n_particles");
+        for (std::size_t i = 0; i < positions.size(); ++i) {
+            store_.set_position(i, positions[i]);
+        }
+
+        // If recording in memory, reset history to start from these positions (time index 0).
+        if (cfg_.record_history && !sink_) {
+            reset_history();
+        }
+    }
+
+    template <class Step, class World, class Rng>
+    void BasicSimulation<Step, World, Rng>::set_position(std::size_t i, const Vec2& p) {
+        assert(i < store_.size() && "set_position: particle index out of range");
+        store_.set_position(i, p);
+
+        if (cfg_.record_history && !sink_) {
+            // Ensure history exists; this keeps the "frame 0 = initial positions" contract.
+            if (hist_.empty()) {
+                hist_.assign(store_.size(), {});
+            } else {
+    #ifndef NDEBUG
+                // If any particle already has >1 frames, likely started stepping-change frame 0
+                // would desync the timeline. Encourage using set_positions() or a dedicated reset().
+                for (const auto& h : hist_) {
+                    assert(h.size() <= 1 && "set_position: called after stepping; use set_positions() or reset()");
+                }
+    #endif
+                assert(hist_.size() == store_.size() && "set_position: history size must match n_particles");
+            }
+
+            // Keep consistent: ensure/overwrite the initial frame for particle i.
+            if (hist_[i].empty()) {
+                hist_[i].push_back(p);
+            } else {
+                hist_[i][0] = p;
+            }
+        }
+    }
+
+    template <class Step, class World, class Rng>
+    void BasicSimulation<Step, World, Rng>::set_history_sink(HistorySink* sink, std::size_t first_frame) {
+        // Frames a paused run still buffers belong to the old sink.
+        if (stream_) {
+            flush_stream();
+            stream_.reset();
+        }
+        sink_ = sink;
+        sink_frames_ = first_frame;
+        hist_.clear();
+        hist_.shrink_to_fit();
+        if (cfg_.record_history && !sink_) {
+            reset_history();
+        }
+    }
+
+    template <class Step, class World, class Rng>
+    void BasicSimulation<Step, World, Rng>::add_observer(PositionObserver* observer) {
+        assert(observer != nullptr && observer->every() >= 1 && "add_observer: need an observer with every() >= 1");
+        assert(run_pos_ == 0 && "add_observer: not while a run is paused between run_until() segments");
+        observers_.push_back(observer);
+        obs_outputs_.push_back(0);
+    }
+
+    template <class Step, class World, class Rng>
+    void BasicSimulation<Step, World, Rng>::run_steps(std::size_t k) {
+        if (store_.size() == 0 || cfg_.n_steps == 0) return;
+        while (k > 0) {
+            const std::size_t take = std::min(k, cfg_.n_steps - run_pos_);
+            run_until(run_pos_ + take);
+            k -= take;
+        }
+    }
+
+    template <class Step, class World, class Rng>
+    bool BasicSimulation<Step, World, Rng>::begin_run(std::size_t until) {
+        if (until != kRunEnd && (until <= run_pos_ || until > cfg_.n_steps)) {
+            throw std::out_of_range("run_until: need run_position() < step <= n_steps, got step " +
+                                    std::to_string(until) + " at position " + std::to_string(run_pos_) +
+                                    " of " + std::to_string(cfg_.n_steps));
+        }
+        const std::size_t n = store_.size();
+        if (n == 0 || cfg_.n_steps == 0) return false;
+        run_stop_ = until == kRunEnd ? cfg_.n_steps : until;
+
+        assert(world_ != nullptr && "run: world_ must be set");
+    #ifndef NDEBUG
+        // Sanity: per-particle containers must align; history stride must be valid.
+        assert(store_.step_type.size() == n && "run: step_type column size mismatch");
+        assert(store_.dt.size()        == n && "run: Brownian param columns size mismatch");
+        assert(store_.rng.size()       == n && "run: rng column size mismatch");
+        assert(cfg_.store_every >= 1        && "run: store_every must be >=1");
+        assert(cfg_.tile_size >= 1          && "run: tile_size must be >=1");
+    #endif
+
+        // History setup (policy): frame 0 = initial positions; reserve the rest of the run's
+        // frames once, so later segments append without reallocating.
+        if (cfg_.record_history && !sink_) {
+            if (hist_.size() != n) reset_history();
+            const std::size_t frames = cfg_.n_steps / cfg_.store_every - run_pos_ / cfg_.store_every;
+            for (auto& h : hist_) h.reserve(h.size() + frames);
+        }
+
+        // Clearance cache: the world may have changed since the last run(), so start unknown.
+        // Segments of one run keep it (load_checkpoint() clears it for a resumed run).
+        if (run_pos_ == 0) std::fill(store_.clearance.begin(), store_.clearance.end(), 0.0);
+
+        // A paused run continues in the store order it had reached (same accumulation order).
+        if (!run_order_.empty()) {
+            store_.permute(run_order_);
+            if (!hist_.empty()) detail::permute_vector(hist_, run_order_);
+            index_ = std::move(run_order_);
+            run_order_.clear();
+        }
+
+        // Absorbing walls: retired particles get compacted per block, which reorders the store,
+        // so index_ tracks original indices for the rest of the run.
+        const std::size_t n_absorbed = this->n_absorbed();
+        absorbing_ = world_absorbs(*world_);
+        retiring_ = absorbing_ || n_absorbed > 0;
+        if (retiring_ && index_.empty()) {
+            index_.resize(n);
+            for (std::size_t i = 0; i < n; ++i) index_[i] = i;
+        }
+
+        // Observers: one slot per worker thread; output 0 (active positions) on the first run.
+        std::vector<double> ax, ay;
+        if (n_absorbed > 0 && !observers_.empty()) {
+            for (std::size_t i = 0; i < n; ++i) {
+                if (!store_.alive[i]) continue;
+                ax.push_back(store_.x[i]);
+                ay.push_back(store_.y[i]);
+            }
+        }
+        const double* const ox = n_absorbed > 0 ? ax.data() : store_.x.data();
+        const double* const oy = n_absorbed > 0 ? ay.data() : store_.y.data();
+        const std::size_t slots = resolve_thread_count(cfg_.n_threads, n);
+        obs_base_.resize(observers_.size());
+        for (std::size_t j = 0; j < observers_.size(); ++j) {
+            PositionObserver& o = *observers_[j];
+            if (run_pos_ > 0) {
+                // Later segment: outputs up to run_pos_ were merged by the previous one.
+                const std::size_t m = o.every();
+                o.begin(slots, obs_base_[j] + run_pos_ / m, run_stop_ / m - run_pos_ / m);
+                continue;
+            }
+            const std::size_t initial = obs_outputs_[j] == 0 ? 1 : 0;
+            o.begin(slots, obs_outputs_[j], initial + run_stop_ / o.every());
+            if (initial) o.observe(0, 0, ox, oy, n - n_absorbed);
+            obs_base_[j] = obs_outputs_[j] + initial;
+        }
+        return true;
+    }
+
+    template <class Step, class World, class Rng>
+    void BasicSimulation<Step, World, Rng>::end_segment() {
+        if (run_stop_ == cfg_.n_steps) {
+            restore_order();
+            end_run();
+            return;
+        }
+        // Pause: observers merge, the caller's order is restored and the run order kept.
+        for (PositionObserver* o : observers_) o->end();
+        run_order_ = index_;
+        restore_order();
+        run_pos_ = run_stop_;
+    }
+
+    template <class Step, class World, class Rng>
+    void BasicSimulation<Step, World, Rng>::end_run() {
+        for (std::size_t j = 0; j < observers_.size(); ++j) {
+            observers_[j]->end();
+            obs_outputs_[j] = obs_base_[j] + cfg_.n_steps / observers_[j]->every();
+        }
+        steps_done_ += cfg_.n_steps;
+        run_pos_ = 0;
+        group_bounds_.clear();
+    }
+
+    template <class Step, class World, class Rng>
+    void BasicSimulation<Step, World, Rng>::checkpoint_run(std::size_t k) {
+        // Observers merge the outputs seen so far (all of them complete: an output belongs to a
+        // single step) and reopen for the rest, so save_state() has everything up to step k.
+        const std::size_t slots = resolve_thread_count(cfg_.n_threads, store_.size());
+        for (std::size_t j = 0; j < observers_.size(); ++j) {
+            PositionObserver& o = *observers_[j];
+            const std::size_t m = o.every();
+            o.end();
+            o.begin(slots, obs_base_[j] + k / m, run_stop_ / m - k / m);
+        }
+        run_pos_ = k;
+        save_checkpoint(cfg_.checkpoint_path);
+    }
+
+    template <class Step, class World, class Rng>
+    void BasicSimulation<Step, World, Rng>::save_checkpoint(const std::string& path) const {
+        const std::size_t n = store_.size();
+
+        // The checkpoint counts only frames the sink has stored.
+        if (stream_) flush_stream();
+
+        // Store entry holding particle o (the store is reordered while a run is in progress).
+        std::vector<std::size_t> entry(n);
+        for (std::size_t e = 0; e < n; ++e) entry[index_.empty() ? e : index_[e]] = e;
+        const auto column = [&](std::ostream& os, const auto& col) {
+            std::vector<typename std::decay_t<decltype(col)>::value_type> out(n);
+            for (std::size_t o = 0; o < n; ++o) out[o] = col[entry[o]];
+            detail::write_vector(os, out);
+        };
+
+        write_file_atomically(path, [&](std::ostream& os) {
+            write_checkpoint_header(os);
+
+            // Config fingerprint (checked by load_checkpoint()).
+            detail::write_pod<std::uint64_t>(os, n);
+            detail::write_pod<std::uint64_t>(os, cfg_.n_steps);
+            detail::write_pod<std::uint64_t>(os, cfg_.store_every);
+            detail::write_pod<std::uint8_t>(os, cfg_.record_history ? 1 : 0);
+            detail::write_pod<std::uint32_t>(os, static_cast<std::uint32_t>(cfg_.rng_engine));
+            detail::write_pod<std::uint32_t>(os, static_cast<std::uint32_t>(cfg_.normal_method));
+
+            // Progress.
+            detail::write_pod<std::uint64_t>(os, steps_done_);
+            detail::write_pod<std::uint64_t>(os, run_pos_);
+            detail::write_pod<std::uint64_t>(os, sink_frames_);
+
+            // Store order of the run in progress (the next segment continues in it, so
+            // observers accumulate in the same order as without the interruption).
+            detail::write_vector(os, index_.empty() ? run_order_ : index_);
+
+            // Particles, in the caller's order.
+            column(os, store_.x);
+            column(os, store_.y);
+            column(os, store_.step_type);
+            column(os, store_.dt);
+            column(os, store_.D);
+            column(os, store_.mu_x);
+            column(os, store_.mu_y);
+            column(os, store_.spec);
+            column(os, store_.alive);
+            column(os, store_.exit_step);
+            column(os, store_.exit_wall);
+            for (std::size_t o = 0; o < n; ++o) store_.rng[entry[o]].save(os);
+
+            // In-memory history (empty while streaming).
+            detail::write_pod<std::uint8_t>(os, hist_.empty() ? 0 : 1);
+            if (!hist_.empty()) {
+                for (std::size_t o = 0; o < n; ++o) detail::write_vector(os, hist_[entry[o]]);
+            }
+
+            // Observers, in attach order.
+            detail::write_pod<std::uint64_t>(os, observers_.size());
+            for (std::size_t j = 0; j < observers_.size(); ++j) {
+                detail::write_pod<std::uint64_t>(os, obs_outputs_[j]);
+                detail::write_pod<std::uint64_t>(os, j < obs_base_.size() ? obs_base_[j] : obs_outputs_[j]);
+                observers_[j]->save_state(os);
+            }
+        });
+    }
+
+    template <class Step, class World, class Rng>
+    void BasicSimulation<Step, World, Rng>::load_checkpoint(const std::string& path) {
+        std::ifstream is(path, std::ios::binary);
+        if (!is) throw std::runtime_error("load_checkpoint: cannot open " + path);
+        read_checkpoint_header(is);
+
+        const std::size_t n = store_.size();
+        const bool same_config =
+            detail::read_pod<std::uint64_t>(is) == n &&
+            detail::read_pod<std::uint64_t>(is) == cfg_.n_steps &&
+            detail::read_pod<std::uint64_t>(is) == cfg_.store_every &&
+            detail::read_pod<std::uint8_t>(is) == (cfg_.record_history ? 1 : 0) &&
+            detail::read_pod<std::uint32_t>(is) == static_cast<std::uint32_t>(cfg_.rng_engine) &&
+            detail::read_pod<std::uint32_t>(is) == static_cast<std::uint32_t>(cfg_.normal_method);
+        if (!same_config) {
+            throw std::runtime_error("load_checkpoint: " + path + " was written for a different configuration");
+        }
+        const auto steps_done = detail::read_pod<std::uint64_t>(is);
+        const auto run_pos = detail::read_pod<std::uint64_t>(is);
+        const auto sink_frames = detail::read_pod<std::uint64_t>(is);
+
+        // Read everything before touching the simulation.
+        std::vector<std::size_t> order;
+        detail::read_vector(is, order);
+        if (!order.empty()) {
+            std::vector<std::uint8_t> seen(n, 0);
+            for (std::size_t o : order) {
+                if (order.size() != n || o >= n || seen[o]++) {
+                    throw std::runtime_error("load_checkpoint: bad particle order in " + path);
+                }
+            }
+        }
+        store_type st;
+        const auto column = [&](auto& col) {
+            detail::read_vector(is, col);
+            if (col.size() != n) throw std::runtime_error("load_checkpoint: column size mismatch in " + path);
+        };
+        column(st.x);
+        column(st.y);
+        column(st.step_type);
+        column(st.dt);
+        column(st.D);
+        column(st.mu_x);
+        column(st.mu_y);
+        column(st.spec);
+        column(st.alive);
+        column(st.exit_step);
+        column(st.exit_wall);
+        st.clearance.assign(n, 0.0);
+        st.rng = store_.rng;
+        for (auto& r : st.rng) r.load(is);
+
+        std::vector<std::vector<Vec2>> hist;
+        if (detail::read_pod<std::uint8_t>(is) != 0) {
+            hist.resize(n);
+            for (auto& h : hist) detail::read_vector(is, h);
+        }
+
+        if (detail::read_pod<std::uint64_t>(is) != observers_.size()) {
+            throw std::runtime_error("load_checkpoint: " + path + " has a different number of observers");
+        }
+        std::vector<std::size_t> obs_outputs(observers_.size()), obs_base(observers_.size());
+        for (std::size_t j = 0; j < observers_.size(); ++j) {
+            obs_outputs[j] = static_cast<std::size_t>(detail::read_pod<std::uint64_t>(is));
+            obs_base[j] = static_cast<std::size_t>(detail::read_pod<std::uint64_t>(is));
+            observers_[j]->load_state(is);
+        }
+
+        stream_.reset();    // frames buffered by a paused run belong to the replaced state
+        store_ = std::move(st);
+        hist_ = std::move(hist);
+        index_.clear();
+        run_order_ = std::move(order);
+        group_bounds_.clear();
+        steps_done_ = static_cast<std::size_t>(steps_done);
+        run_pos_ = static_cast<std::size_t>(run_pos);
+        sink_frames_ = static_cast<std::size_t>(sink_frames);
+        obs_outputs_ = std::move(obs_outputs);
+        obs_base_ = std::move(obs_base);
+    }
+
+    template <class Step, class World, class Rng>
+    void BasicSimulation<Step, World, Rng>::restore_order() {
+        if (index_.empty()) return;
+        const std::size_t n = index_.size();
+        bool identity = true;
+        std::vector<std::size_t> inverse(n);
+        for (std::size_t k = 0; k < n; ++k) {
+            inverse[index_[k]] = k;
+            identity = identity && index_[k] == k;
+        }
+        if (!identity) {
+            store_.permute(inverse);
+            if (!hist_.empty()) detail::permute_vector(hist_, inverse);
+        }
+        index_.clear();
+    }
+
+    template <class Step, class World, class Rng>
+    void BasicSimulation<Step, World, Rng>::swap_particles(std::size_t a, std::size_t b) {
+        store_.swap_entries(a, b);
+        if (!hist_.empty()) hist_[a].swap(hist_[b]);
+        std::swap(index_[a], index_[b]);
+    }
+
+    template <class Step, class World, class Rng>
+    std::size_t BasicSimulation<Step, World, Rng>::compact_alive(std::size_t lo, std::size_t hi) {
+        // Unstable partition; index_ remembers where everyone came from.
+        while (lo < hi) {
+            if (store_.alive[lo]) {
+                ++lo;
+            } else {
+                swap_particles(lo, --hi);
+            }
+        }
+        return hi;
+    }
+
+    template <class Step, class World, class Rng>
+    template <class S>
+    void BasicSimulation<Step, World, Rng>::run_with(const S& step, std::size_t until) {
+        if (!begin_run(until)) return;
+        const std::size_t n = store_.size();
+        group_bounds_.clear();
+
+        // Brownian coefficients: if every particle shares one parameter set, hoist
+        // sqrt(2*D*dt) and mu*dt out of the step loop (homogeneous batched kernel).
+        bool uniform = true;
+        for (std::size_t i = 1; i < n && uniform; ++i) {
+            uniform = store_.dt[i]   == store_.dt[0]   && store_.D[i]    == store_.D[0] &&
+                      store_.mu_x[i] == store_.mu_x[0] && store_.mu_y[i] == store_.mu_y[0];
+        }
+        const BrownianCoeffs coeffs = brownian_coeffs(store_.brownian(0));
+        try {
+            drive_steps([&](std::size_t k0, std::size_t k1) {
+                run_range(step, 0, n, uniform ? &coeffs : nullptr, k0, k1);
+            });
+        } catch (...) {
+            restore_order();
+            throw;
+        }
+        end_segment();
+    }
+
+    template <class Step, class World, class Rng>
+    void BasicSimulation<Step, World, Rng>::group_store() {
+        const std::size_t n = store_.size();
+
+        // ---- Partition: Brownian first, then Specified ----
+        // Stable ordering keeps ascending particle index inside every group.
+        std::vector<std::size_t> order(n);
+        for (std::size_t i = 0; i < n; ++i) order[i] = i;
+        const auto partition = [&] {
+            return static_cast<std::size_t>(std::stable_partition(order.begin(), order.end(),
+                [this](std::size_t i) { return store_.step_type[i] == StepType::Brownian; }) - order.begin());
+        };
+        const std::size_t n_brownian = partition();
+
+        // Brownian params groups: [bounds[g], bounds[g+1]) share one BrownianParams. Splitting only
+        // pays off when groups are large enough to amortize the per-group dispatch.
+        const auto key = [this](std::size_t i) {
+            return std::make_tuple(store_.dt[i], store_.D[i], store_.mu_x[i], store_.mu_y[i]);
+        };
+        std::stable_sort(order.begin(), order.begin() + n_brownian,
+                         [&](std::size_t a, std::size_t b) { return key(a) < key(b); });
+        std::vector<std::size_t> bounds{0};
+        for (std::size_t k = 1; k < n_brownian; ++k) {
+            if (key(order[k]) != key(order[k - 1])) bounds.push_back(k);
+        }
+        const bool split = n_brownian > 0 &&
+                           (bounds.size() == 1 || n_brownian / bounds.size() >= kMinParamGroup);
+        if (!split) {
+            for (std::size_t i = 0; i < n; ++i) order[i] = i;
+            partition();
+            bounds.assign(1, 0);
+        }
+        bounds.push_back(n_brownian);
+        group_bounds_ = std::move(bounds);
+        group_split_ = split;
+
+        // ---- Reorder state (restore_order() undoes it via index_) ----
+        bool identity = true;
+        for (std::size_t k = 0; k < n && identity; ++k) identity = order[k] == k;
+        if (!identity) {
+            store_.permute(order);
+            if (!hist_.empty()) detail::permute_vector(hist_, order);
+            if (!index_.empty()) {
+                for (std::size_t& o : order) o = index_[o];     // compose with a resumed run's order
+            }
+            index_ = std::move(order);
+        }
+    }
+
+    template <class Step, class World, class Rng>
+    template <class B, class Sp>
+    void BasicSimulation<Step, World, Rng>::run_grouped(const B& brownian, const Sp& specified, std::size_t until) {
+        if (!begin_run(until)) return;
+        const std::size_t n = store_.size();
+
+        // A later segment continues in the store order begin_run() reapplied: same groups.
+        if (group_bounds_.empty()) group_store();
+        const std::vector<std::size_t>& bounds = group_bounds_;
+        const std::size_t n_brownian = bounds.back();
+        const bool split = group_split_;
+
+        try {
+            // Brownian groups: hoisted coefficients per params group, else per-particle columns.
+            drive_steps([&](std::size_t k0, std::size_t k1) {
+                for (std::size_t g = 0; g + 1 < bounds.size(); ++g) {
+                    const std::size_t lo = bounds[g], hi = bounds[g + 1];
+                    if (lo == hi) continue;
+                    const BrownianCoeffs coeffs = brownian_coeffs(store_.brownian(lo));
+                    run_range(brownian, lo, hi, split ? &coeffs : nullptr, k0, k1);
+                }
+                if (n_brownian < n) {
+                    run_range(specified, n_brownian, n, nullptr, k0, k1);
+                }
+            });
+        } catch (...) {
+            group_bounds_.clear();
+            restore_order();
+            throw;
+        }
+        end_segment();
+    }
+
+    template <class Step, class World, class Rng>
+    template <class F>
+    void BasicSimulation<Step, World, Rng>::drive_steps(F&& advance) {
+        const std::size_t n_steps = run_stop_;
+
+        // Checkpoints fall after every 'every' steps of the run (none after its last step).
+        const std::size_t every = cfg_.checkpoint_path.empty() ? 0 : cfg_.checkpoint_every;
+        const auto cut = [&](std::size_t k0, std::size_t k1) {
+            return every ? std::min(k1, (k0 / every + 1) * every) : k1;
+        };
+        const auto due = [&](std::size_t k) { return every && k % every == 0 && k < cfg_.n_steps; };
+
+        if (!streaming()) {
+            try {
+                for (std::size_t k0 = run_pos_; k0 < n_steps; ) {
+                    const std::size_t k1 = cut(k0, n_steps);
+                    advance(k0, k1);
+                    if (due(k1)) checkpoint_run(k1);
+                    k0 = k1;
+                }
+            } catch (...) {
+                run_pos_ = 0;
+                throw;
+            }
+            return;
+        }
+
+        // ---- Streaming: fill one buffer while the writer thread drains the other ----
+        const std::size_t n = store_.size();
+        const std::size_t stride = cfg_.store_every;
+        const auto detach = [&] { rec_x_ = rec_y_ = nullptr; };
+        try {
+            // The run's first segment opens the stream, sized for the rest of the run (+ frame 0);
+            // later segments keep filling the same buffer.
+            if (!stream_) {
+                const std::size_t frames = cfg_.n_steps / stride - run_pos_ / stride + 1;
+                stream_ = std::make_unique<HistoryStream>(
+                    *sink_, n, history_frames_per_buffer(cfg_.history_buffer_bytes, n, frames));
+
+                // Frame 0: initial positions, once per stream (caller's particle order).
+                if (sink_frames_ == 0) {
+                    sink_->begin(n, stride);
+                    for (std::size_t i = 0; i < n; ++i) {
+                        const std::size_t o = index_.empty() ? i : index_[i];
+                        stream_->writer.x()[o] = store_.x[i];
+                        stream_->writer.y()[o] = store_.y[i];
+                    }
+                    stream_->used = 1;
+                }
+            }
+            HistoryWriter& writer = stream_->writer;
+            std::size_t& used = stream_->used;     // frames in the fill buffer
+
+            // Step ranges start on a stride boundary and end when the buffer is full.
+            for (std::size_t k0 = run_pos_; k0 < n_steps; ) {
+                if (used == writer.capacity()) {
+                    writer.submit(sink_frames_, used);
+                    sink_frames_ += used;
+                    used = 0;
+                }
+                const std::size_t k1 = cut(k0, std::min(n_steps, k0 + (writer.capacity() - used) * stride));
+                rec_x_ = writer.x();
+                rec_y_ = writer.y();
+                rec_base_ = k0 / stride + 1 - used;
+                advance(k0, k1);
+                used += k1 / stride - k0 / stride;
+                k0 = k1;
+                if (due(k1)) {
+                    detach();
+                    checkpoint_run(k1);     // save_checkpoint() drains the buffer first
+                }
+            }
+            detach();
+            if (n_steps == cfg_.n_steps) {
+                flush_stream();
+                stream_.reset();
+            }
+        } catch (...) {
+            detach();
+            stream_.reset();
+            run_pos_ = 0;
+            throw;
+        }
+    }
+
+    template <class Step, class World, class Rng>
+    void BasicSimulation<Step, World, Rng>::flush_stream() const {
+        HistoryStream& s = *stream_;
+        s.writer.submit(sink_frames_, s.used);
+        sink_frames_ += s.used;
+        s.used = 0;
+        s.writer.finish();
+    }
+
+    template <class Step, class World, class Rng>
+    template <class S>
+    void BasicSimulation<Step, World, Rng>::run_range(const S& step, std::size_t lo, std::size_t hi,
+                                                      const BrownianCoeffs* shared,
+                                                      std::size_t k0, std::size_t k1) {
+        // ---- Execution: split particles into contiguous ranges, one per thread ----
+        // Particles are independent (own RNG, params, position, history), so the
+        // partitioning does not affect results; only the wall-clock time.
+        const std::size_t n_threads = resolve_thread_count(cfg_.n_threads, hi - lo);
+        if (n_threads <= 1) {
+            advance_range(step, lo, hi, shared, k0, k1, 0);
+            return;
+        }
+        if (!pool_ || pool_->size() != n_threads) {
+            pool_ = std::make_unique<ThreadPool>(n_threads);
+        }
+        pool_->parallel_for(hi - lo, [&, lo](std::size_t a, std::size_t b, std::size_t tid) {
+            advance_range(step, lo + a, lo + b, shared, k0, k1, tid);
+        });
+    }
+
+    template <class Step, class World, class Rng>
+    template <class S>
+    void BasicSimulation<Step, World, Rng>::advance_range(const S& step, std::size_t lo, std::size_t hi,
+                                                          const BrownianCoeffs* shared,
+                                                          std::size_t k0, std::size_t k1, std::size_t slot) {
+        if (cfg_.loop_order == LoopOrder::StepMajor) {
+            advance_block(step, lo, hi, shared, k0, k1, slot);
+            return;
+        }
+
+        // Particle-major: run each tile through the step range before touching the next one,
+        // so its RNG state, params, position and history tail stay cache-resident.
+        const std::size_t tile = std::max<std::size_t>(1, cfg_.tile_size);
+        for (std::size_t t = lo; t < hi; t += tile) {
+            advance_block(step, t, std::min(hi, t + tile), shared, k0, k1, slot);
+        }
+    }
+
+    template <class Step, class World, class Rng>
+    template <class S>
+    void BasicSimulation<Step, World, Rng>::advance_block(const S& step, std::size_t lo, std::size_t hi,
+                                                          const BrownianCoeffs* shared,
+                                                          std::size_t k0, std::size_t k1, std::size_t slot) {
+        const bool record = cfg_.record_history;
+        const bool use_clearance = cfg_.use_clearance;
+        const bool absorbing = absorbing_;
+        const std::size_t stride = cfg_.store_every; // record every 'stride' steps
+        const World& world = *world_;
+
+        // Column pointers (SoA): each loop touches only the fields it needs.
+        double* const       xs    = store_.x.data();
+        double* const       ys    = store_.y.data();
+        double* const       clear = store_.clearance.data();
+
+        // Scratch for one sub-batch of displacements.
+        alignas(64) double dx[kStepBatch];
+        alignas(64) double dy[kStepBatch];
+
+        StepBatch batch;
+        batch.shared = shared;
+        batch.dx = dx;
+        batch.dy = dy;
+
+        // Active particles are [lo, act); retired ones sit in [act, hi) at their exit points.
+        std::size_t act = retiring_ ? compact_alive(lo, hi) : hi;
+
+        // ---- Main integration loop ---
+        for (std::size_t k = k0; k < k1; ++k) {
+            batch.step = k;
+            std::size_t retired = 0;
+            for (std::size_t b = lo; b < act; b += kStepBatch) {
+                batch.first = b;
+                batch.count = std::min(act - b, kStepBatch);
+                batch.index = index_.empty() ? nullptr : index_.data() + b;
+
+                // 1. Step policy: proposed displacements for the sub-batch.
+                step(store_, batch);
+
+                // 2. HOT PATH: geometry policy (interior steps may skip the scan).
+                if (!absorbing) {
+                    for (std::size_t j = 0; j < batch.count; ++j) {
+                        const std::size_t i = b + j;
+                        Vec2 p{xs[i], ys[i]};
+                        world_advance(world, p, Vec2{dx[j], dy[j]}, clear[i], use_clearance);
+                        xs[i] = p.x;
+                        ys[i] = p.y;
+                    }
+                    continue;
+                }
+
+                // 2'. Absorbing walls: every hit may retire the particle, else it reflects on.
+                for (std::size_t j = 0; j < batch.count; ++j) {
+                    const std::size_t i = b + j;
+                    Vec2 p{xs[i], ys[i]};
+                    Vec2 d{dx[j], dy[j]};
+                    double done = 0.0;  // fraction of this step's path travelled
+                    bool absorbed = false;
+                    for (int c = 0; c < MAX_REFLECTIONS && !absorbed; ++c) {
+                        const WallContact hit = world_advance_absorbing(world, p, d, clear[i], use_clearance);
+                        if (hit.wall < 0) break;
+                        done += (1.0 - done) * hit.fraction;
+                        absorbed = hit.absorb >= 1.0 || store_.rng[i].uniform() < hit.absorb;
+                        if (absorbed) {
+                            store_.retire(i, hit.point, static_cast<double>(steps_done_ + k) + done, hit.id);
+                            ++retired;
+                        }
+                    }
+                    if (!absorbed) {
+                        xs[i] = p.x;
+                        ys[i] = p.y;
+                    }
+                }
+            }
+            if (retired > 0) act = compact_alive(lo, act);
+
+            // History policy: append positions every 'stride' steps (no forced final frame).
+            // Each range only touches its own particles' history vectors / buffer slots.
+            if (record && ((k+1) % stride == 0)) {
+                if (rec_x_) {
+                    const std::size_t off = ((k + 1) / stride - rec_base_) * store_.size();
+                    for (std::size_t i = lo; i < hi; i++) {
+                        const std::size_t o = off + (index_.empty() ? i : index_[i]);
+                        rec_x_[o] = xs[i];
+                        rec_y_[o] = ys[i];
+                    }
+                } else {
+                    for (std::size_t i = lo; i < hi; i++) {
+                        hist_[i].push_back(Vec2{xs[i], ys[i]});
+                    }
+                }
+            }
+
+            // Observers: this range's active positions, binned into the worker's own slot.
+            for (std::size_t j = 0; j < observers_.size(); ++j) {
+                const std::size_t m = observers_[j]->every();
+                if ((k + 1) % m == 0) {
+                    observers_[j]->observe(slot, obs_base_[j] + (k + 1) / m - 1, xs + lo, ys + lo, act - lo);
+                }
+            }
+        }
+    }
+
+} // namespace sim
@@ -0,0 +1,95 @@
+#pragma once
+/**
+ * @file checkpoint.hpp
+ * @brief Binary helpers for simulation checkpoints (save_checkpoint() / load_checkpoint()).
+ *
+ * What the file is for:
+ *   Batch jobs are killed at the wall-clock limit. A checkpoint holds everything a simulation
+ *   needs to continue bit-identically: particle columns, per-particle RNG state, history (or
+ *   the number of streamed frames), observer state and the position inside an interrupted
+ *   run(). The layout is owned by BasicSimulation::save_checkpoint(); this file provides
+ *   the raw read/write primitives and the atomic file replacement.
+ *
+ * File layout (host byte order, like the trajectory format in io.hpp):
+ *   char[8] "DMMCCKP1", uint32 byte_order 0x01020304, uint32 version, then the sections
+ *   written by BasicSimulation (see basic_simulation.hpp). Vectors are a uint64 length
+ *   followed by raw elements.
+ *
+ * Errors: truncated or foreign files throw std::runtime_error.
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace sim {
+
+    /// Current checkpoint format version.
+    constexpr std::uint32_t kCheckpointVersion = 3;     ///< 3: MT19937 words tagged with the std library layout.
+
+    namespace detail {
+        template <class T>
+        void write_pod(std::ostream& os, const T& v) {
+            static_assert(std::is_trivially_copyable<T>::value, "write_pod: T must be trivially copyable");
+            os.write(reinterpret_cast<const char*>(&v), sizeof(T));
+        }
+
+        template <class T>
+        T read_pod(std::istream& is) {
+            static_assert(std::is_trivially_copyable<T>::value, "read_pod: T must be trivially copyable");
+            T v;
+            if (!is.read(reinterpret_cast<char*>(&v), sizeof(T))) {
+                throw std::runtime_error("checkpoint: unexpected end of data");
+            }
+            return v;
+        }
+
+        template <class T, class A>
+        void write_vector(std::ostream& os, const std::vector<T, A>& v) {
+            static_assert(std::is_trivially_copyable<T>::value, "write_vector: T must be trivially copyable");
+            write_pod<std::uint64_t>(os, v.size());
+            if (!v.empty()) os.write(reinterpret_cast<const char*>(v.data()), static_cast<std::streamsize>(v.size() * sizeof(T)));
+        }
+
+        template <class T, class A>
+        void read_vector(std::istream& is, std::vector<T, A>& v) {
+            static_assert(std::is_trivially_copyable<T>::value, "read_vector: T must be trivially copyable");
+            const std::uint64_t n = read_pod<std::uint64_t>(is);
+            // Grow in bounded steps so a corrupt length fails on read, not on allocation.
+            constexpr std::uint64_t kStep = (std::uint64_t{1} << 24) / sizeof(T) + 1;
+            v.clear();
+            for (std::uint64_t done = 0; done < n; ) {
+                const std::uint64_t m = std::min(kStep, n - done);
+                v.resize(static_cast<std::size_t>(done + m));
+                if (!is.read(reinterpret_cast<char*>(v.data() + done), static_cast<std::streamsize>(m * sizeof(T)))) {
+                    throw std::runtime_error("checkpoint: unexpected end of data");
+                }
+                done += m;
+            }
+        }
+
+        void write_string(std::ostream& os, const std::string& s);
+        std::string read_string(std::istream& is);
+    } // namespace detail
+
+    /// Write the checkpoint header (magic, byte order, version).
+    void write_checkpoint_header(std::ostream& os);
+
+    /// Read and check the checkpoint header; throws std::runtime_error on a foreign file.
+    void read_checkpoint_header(std::istream& is);
+
+    /**
+     * @brief Write @p path by calling @p save on a binary stream, replacing the file atomically.
+     *
+     * Data goes to path + ".tmp", which is renamed over @p path only after a successful
+     * flush, so a job killed mid-write leaves the previous checkpoint intact.
+     */
+    void write_file_atomically(const std::string& path, const std::function<void(std::ostream&)>& save);
+
+} // namespace sim
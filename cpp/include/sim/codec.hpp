@@ -0,0 +1,134 @@
+#pragma once
+/**
+ * @file codec.hpp
+ * @brief Dependency-free compression for trajectory series (delta of IEEE bits + bit packing).
+ *
+ * What the file is for:
+ *   Consecutive recorded positions of one particle differ by about sqrt(2 D dt * store_every),
+ *   so each coordinate series is highly correlated. Raw storage spends 8 bytes per value; the
+ *   codecs here store only what changed. They are used by CompressedHistory (in-memory
+ *   history sink) and by the compressed trajectory file layout (io.hpp).
+ *
+ * Record: every value maps to a 64-bit key, the first key is stored raw and each later one
+ * as the zigzag-coded difference to the previous key: 1 bit if unchanged, otherwise a 6-bit
+ * length prefix plus the significant bits (Gorilla-style packing). Two keys, chosen by the
+ * tolerance (0 = lossless):
+ *   - Lossless: the IEEE bit pattern. Same-sign doubles order like their bits, so a step of
+ *     size s costs about log2(s / ulp(v)) + 7 bits. Decoded values are bit-identical. Only
+ *     the shared sign/exponent/leading mantissa bits are saved (about 1.1-1.2x on diffusive
+ *     data: the low mantissa bits are noise); repeated values cost 1 bit.
+ *   - Lossy: q = round(v / (2 tol)), so |decoded - v| <= tol (up to one rounding of
+ *     q * 2 tol). A step s costs about log2(s / tol) + 8 bits: roughly 3x at s/tol ~ 1e4 and
+ *     7x at s/tol ~ 10. Requires finite v with |v| / (2 tol) < 2^62.
+ * XOR of the bit patterns (classic Gorilla) was tried for the lossless key; on random-walk
+ * data its leading/trailing-zero windows rarely repeat and it ends up larger than raw.
+ *
+ * Streams:
+ *   A series is a bit stream (MSB first) of count values; the first value is stored raw.
+ *   Appending a value only appends bits, so a prefix of the encoded bytes stays valid
+ *   (except the last, partially filled byte).
+ *
+ * See also: history_sink.hpp (HistorySink), io.hpp (TrajectoryLayout::Compressed).
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "sim/history_sink.hpp"
+#include "sim/vec2.hpp"
+
+namespace sim {
+
+    /// Append-only MSB-first bit stream.
+    class BitWriter {
+        public:
+            /// Append the low @p n bits of @p v (n <= 64).
+            void put(std::uint64_t v, unsigned n);
+
+            const std::vector<std::uint8_t>& bytes() const noexcept { return buf_; }
+            void clear() noexcept { buf_.clear(); used_ = 0; }
+
+        private:
+            std::vector<std::uint8_t> buf_;
+            unsigned                  used_{0};   ///< Bits used in buf_.back(); 0 = start a new byte.
+    };
+
+    /// Reader for BitWriter streams.
+    class BitReader {
+        public:
+            BitReader(const std::uint8_t* data, std::size_t n_bytes) noexcept
+                : data_(data), n_bytes_(n_bytes) {}
+
+            /// Next @p n bits (n <= 64) as an unsigned value; reads past the end yield zeros.
+            std::uint64_t get(unsigned n) noexcept;
+
+        private:
+            const std::uint8_t* data_;
+            std::size_t         n_bytes_;
+            std::size_t         pos_{0};    ///< Bit position.
+    };
+
+    /// Incremental encoder for one series of doubles (see file notes for the modes).
+    class SeriesEncoder {
+        public:
+            /// @param tolerance Absolute error bound; 0 = lossless.
+            explicit SeriesEncoder(double tolerance = 0.0);
+
+            void push(double v);
+
+            std::size_t size() const noexcept { return count_; }
+            const std::vector<std::uint8_t>& bytes() const noexcept { return out_.bytes(); }
+            double tolerance() const noexcept { return tol_; }
+
+        private:
+            BitWriter     out_;
+            double        tol_;
+            double        inv_step_;        ///< 1 / (2 tol) for the lossy mode.
+            std::size_t   count_{0};
+            std::uint64_t prev_{0};         ///< Previous key: value bits (lossless) or q (lossy).
+    };
+
+    /**
+     * @brief Decode @p count values written by a SeriesEncoder with the same @p tolerance.
+     * @param out Destination with room for @p count values.
+     */
+    void decode_series(const std::uint8_t* data, std::size_t n_bytes, std::size_t count,
+                       double tolerance, double* out);
+
+    /**
+     * @brief In-memory history sink storing each particle's x and y series compressed.
+     *
+     * Attach with set_history_sink(); afterwards particle(i) / to_vectors() decode on demand.
+     * Memory is bytes() plus a small per-particle overhead instead of 16 bytes per frame.
+     */
+    class CompressedHistory : public HistorySink {
+        public:
+            /// @param tolerance Absolute error bound per coordinate; 0 = lossless.
+            explicit CompressedHistory(double tolerance = 0.0) : tol_(tolerance) {}
+
+            void begin(std::size_t n_particles, std::size_t store_every) override;
+            void write(const HistoryFrames& frames) override;
+
+            std::size_t n_particles() const noexcept { return xs_.size(); }
+            std::size_t n_frames() const noexcept { return n_frames_; }
+            std::size_t store_every() const noexcept { return store_every_; }
+
+            /// Compressed payload size (all series), in bytes.
+            std::size_t bytes() const noexcept;
+
+            /// Decoded trajectory of particle @p i (n_frames() points).
+            std::vector<Vec2> particle(std::size_t i) const;
+
+            /// Decoded history in the shape of BasicSimulation::history().
+            std::vector<std::vector<Vec2>> to_vectors() const;
+
+        private:
+            double                      tol_;
+            std::size_t                 n_frames_{0};
+            std::size_t                 store_every_{1};
+            std::vector<SeriesEncoder>  xs_;
+            std::vector<SeriesEncoder>  ys_;
+    };
+
+} // namespace sim
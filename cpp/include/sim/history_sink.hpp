@@ -0,0 +1,175 @@
+#pragma once
+/**
+ * @file history_sink.hpp
+ * @brief Streaming destinations for recorded trajectories plus a double-buffered writer thread.
+ *
+ * What the file is for:
+ *   The in-memory history (BasicSimulation::history()) keeps every recorded frame of every
+ *   particle resident: 16 bytes * n_particles * (1 + n_steps / store_every). For large runs
+ *   that does not fit. A HistorySink receives recorded frames in blocks instead, and
+ *   HistoryWriter hands those blocks to the sink on a background thread, so writing one block
+ *   overlaps computing the next and resident memory is bounded by two block buffers.
+ *
+ * Layout of a block (HistoryFrames):
+ *   Frame-major SoA: particle i of frame (first_frame + f) is (x[f*n + i], y[f*n + i]).
+ *   Particles are always in the caller's order (also for grouped runs), and frames are
+ *   delivered in increasing order with no gaps; frame 0 holds the initial positions.
+ *
+ * Provided sinks:
+ *   - CallbackHistorySink:   forwards each block to a std::function.
+ *   - BinaryHistoryFileSink: appends raw frames to a file (format documented on the class).
+ *
+ * Threading:
+ *   HistorySink::write() runs on the writer thread, begin()/flush() on the thread calling
+ *   run(); calls are never concurrent. Exceptions thrown by the sink are rethrown from run().
+ *
+ * See also: basic_simulation.hpp (set_history_sink(), SimulationConfig::history_buffer_bytes).
+ */
+
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "sim/vec2.hpp"
+
+namespace sim {
+
+    /// A block of consecutive recorded frames (frame-major SoA, see file notes).
+    struct HistoryFrames {
+        std::size_t   first_frame{0};   ///< Global index of the first frame in the block (0 = initial positions).
+        std::size_t   n_frames{0};      ///< Number of frames in the block.
+        std::size_t   n_particles{0};   ///< Particles per frame.
+        const double* x{nullptr};       ///< x-coordinates, n_frames * n_particles values.
+        const double* y{nullptr};       ///< y-coordinates, n_frames * n_particles values.
+
+        /// Position of particle @p i in block frame @p f.
+        Vec2 at(std::size_t f, std::size_t i) const noexcept {
+            return Vec2{x[f * n_particles + i], y[f * n_particles + i]};
+        }
+    };
+
+    /// Destination for recorded frames.
+    class HistorySink {
+        public:
+            virtual ~HistorySink() = default;
+
+            /// Called once, before frame 0, with the shape of the stream.
+            virtual void begin(std::size_t /*n_particles*/, std::size_t /*store_every*/) {}
+
+            /// Consume one block; blocks arrive in frame order.
+            virtual void write(const HistoryFrames& frames) = 0;
+
+            /// Called after the last block of every run() (e.g. to flush a file).
+            virtual void flush() {}
+    };
+
+    /// Sink that forwards every block to a callback (valid only during the call).
+    class CallbackHistorySink : public HistorySink {
+        public:
+            using Callback = std::function<void(const HistoryFrames&)>;
+
+            explicit CallbackHistorySink(Callback fn) : fn_(std::move(fn)) {}
+
+            void write(const HistoryFrames& frames) override { fn_(frames); }
+
+        private:
+            Callback fn_;
+    };
+
+    /**
+     * @brief Sink that writes frames to a binary file.
+     *
+     * Format (host byte order):
+     *   header: char[8] "DMMCHST1", uint64 n_particles, uint64 store_every
+     *   frames: per frame, n_particles doubles x then n_particles doubles y
+     * Frame f starts at byte 24 + f * 16 * n_particles.
+     */
+    class BinaryHistoryFileSink : public HistorySink {
+        public:
+            /// Open (truncate) @p path; throws std::runtime_error if it cannot be opened.
+            explicit BinaryHistoryFileSink(const std::string& path);
+
+            /**
+             * @brief Reopen @p path to continue a stream after load_checkpoint().
+             *
+             * Keeps the header and the first @p keep_frames frames (the simulation's
+             * streamed_frames()) and drops anything written after the checkpoint; throws
+             * std::runtime_error if the file is not a history file or holds fewer frames.
+             */
+            BinaryHistoryFileSink(const std::string& path, std::size_t keep_frames);
+
+            void begin(std::size_t n_particles, std::size_t store_every) override;
+            void write(const HistoryFrames& frames) override;
+            void flush() override;
+
+        private:
+            std::string   path_;
+            std::ofstream out_;
+    };
+
+    /**
+     * @brief Frames per buffer so that two buffers of @p n_particles fit in @p buffer_bytes,
+     *        capped at @p max_frames (the frames the run still has to record).
+     * @return At least 1 (a single frame is always buffered).
+     */
+    std::size_t history_frames_per_buffer(std::size_t buffer_bytes, std::size_t n_particles,
+                                          std::size_t max_frames = static_cast<std::size_t>(-1)) noexcept;
+
+    /**
+     * @brief Double-buffered background writer feeding a HistorySink.
+     *
+     * The producer fills x()/y() (frame-major, capacity() frames) and calls submit(); the
+     * block is written on the writer thread while the producer fills the other buffer.
+     * submit() blocks only if the previous block is still being written. The buffers are
+     * left uninitialized: the producer writes every frame it submits.
+     */
+    class HistoryWriter {
+        public:
+            HistoryWriter(HistorySink& sink, std::size_t n_particles, std::size_t frames_per_buffer);
+
+            /// Waits for the pending block and joins the thread (errors are dropped; call finish()).
+            ~HistoryWriter();
+
+            HistoryWriter(const HistoryWriter&) = delete;
+            HistoryWriter& operator=(const HistoryWriter&) = delete;
+
+            /// Frames per buffer.
+            std::size_t capacity() const noexcept { return frames_; }
+
+            /// Buffer currently being filled.
+            double* x() noexcept { return x_[fill_].get(); }
+            double* y() noexcept { return y_[fill_].get(); }
+
+            /// Hand the first @p n_frames of the fill buffer to the writer; swap buffers.
+            void submit(std::size_t first_frame, std::size_t n_frames);
+
+            /// Wait until every submitted block is written, then flush the sink.
+            void finish();
+
+        private:
+            void writer_loop();
+            void wait_idle();   ///< Wait for the pending block; rethrow a sink error.
+
+            HistorySink&                sink_;
+            std::size_t                 n_;
+            std::size_t                 frames_;
+            std::unique_ptr<double[]>   x_[2];
+            std::unique_ptr<double[]>   y_[2];
+            std::size_t                 fill_{0};     ///< Buffer owned by the producer.
+
+            std::mutex                  mtx_;
+            std::condition_variable     cv_;
+            HistoryFrames               pending_{};   ///< Block handed to the writer (n_frames == 0: none).
+            bool                        busy_{false};
+            bool                        stop_{false};
+            std::exception_ptr          error_{};
+            std::thread                 thread_;
+    };
+
+} // namespace sim
@@ -0,0 +1,208 @@
+#pragma once
+/**
+ * @file io.hpp
+ * @brief Binary trajectory format: streaming writer (a HistorySink) and memory-mapped reader.
+ *
+ * What the file is for:
+ *   Analysis jobs read recorded runs that are many GB. Text has to be parsed front to back;
+ *   this format is a fixed header followed by raw doubles at computable offsets, so a reader
+ *   maps the file and hands out zero-copy views of any frame or particle without parsing.
+ *
+ * File layout (host byte order; byte_order lets readers reject foreign-endian files):
+ *   [0, 256)   TrajectoryHeader: magic "DMMCTRJ1", version, layout, shape (n_particles,
+ *              n_frames, frames_per_chunk), run config (store_every, n_steps, seeds, RNG
+ *              choice, default Brownian params) and a hash of the world geometry.
+ *   [256, ...) Frame data, F = 16 * n_particles bytes per frame, in one of three layouts:
+ *     - FrameMajor:    frame f at 256 + f*F: x[n_particles] then y[n_particles].
+ *                      frame(f) is one contiguous view; a particle is a strided walk.
+ *     - ParticleMajor: frames are grouped in chunks of C = frames_per_chunk (last chunk may
+ *                      be shorter, m frames). Chunk c starts at 256 + c*C*F and holds
+ *                      x[particle][m] then y[particle][m]. particle_chunk(i, c) is one
+ *                      contiguous view; a frame is a strided walk.
+ *     - Compressed:    like ParticleMajor, but each particle's x and y series in a chunk are
+ *                      encoded with SeriesEncoder (codec.hpp; lossless, or lossy to
+ *                      'tolerance'). Chunk payload: uint64 offsets[2*n_particles + 1] (x_i
+ *                      at 2i, y_i at 2i+1, end last; relative to the payload) then the
+ *                      streams, zero-padded to 8 bytes. Chunks are variable-size, so a
+ *                      trailer of n_chunks + 1 uint64 chunk offsets (last = end of data)
+ *                      sits at 'index_offset'.
+ *                      Access decodes; there are no zero-copy views.
+ *   Frame 0 is the initial positions; frame f was recorded after f*store_every steps.
+ *
+ * Writing:
+ *   TrajectoryWriter is a HistorySink: attach it with set_history_sink() and frames arrive
+ *   from the background writer thread. n_frames in the header is rewritten on every flush()
+ *   (end of each run()), so a file is readable after every completed run.
+ *
+ * Reading:
+ *   TrajectoryReader maps the file read-only (POSIX mmap; other platforms read it into
+ *   memory). Views stay valid while the reader is alive.
+ *
+ * See also: history_sink.hpp (HistorySink, HistoryWriter), basic_simulation.hpp.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "sim/vec2.hpp"
+#include "sim/analytic_worlds.hpp"
+#include "sim/basic_simulation.hpp"
+#include "sim/codec.hpp"
+#include "sim/history_sink.hpp"
+#include "sim/particle_store.hpp"
+#include "sim/reflecting_world.hpp"
+
+namespace sim {
+
+    /// Arrangement of frame data in a trajectory file (see file notes).
+    enum class TrajectoryLayout : std::uint32_t {
+        FrameMajor    = 0,  ///< One contiguous block per frame.
+        ParticleMajor = 1,  ///< Chunks of frames, one contiguous run per particle per chunk.
+        Compressed    = 2   ///< ParticleMajor chunks with each series encoded (codec.hpp).
+    };
+
+    /// Current trajectory format version.
+    constexpr std::uint32_t kTrajectoryVersion = 1;
+
+    /// Fixed 256-byte file header (field offsets are part of the format).
+    struct TrajectoryHeader {
+        char          magic[8]{'D', 'M', 'M', 'C', 'T', 'R', 'J', '1'};
+        std::uint32_t byte_order{0x01020304u};  ///< Written in host order; readers check it.
+        std::uint32_t version{kTrajectoryVersion};
+        std::uint32_t layout{0};                ///< TrajectoryLayout.
+        std::uint32_t header_bytes{256};        ///< Offset of the first frame byte.
+        std::uint64_t n_particles{0};
+        std::uint64_t n_frames{0};              ///< Frames present (updated on every flush).
+        std::uint64_t frames_per_chunk{0};      ///< Chunk length (ParticleMajor / Compressed); 0 for FrameMajor.
+        std::uint64_t store_every{1};
+        std::uint64_t n_steps{0};               ///< Steps per run() of the writing simulation.
+        std::uint64_t base_seed{0};
+        std::uint32_t deterministic{1};
+        std::uint32_t rng_engine{0};            ///< RngEngine.
+        std::uint32_t normal_method{0};         ///< NormalMethod.
+        std::uint32_t reserved0{0};
+        double        dt{0.0};                  ///< Default BrownianParams of the run.
+        double        D{0.0};
+        double        mu_x{0.0};
+        double        mu_y{0.0};
+        std::uint64_t world_hash{0};            ///< geometry_hash() of the world, 0 if unknown.
+        double        tolerance{0.0};           ///< Compressed: codec error bound (0 = lossless).
+        std::uint64_t index_offset{0};          ///< Compressed: file offset of the chunk trailer.
+        std::uint8_t  reserved[112]{};
+    };
+    static_assert(sizeof(TrajectoryHeader) == 256, "TrajectoryHeader must stay 256 bytes");
+
+    /**
+     * @brief Header pre-filled from a run configuration.
+     * @param frames_per_chunk Chunk length for ParticleMajor / Compressed (0 picks 256).
+     * @param tolerance        Compressed codec error bound (0 = lossless).
+     */
+    TrajectoryHeader make_trajectory_header(const SimulationConfig& cfg, std::uint64_t world_hash = 0,
+                                            TrajectoryLayout layout = TrajectoryLayout::FrameMajor,
+                                            std::size_t frames_per_chunk = 0, double tolerance = 0.0);
+
+    /// 64-bit FNV-1a hash of the geometry (wall endpoints, normals, ids / analytic parameters).
+    std::uint64_t geometry_hash(const ReflectingWorld& world) noexcept;
+    std::uint64_t geometry_hash(const BoxWorld& world) noexcept;
+    std::uint64_t geometry_hash(const HalfPlaneWorld& world) noexcept;
+    std::uint64_t geometry_hash(const WedgeWorld& world) noexcept;
+
+    /**
+     * @brief HistorySink that writes the trajectory format.
+     *
+     * n_particles and store_every are taken from begin(); the remaining header fields come from
+     * the header passed to the constructor. ParticleMajor and Compressed buffer one chunk.
+     */
+    class TrajectoryWriter : public HistorySink {
+        public:
+            /// Create (truncate) @p path; throws std::runtime_error if it cannot be opened.
+            TrajectoryWriter(const std::string& path, const TrajectoryHeader& header);
+
+            void begin(std::size_t n_particles, std::size_t store_every) override;
+            void write(const HistoryFrames& frames) override;
+            void flush() override;
+
+            const TrajectoryHeader& header() const noexcept { return header_; }
+
+        private:
+            void write_at(std::uint64_t offset, const void* data, std::size_t bytes);
+            /// (Re)write the buffered chunk at its offset; @p complete advances to the next chunk.
+            void write_chunk(bool complete);
+
+            std::string         path_;
+            std::fstream        out_;
+            TrajectoryHeader    header_;
+            std::vector<double> chunk_x_;     ///< Chunked layouts: buffered frames, frame-major.
+            std::vector<double> chunk_y_;
+            std::size_t         chunk_frames_{0};
+            std::uint64_t       chunk_offset_{0};   ///< Compressed: offset of the buffered chunk.
+            std::uint64_t       chunk_end_{0};      ///< Compressed: end of its last write.
+            std::vector<std::uint64_t> chunk_index_;///< Compressed: offsets of completed chunks.
+    };
+
+    /**
+     * @brief Read-only, memory-mapped view of a trajectory file.
+     *
+     * Opening only validates the header; data pages are loaded on first access.
+     */
+    class TrajectoryReader {
+        public:
+            /// Map @p path; throws std::runtime_error if it is missing, malformed or truncated.
+            explicit TrajectoryReader(const std::string& path);
+            ~TrajectoryReader();
+
+            TrajectoryReader(TrajectoryReader&& other) noexcept;
+            TrajectoryReader& operator=(TrajectoryReader&& other) noexcept;
+            TrajectoryReader(const TrajectoryReader&) = delete;
+            TrajectoryReader& operator=(const TrajectoryReader&) = delete;
+
+            const TrajectoryHeader& header() const noexcept { return header_; }
+            TrajectoryLayout layout() const noexcept { return static_cast<TrajectoryLayout>(header_.layout); }
+            std::size_t n_particles() const noexcept { return static_cast<std::size_t>(header_.n_particles); }
+            std::size_t n_frames() const noexcept { return static_cast<std::size_t>(header_.n_frames); }
+
+            /// Zero-copy view of frame @p f (FrameMajor only; throws std::logic_error otherwise).
+            PositionsView frame(std::size_t f) const;
+
+            /// Number of ParticleMajor / Compressed chunks (0 for FrameMajor).
+            std::size_t n_chunks() const noexcept;
+
+            /**
+             * @brief Zero-copy view of particle @p i over chunk @p c (ParticleMajor only;
+             *        throws std::logic_error otherwise).
+             * @return Positions at frames [c*frames_per_chunk, c*frames_per_chunk + size()).
+             */
+            PositionsView particle_chunk(std::size_t i, std::size_t c) const;
+
+            /// Position of particle @p i at frame @p f (any layout).
+            Vec2 at(std::size_t f, std::size_t i) const;
+
+            /// Copy of particle @p i's whole trajectory (any layout).
+            std::vector<Vec2> particle(std::size_t i) const;
+
+        private:
+            void release() noexcept;
+
+            /// Compressed: decode particle @p i over chunk @p c into x/y (room for the chunk length).
+            std::size_t decode_chunk(std::size_t i, std::size_t c, double* x, double* y) const;
+
+            /// Compressed: chunk offsets (n_chunks() + 1 entries, last = end of data).
+            const std::uint64_t* chunk_index() const noexcept {
+                return reinterpret_cast<const std::uint64_t*>(base_ + header_.index_offset);
+            }
+
+            const double* data() const noexcept {
+                return reinterpret_cast<const double*>(base_ + header_.header_bytes);
+            }
+
+            const unsigned char*        base_{nullptr};
+            std::size_t                 size_{0};
+            bool                        mapped_{false};     ///< base_ is an mmap (else fallback_).
+            std::vector<unsigned char>  fallback_;
+            TrajectoryHeader            header_{};
+    };
+
+} // namespace sim
@@ -0,0 +1,257 @@
+#pragma once
+/**
+ * @file observers.hpp
+ * @brief On-the-fly statistics of particle positions at output times (histograms and friends).
+ *
+ * What the file is for:
+ *   The production pipeline reduces a run to histograms (results.txt, nbins). Binning the
+ *   recorded history afterwards needs the whole trajectory set in memory or on disk. A
+ *   PositionObserver is handed the positions at its output times while run() steps, so it can
+ *   accumulate what it needs (memory independent of n_particles) with record_history = false.
+ *
+ * Output times:
+ *   An observer with every() = m gets output 0 (positions at the start of the first run() after
+ *   it was attached) and one output after every m-th step; output f is the state after f*m
+ *   steps. Later run() calls continue the numbering, exactly like history frames with
+ *   store_every = m.
+ *
+ * Threading:
+ *   begin() and end() run on the thread calling run(). observe() is called concurrently, each
+ *   worker passing its own slot in [0, n_slots), with disjoint particle ranges in store order
+ *   (grouped runs reorder particles, so observers must not rely on particle identity). Only
+ *   particles still moving are observed: ones absorbed by a wall are left out. An
+ *   observer keeps private per-slot state and merges it in end(); if run() throws, end() is
+ *   skipped and the run's partial observations are dropped by the next begin().
+ *
+ * Provided observers:
+ *   - HistogramObserver: radial, angular or 2D grid counts per output (integer counts, so the
+ *     merged result is identical for any thread count, loop order or grouping).
+ *   - MomentObserver: mean, variance, skewness and kurtosis of x, y, r and theta per output,
+ *     with standard errors. Slots are merged in slot order, so results are reproducible for a
+ *     given n_threads; across thread counts they agree to rounding. save() / load() / merge()
+ *     combine runs from separate processes (e.g. SLURM array tasks).
+ *
+ * See also: basic_simulation.hpp (add_observer()).
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <vector>
+
+#include "sim/vec2.hpp"
+
+namespace sim {
+
+    /// Receives particle positions at output times during run() (see file notes).
+    class PositionObserver {
+        public:
+            /// @param every Output stride in steps. @pre every >= 1.
+            explicit PositionObserver(std::size_t every) : every_(every) {}
+            virtual ~PositionObserver() = default;
+
+            /// Steps between outputs.
+            std::size_t every() const noexcept { return every_; }
+
+            /**
+             * @brief Prepare for a run that delivers outputs [first_output, first_output + n_outputs).
+             * @param n_slots Number of worker slots observe() may be called with.
+             */
+            virtual void begin(std::size_t n_slots, std::size_t first_output, std::size_t n_outputs) = 0;
+
+            /// Positions (x[j], y[j]), j < count, of some particles at output @p output.
+            virtual void observe(std::size_t slot, std::size_t output,
+                                 const double* x, const double* y, std::size_t count) = 0;
+
+            /// Merge per-slot state after a completed run.
+            virtual void end() = 0;
+
+            /**
+             * @brief Write the merged state for a checkpoint (binary, after end()).
+             * The default throws std::runtime_error: an observer that cannot be restored
+             * must not be silently dropped from a resumed run.
+             */
+            virtual void save_state(std::ostream& os) const;
+
+            /// Restore a save_state() record into an observer with the same settings.
+            virtual void load_state(std::istream& is);
+
+        private:
+            std::size_t every_;
+    };
+
+    /**
+     * @brief Position histogram per output: radial |p - center|, polar angle about center,
+     *        or a regular 2D grid.
+     *
+     * Bins are half-open, [lo + b*w, lo + (b+1)*w); positions outside every bin (and NaN) are
+     * counted in outside(f), so total(f) equals the number of active particles. Grid bin (ix, iy) has
+     * index iy * nx + ix. Each worker slot bins into its own counts; end() adds them up.
+     */
+    class HistogramObserver : public PositionObserver {
+        public:
+            enum class Kind { Radial, Angular, Grid };
+
+            /// Radial distance from @p center in [0, r_max), @p n_bins bins.
+            static HistogramObserver radial(Vec2 center, double r_max, std::size_t n_bins, std::size_t every);
+
+            /// Polar angle atan2(y - cy, x - cx) in [theta_min, theta_max), @p n_bins bins.
+            static HistogramObserver angular(Vec2 center, double theta_min, double theta_max,
+                                             std::size_t n_bins, std::size_t every);
+
+            /// Grid over [x_min, x_max) x [y_min, y_max) with nx * ny bins.
+            static HistogramObserver grid(double x_min, double x_max, std::size_t nx,
+                                          double y_min, double y_max, std::size_t ny, std::size_t every);
+
+            void begin(std::size_t n_slots, std::size_t first_output, std::size_t n_outputs) override;
+            void observe(std::size_t slot, std::size_t output,
+                         const double* x, const double* y, std::size_t count) override;
+            void end() override;
+            void save_state(std::ostream& os) const override;
+            void load_state(std::istream& is) override;
+
+            Kind kind() const noexcept { return kind_; }
+            std::size_t n_bins() const noexcept { return nx_ * ny_; }
+            std::size_t nx() const noexcept { return nx_; }
+            std::size_t ny() const noexcept { return ny_; }
+
+            /// Outputs with merged counts.
+            std::size_t n_outputs() const noexcept { return n_outputs_; }
+
+            /// Particles in bin @p b at output @p f.
+            std::uint64_t count(std::size_t f, std::size_t b) const noexcept {
+                return counts_[f * (n_bins() + 1) + b];
+            }
+            /// Particles outside every bin at output @p f.
+            std::uint64_t outside(std::size_t f) const noexcept { return count(f, n_bins()); }
+            /// Particles observed at output @p f (in bins plus outside).
+            std::uint64_t total(std::size_t f) const noexcept;
+
+            /// Center of bin @p b along the first axis (r, theta or x) / second axis (grid y).
+            double center_u(std::size_t b) const noexcept { return u_lo_ + (static_cast<double>(b) + 0.5) * u_w_; }
+            double center_v(std::size_t b) const noexcept { return v_lo_ + (static_cast<double>(b) + 0.5) * v_w_; }
+
+            /**
+             * @brief Add another observer's counts (same kind, bins and every(); e.g. from another
+             *        batch of particles). Throws std::invalid_argument if they differ.
+             */
+            void merge(const HistogramObserver& other);
+
+            /// Drop all counts (the owning simulation keeps numbering outputs from where it was).
+            void clear() noexcept;
+
+            /**
+             * @brief Text table, one line per (output, bin): "step u count fraction" for radial /
+             *        angular, "step x y count fraction" for grids; step = output * every().
+             */
+            void write_text(std::ostream& os) const;
+
+        private:
+            HistogramObserver(Kind kind, Vec2 center, double u_lo, double u_hi, std::size_t nu,
+                              double v_lo, double v_hi, std::size_t nv, std::size_t every);
+
+            /// Bin index of (x, y), or n_bins() if outside.
+            std::size_t bin(double x, double y) const noexcept;
+
+            Kind        kind_;
+            Vec2        center_;
+            double      u_lo_, u_w_, u_inv_;   ///< First axis: origin, width, 1 / width.
+            double      v_lo_, v_w_, v_inv_;   ///< Second axis (grid only).
+            std::size_t nx_, ny_;
+
+            std::size_t                             n_outputs_{0};
+            std::vector<std::uint64_t>              counts_;    ///< Merged, [output][n_bins + 1].
+            std::size_t                             run_first_{0};
+            std::size_t                             run_outputs_{0};
+            std::vector<std::vector<std::uint64_t>> local_;     ///< Per slot, [output - run_first_][n_bins + 1]; sized on first use.
+    };
+
+    /**
+     * @brief Streaming count, mean and central moments M2..M4 of a sample.
+     *
+     * add() is Welford's update extended to the third and fourth moments; merge() is the
+     * pairwise combination (Chan et al. / Pebay), so partial accumulators from threads or
+     * processes combine without revisiting the data. Both avoid the cancellation of
+     * sum-of-powers formulas.
+     */
+    struct Moments {
+        std::uint64_t n{0};
+        double        mean{0.0};
+        double        m2{0.0};      ///< Sum of (v - mean)^2.
+        double        m3{0.0};      ///< Sum of (v - mean)^3.
+        double        m4{0.0};      ///< Sum of (v - mean)^4.
+
+        void add(double v) noexcept;
+        void merge(const Moments& other) noexcept;
+
+        /// Unbiased sample variance m2 / (n - 1); 0 for n < 2.
+        double variance() const noexcept;
+        /// Standard error of the mean, sqrt(variance / n); 0 for n < 2.
+        double std_error() const noexcept;
+        /// Sample skewness g1 = sqrt(n) m3 / m2^1.5; 0 if m2 == 0.
+        double skewness() const noexcept;
+        /// Sample excess kurtosis g2 = n m4 / m2^2 - 3; 0 if m2 == 0.
+        double kurtosis() const noexcept;
+
+        /// Half-width z * std_error() of the normal-approximation confidence interval for the mean.
+        double ci_half_width(double z = 1.96) const noexcept { return z * std_error(); }
+
+        /// Sample size for which ci_half_width(z) would reach @p half_width at the current variance.
+        std::uint64_t required_samples(double half_width, double z = 1.96) const noexcept;
+    };
+
+    /**
+     * @brief Moments of x, y, r = |p - center| and theta = atan2(y - cy, x - cx) per output.
+     *
+     * Each worker slot accumulates its own Moments; end() merges them in slot order.
+     */
+    class MomentObserver : public PositionObserver {
+        public:
+            enum Quantity : std::size_t { X = 0, Y = 1, R = 2, Theta = 3 };
+            static constexpr std::size_t kQuantities = 4;
+
+            /// @param center Origin for r and theta.
+            explicit MomentObserver(std::size_t every, Vec2 center = Vec2{0.0, 0.0});
+
+            void begin(std::size_t n_slots, std::size_t first_output, std::size_t n_outputs) override;
+            void observe(std::size_t slot, std::size_t output,
+                         const double* x, const double* y, std::size_t count) override;
+            void end() override;
+            void save_state(std::ostream& os) const override;
+            void load_state(std::istream& is) override;
+
+            Vec2 center() const noexcept { return center_; }
+            std::size_t n_outputs() const noexcept { return n_outputs_; }
+
+            /// Merged moments of quantity @p q at output @p f.
+            const Moments& moments(std::size_t f, Quantity q) const noexcept { return acc_[f * kQuantities + q]; }
+
+            /**
+             * @brief Add another observer's outputs (same every() and center; e.g. loaded from
+             *        another process). Throws std::invalid_argument if they differ.
+             */
+            void merge(const MomentObserver& other);
+
+            /// Drop all outputs.
+            void clear() noexcept { acc_.clear(); n_outputs_ = 0; }
+
+            /// Summary table, one line per (output, quantity): "step q n mean std_error variance skewness kurtosis".
+            void write_text(std::ostream& os) const;
+
+            /// Full-precision state for load() (text; "DMMCMOM1" header, then n mean m2 m3 m4 rows).
+            void save(std::ostream& os) const;
+
+            /// Read a save()d state; throws std::runtime_error if it is malformed.
+            static MomentObserver load(std::istream& is);
+
+        private:
+            Vec2                                center_;
+            std::size_t                         n_outputs_{0};
+            std::vector<Moments>                acc_;       ///< Merged, [output][kQuantities].
+            std::size_t                         run_first_{0};
+            std::size_t                         run_outputs_{0};
+            std::vector<std::vector<Moments>>   local_;     ///< Per slot, [output - run_first_][kQuantities]; sized on first use.
+    };
+
+} // namespace sim
@@ -0,0 +1,118 @@
+#pragma once
+/**
+ * @file parallel.hpp
+ * @brief Small fixed-size thread pool for splitting particle ranges across cores, and a
+ *        work-stealing loop for independent tasks of uneven cost.
+ *
+ * What the file is for:
+ *   Particles in a simulation are independent (own RNG, position, params), so the
+ *   particle loop can be partitioned into contiguous index ranges and executed
+ *   concurrently. This header provides the minimal fork-join machinery to do that.
+ *
+ * Design notes:
+ *   - Workers are created once and reused across calls (no per-step thread spawn).
+ *   - The calling thread participates as worker 0; a pool of size 1 runs inline.
+ *   - Static partitioning: range r covers [r*chunk, min(n, (r+1)*chunk)). The split
+ *     depends only on (n_items, size()), never on timing, so results are reproducible.
+ *   - Exceptions thrown by a task are captured and the first one is rethrown on the
+ *     calling thread after all ranges have finished.
+ *
+ * Work stealing (work_stealing_for()):
+ *   - For coarse tasks whose costs differ a lot (e.g. sweep rows cut into particle chunks),
+ *     where a static split would leave threads idle behind the slowest range.
+ *   - Items are dealt round-robin into per-thread deques. A thread takes its own items from
+ *     the front (ascending order) and, when it runs dry, steals from the back of another
+ *     thread's deque. Which thread runs an item depends on timing, so tasks must not depend
+ *     on the thread; results stay reproducible when each item writes only its own output.
+ *
+ * Thread-safety:
+ *   - parallel_for() is not re-entrant; call it from one thread at a time.
+ */
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace sim {
+
+    /**
+     * @brief Resolve a requested thread count against the machine and the work size.
+     * @param requested Requested threads; 0 means std::thread::hardware_concurrency().
+     * @param n_items   Number of work items; never use more threads than items.
+     * @return          Thread count in [1, max(1, n_items)].
+     */
+    std::size_t resolve_thread_count(std::size_t requested, std::size_t n_items) noexcept;
+
+    /**
+     * @brief Fixed-size fork-join pool that runs one contiguous range per thread.
+     *
+     * Usage:
+     *   ThreadPool pool(8);
+     *   pool.parallel_for(n, [&](std::size_t lo, std::size_t hi, std::size_t tid) { ... });
+     */
+    class ThreadPool {
+        public:
+            /// Range task: process items [lo, hi) on worker @p tid (tid < size()).
+            using RangeFn = std::function<void(std::size_t lo, std::size_t hi, std::size_t tid)>;
+
+            /**
+             * @brief Start a pool with @p n_threads workers (including the caller).
+             * @param n_threads Total threads; values < 1 are treated as 1.
+             */
+            explicit ThreadPool(std::size_t n_threads);
+
+            /// Joins all workers.
+            ~ThreadPool();
+
+            ThreadPool(const ThreadPool&) = delete;
+            ThreadPool& operator=(const ThreadPool&) = delete;
+
+            /// Total number of threads (background workers + calling thread).
+            std::size_t size() const noexcept { return workers_.size() + 1; }
+
+            /**
+             * @brief Partition [0, n_items) into size() contiguous ranges and run @p fn on each.
+             *
+             * Blocks until every range is done. Empty ranges are skipped. If any task throws,
+             * the first captured exception is rethrown here after all tasks have completed.
+             */
+            void parallel_for(std::size_t n_items, const RangeFn& fn);
+
+        private:
+            void worker_loop(std::size_t tid);
+            void run_range(std::size_t tid) noexcept;
+
+            std::vector<std::thread>    workers_;
+
+            std::mutex                  mtx_;
+            std::condition_variable     cv_start_;
+            std::condition_variable     cv_done_;
+
+            // Current job (guarded by mtx_ for publication; read-only while running).
+            const RangeFn*              fn_{nullptr};
+            std::size_t                 n_items_{0};
+            std::size_t                 chunk_{0};
+            std::size_t                 generation_{0};   ///< Bumped once per parallel_for call.
+            std::size_t                 pending_{0};      ///< Background workers still running.
+            bool                        stop_{false};
+            std::exception_ptr          error_{};
+    };
+
+    /// Task for work_stealing_for(): process item @p item on thread @p tid (tid < thread count).
+    using ItemFn = std::function<void(std::size_t item, std::size_t tid)>;
+
+    /**
+     * @brief Run @p fn on every item of [0, n_items) with @p n_threads threads (including the
+     *        caller) and work stealing (see file notes); blocks until all items are done.
+     *
+     * n_threads follows resolve_thread_count(). If a task throws, no further items are started
+     * and the first exception is rethrown here once the running tasks have finished.
+     */
+    void work_stealing_for(std::size_t n_items, std::size_t n_threads, const ItemFn& fn);
+
+} // namespace sim
@@ -0,0 +1,277 @@
+#pragma once
+/**
+ * @file particle_store.hpp
+ * @brief Structure-of-arrays (SoA) storage for per-particle simulation state.
+ *
+ * What the file is for:
+ *   Simulation keeps one record per particle (position, step model, parameters, RNG).
+ *   Storing those as separate contiguous columns (x[], y[], dt[], D[], ...) instead of
+ *   arrays of structs lets step and reflection kernels stream exactly the fields they
+ *   use and keeps the columns ready for SIMD loads.
+ *
+ * Core concepts:
+ *   - BasicParticleStore<Rng>: owns the columns; all columns have the same length. The RNG
+ *     type is a parameter so policy-templated simulations (basic_simulation.hpp) can keep a
+ *     concrete generator per particle. ParticleStore = BasicParticleStore<RNG>.
+ *   - PositionsView: zero-copy, read-only view over the x[]/y[] columns that behaves
+ *     like a small random-access container of Vec2 (size(), operator[], range-for).
+ *     Callers that need an owning std::vector<Vec2> use to_vector() or the implicit
+ *     conversion.
+ *
+ * Invariants:
+ *   - x.size() == y.size() == step_type.size() == dt.size() == D.size()
+ *     == mu_x.size() == mu_y.size() == spec.size() == clearance.size() == alive.size()
+ *     == exit_step.size() == exit_wall.size(); rng is either empty or the same size.
+ *   - A particle with alive[i] == 0 was absorbed: x[i], y[i] hold its exit point and it no
+ *     longer moves. set_position() brings it back.
+ *   - A PositionsView is invalidated by any operation that resizes the store.
+ *
+ * See also: simulation.hpp (owner), step_generators.hpp (BrownianParams fields).
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+#include "sim/vec2.hpp"
+#include "sim/rng.hpp"
+#include "sim/step_generators.hpp"
+
+namespace sim {
+
+    /**
+     * @enum StepType
+     * @brief Selects the step model used to advance a particle.
+     *
+     * Use this to choose how each particle's position increment is generated
+     * during a simulation step.
+     *
+     * - StepType::Brownian - Use a Brownian/gaussian step generator
+     *                         (see @ref BrownianParams for defaults).
+     * - StepType::Specified - Use a caller-provided step generator (e.g., a
+     *                         mapping steps).
+     */
+    enum class StepType {
+        Brownian,       ///< Step Brownian (Gaussian) increments.
+        Specified       ///< Externally specified step generator per particle.
+    };
+
+    namespace detail {
+        /// Reorder @p v so that new v[k] == old v[order[k]] (order is a permutation of 0..n-1).
+        template <class T, class A>
+        void permute_vector(std::vector<T, A>& v, const std::vector<std::size_t>& order) {
+            std::vector<T, A> out;
+            out.reserve(v.size());
+            for (const std::size_t k : order) out.push_back(std::move(v[k]));
+            v.swap(out);
+        }
+    } // namespace detail
+
+    /**
+     * @brief Read-only, non-owning view of particle positions stored as x[] and y[] columns.
+     *
+     * Elements are returned by value (Vec2 is 16 bytes), so `const auto& p = view[i]`
+     * and `for (Vec2 p : view)` both work. Raw column pointers are available for kernels.
+     */
+    class PositionsView {
+        public:
+            /// Random-access iterator yielding Vec2 by value. It holds the column pointers, not
+            /// the view, so it stays valid after a temporary view (e.g. positions()) is gone.
+            class const_iterator {
+                public:
+                    using iterator_category = std::random_access_iterator_tag;
+                    using value_type        = Vec2;
+                    using difference_type   = std::ptrdiff_t;
+                    using pointer           = void;
+                    using reference         = Vec2;
+
+                    const_iterator() = default;
+                    const_iterator(const double* xs, const double* ys, std::size_t i)
+                        : x_(xs), y_(ys), i_(i) {}
+
+                    Vec2 operator*() const { return Vec2{x_[i_], y_[i_]}; }
+                    Vec2 operator[](difference_type k) const { return Vec2{x_[i_ + k], y_[i_ + k]}; }
+                    const_iterator& operator++() { ++i_; return *this; }
+                    const_iterator  operator++(int) { auto t = *this; ++i_; return t; }
+                    const_iterator& operator--() { --i_; return *this; }
+                    const_iterator  operator--(int) { auto t = *this; --i_; return t; }
+                    const_iterator& operator+=(difference_type k) { i_ += k; return *this; }
+                    const_iterator& operator-=(difference_type k) { i_ -= k; return *this; }
+                    const_iterator  operator+(difference_type k) const { return {x_, y_, i_ + k}; }
+                    const_iterator  operator-(difference_type k) const { return {x_, y_, i_ - k}; }
+                    difference_type operator-(const const_iterator& o) const {
+                        return static_cast<difference_type>(i_) - static_cast<difference_type>(o.i_);
+                    }
+                    bool operator==(const const_iterator& o) const { return i_ == o.i_; }
+                    bool operator!=(const const_iterator& o) const { return i_ != o.i_; }
+                    bool operator<(const const_iterator& o) const { return i_ < o.i_; }
+
+                private:
+                    const double* x_{nullptr};
+                    const double* y_{nullptr};
+                    std::size_t   i_{0};
+            };
+
+            PositionsView() = default;
+            PositionsView(const double* xs, const double* ys, std::size_t n) noexcept
+                : x_(xs), y_(ys), n_(n) {}
+
+            std::size_t size() const noexcept { return n_; }
+            bool empty() const noexcept { return n_ == 0; }
+
+            /// Position of particle @p i (by value).
+            Vec2 operator[](std::size_t i) const noexcept { return Vec2{x_[i], y_[i]}; }
+
+            /// Contiguous x-coordinates (length size()).
+            const double* x() const noexcept { return x_; }
+            /// Contiguous y-coordinates (length size()).
+            const double* y() const noexcept { return y_; }
+
+            const_iterator begin() const { return {x_, y_, 0}; }
+            const_iterator end() const { return {x_, y_, n_}; }
+
+            /// Copy into an owning array-of-structs vector.
+            std::vector<Vec2> to_vector() const {
+                std::vector<Vec2> out;
+                out.reserve(n_);
+                for (std::size_t i = 0; i < n_; ++i) out.push_back(Vec2{x_[i], y_[i]});
+                return out;
+            }
+
+            /// Conversion path for callers that still want std::vector<Vec2>.
+            operator std::vector<Vec2>() const { return to_vector(); }
+
+        private:
+            const double* x_{nullptr};
+            const double* y_{nullptr};
+            std::size_t   n_{0};
+    };
+
+    /**
+     * @brief Column-wise storage of all per-particle state used by Simulation.
+     *
+     * BrownianParams are split into packed dt/D/mu_x/mu_y columns; use brownian(i) and
+     * set_brownian(i, p) to move between the struct and column forms.
+     *
+     * @tparam Rng Per-particle generator type (sim::RNG unless a simulation picks another).
+     */
+    template <class Rng>
+    struct BasicParticleStore {
+        using rng_type = Rng;
+
+        // Positions
+        std::vector<double>                 x;          ///< x-coordinates
+        std::vector<double>                 y;          ///< y-coordinates
+
+        // Step model selection and parameters
+        std::vector<StepType>               step_type;  ///< Per-particle step model.
+        std::vector<double>                 dt;         ///< BrownianParams::dt column
+        std::vector<double>                 D;          ///< BrownianParams::D column
+        std::vector<double>                 mu_x;       ///< BrownianParams::mu_x column
+        std::vector<double>                 mu_y;       ///< BrownianParams::mu_y column
+        std::vector<SpecifiedStepParams>    spec;       ///< Specified-step params (cold; rarely read in Brownian runs)
+
+        // Geometry cache
+        std::vector<double>                 clearance;  ///< Lower bound on distance to the nearest wall (0 = unknown)
+
+        // First passage (absorbing walls)
+        std::vector<std::uint8_t>           alive;      ///< 1 while moving; 0 once absorbed
+        std::vector<double>                 exit_step;  ///< Steps taken until absorption, incl. the fraction of the last (-1 = alive)
+        std::vector<int>                    exit_wall;  ///< WallSegment::id of the absorbing wall (-1 = alive)
+
+        // Randomness
+        std::vector<Rng>                    rng;        ///< Per-particle RNG streams
+
+        /// Number of particles.
+        std::size_t size() const noexcept { return x.size(); }
+
+        /**
+         * @brief Resize every column except rng to @p n particles.
+         * New particles start at the origin, Brownian, with @p brownian defaults.
+         * The RNG column is seeded by the owner (seeding policy lives in Simulation).
+         */
+        void resize(std::size_t n, const BrownianParams& brownian) {
+            x.assign(n, 0.0);
+            y.assign(n, 0.0);
+            step_type.assign(n, StepType::Brownian);
+            dt.assign(n, brownian.dt);
+            D.assign(n, brownian.D);
+            mu_x.assign(n, brownian.mu_x);
+            mu_y.assign(n, brownian.mu_y);
+            spec.assign(n, SpecifiedStepParams{});
+            clearance.assign(n, 0.0);
+            alive.assign(n, 1);
+            exit_step.assign(n, -1.0);
+            exit_wall.assign(n, -1);
+        }
+
+        Vec2 position(std::size_t i) const noexcept { return Vec2{x[i], y[i]}; }
+        /// Place particle @p i at @p p; an absorbed particle starts moving again.
+        void set_position(std::size_t i, const Vec2& p) noexcept {
+            x[i] = p.x; y[i] = p.y; clearance[i] = 0.0;
+            alive[i] = 1; exit_step[i] = -1.0; exit_wall[i] = -1;
+        }
+
+        /// Mark particle @p i absorbed at @p at after @p step steps (see exit_step).
+        void retire(std::size_t i, const Vec2& at, double step, int wall_id) noexcept {
+            x[i] = at.x; y[i] = at.y;
+            alive[i] = 0; exit_step[i] = step; exit_wall[i] = wall_id;
+        }
+
+        BrownianParams brownian(std::size_t i) const noexcept {
+            BrownianParams p;
+            p.dt = dt[i]; p.D = D[i]; p.mu_x = mu_x[i]; p.mu_y = mu_y[i];
+            return p;
+        }
+        void set_brownian(std::size_t i, const BrownianParams& p) noexcept {
+            dt[i] = p.dt; D[i] = p.D; mu_x[i] = p.mu_x; mu_y[i] = p.mu_y;
+        }
+
+        /// Zero-copy view over the position columns.
+        PositionsView positions() const noexcept { return PositionsView{x.data(), y.data(), x.size()}; }
+
+        /**
+         * @brief Reorder every column: new entry k is old entry order[k].
+         * Apply the inverse permutation to restore the original order. O(n) moves per column.
+         */
+        void permute(const std::vector<std::size_t>& order) {
+            detail::permute_vector(x, order);
+            detail::permute_vector(y, order);
+            detail::permute_vector(step_type, order);
+            detail::permute_vector(dt, order);
+            detail::permute_vector(D, order);
+            detail::permute_vector(mu_x, order);
+            detail::permute_vector(mu_y, order);
+            detail::permute_vector(spec, order);
+            detail::permute_vector(clearance, order);
+            detail::permute_vector(alive, order);
+            detail::permute_vector(exit_step, order);
+            detail::permute_vector(exit_wall, order);
+            if (!rng.empty()) detail::permute_vector(rng, order);
+        }
+
+        /// Exchange particles @p a and @p b in every column (used to compact absorbed particles).
+        void swap_entries(std::size_t a, std::size_t b) {
+            using std::swap;
+            swap(x[a], x[b]);
+            swap(y[a], y[b]);
+            swap(step_type[a], step_type[b]);
+            swap(dt[a], dt[b]);
+            swap(D[a], D[b]);
+            swap(mu_x[a], mu_x[b]);
+            swap(mu_y[a], mu_y[b]);
+            swap(spec[a], spec[b]);
+            swap(clearance[a], clearance[b]);
+            swap(alive[a], alive[b]);
+            swap(exit_step[a], exit_step[b]);
+            swap(exit_wall[a], exit_wall[b]);
+            if (!rng.empty()) swap(rng[a], rng[b]);
+        }
+    };
+
+    /// Particle store used by the runtime-dispatched Simulation.
+    using ParticleStore = BasicParticleStore<RNG>;
+
+} // namespace sim
@@ -0,0 +1,114 @@
+#pragma once
+/**
+ * @file philox_rng.hpp
+ * @brief Fixed-engine generator (Philox4x32-10 + Ziggurat) for policy-templated simulations.
+ *
+ * What the file is for:
+ *   sim::RNG selects its engine and normal sampler at run time, so every gauss() call branches
+ *   on both and goes through an out-of-line function. PhiloxRng fixes both choices at compile
+ *   time and is header-only, so a BasicSimulation<..., PhiloxRng> can inline the whole draw
+ *   into the step kernel.
+ *
+ * Equivalence:
+ *   PhiloxRng(seed, stream) produces exactly the numbers of
+ *   RNG(RngEngine::Philox4x32, seed, stream, NormalMethod::Ziggurat): same key/counter layout
+ *   (see rng.cpp), same word order, same Ziggurat tables.
+ *
+ * See also: rng.hpp (runtime-selected RNG, Philox4x32 block), ziggurat.hpp.
+ */
+
+#include <cstddef>
+#include <cstdint>
+
+#include "sim/checkpoint.hpp"
+#include "sim/rng.hpp"
+#include "sim/ziggurat.hpp"
+
+namespace sim {
+
+    class PhiloxRng {
+        public:
+            PhiloxRng() = default;
+
+            /// Key = 64-bit seed (high stream bits folded in); counter carries stream and step.
+            PhiloxRng(std::uint64_t seed, std::uint64_t stream) noexcept
+                : key_{static_cast<std::uint32_t>(seed),
+                       static_cast<std::uint32_t>(seed >> 32) ^ static_cast<std::uint32_t>(stream >> 32)},
+                  stream_(static_cast<std::uint32_t>(stream)) {}
+
+            /// Standard normal sample N(0, 1) (Ziggurat).
+            [[nodiscard]] double gauss() {
+                return ziggurat_normal([this] { return next_u64(); });
+            }
+
+            /// Fill @p out[0..n) with N(0, 1) samples; identical to n gauss() calls.
+            void fill_gauss(double* out, std::size_t n) {
+                ziggurat_fill([this] { return next_u64(); }, out, n);
+            }
+
+            /// Uniform sample in [0, 1) with 53 random bits (same mapping as RNG::uniform()).
+            [[nodiscard]] double uniform() noexcept {
+                const std::uint32_t a = next_u32();
+                const std::uint32_t b = next_u32();
+                return ((a >> 5) * 67108864.0 + (b >> 6)) * (1.0 / 9007199254740992.0);
+            }
+
+            double operator()() { return gauss(); }
+
+            /// Position the stream at the start of step @p step (see RNG::seek_step()).
+            void seek_step(std::uint64_t step) noexcept {
+                step_    = step;
+                block_   = 0;
+                buf_pos_ = 4;
+            }
+
+            static constexpr bool counter_based() noexcept { return true; }
+
+            /// Write the generator state (binary; see RNG::save()).
+            void save(std::ostream& os) const {
+                detail::write_pod(os, key_);
+                detail::write_pod(os, stream_);
+                detail::write_pod(os, step_);
+                detail::write_pod(os, block_);
+                detail::write_pod(os, buf_);
+                detail::write_pod(os, buf_pos_);
+            }
+
+            /// Restore a save()d state; throws std::runtime_error if the data is malformed.
+            void load(std::istream& is) {
+                key_     = detail::read_pod<Philox4x32::key_type>(is);
+                stream_  = detail::read_pod<std::uint32_t>(is);
+                step_    = detail::read_pod<std::uint64_t>(is);
+                block_   = detail::read_pod<std::uint32_t>(is);
+                buf_     = detail::read_pod<Philox4x32::counter_type>(is);
+                buf_pos_ = detail::read_pod<std::uint32_t>(is);
+                if (buf_pos_ > 4) throw std::runtime_error("PhiloxRng::load: bad buffer position");
+            }
+
+        private:
+            std::uint32_t next_u32() noexcept {
+                if (buf_pos_ == 4) {
+                    buf_ = Philox4x32::block(Philox4x32::counter_type{block_++, stream_,
+                                                                      static_cast<std::uint32_t>(step_),
+                                                                      static_cast<std::uint32_t>(step_ >> 32)},
+                                             key_);
+                    buf_pos_ = 0;
+                }
+                return buf_[buf_pos_++];
+            }
+
+            std::uint64_t next_u64() noexcept {
+                const std::uint32_t hi = next_u32();
+                const std::uint32_t lo = next_u32();
+                return (static_cast<std::uint64_t>(hi) << 32) | lo;
+            }
+
+            Philox4x32::key_type        key_{};
+            std::uint32_t               stream_{0};
+            std::uint64_t               step_{0};
+            std::uint32_t               block_{0};
+            Philox4x32::counter_type    buf_{};
+            std::uint32_t               buf_pos_{4};
+    };
+
+} // namespace sim
@@ -54,8 +54,9 @@
  * Extensibility:
  *   - More shapes: additional builders (polygons, circles via polygonal approx.)
  *     can compose down to wall segments.
- *   - Other boundary types: absorbing/periodic can be added in parallel modules
- *     without changing particle or RNG code.
+ *   - Absorbing walls: set_absorbing() gives walls a kill probability; advance_to_absorbing()
+ *     stops at the first contact with such a wall and reports it (the simulation retires
+ *     the particle or lets it reflect). Periodic boundaries could follow the same pattern.
  *   - Metadata: the advancer can be extended to return stats (e.g., bounce count
  *     last-hit wall id) for diagnostics.
  * 
@@ -73,8 +74,11 @@
  *   - Near-tangent "grazing" steps (stable, no-explosive behavior).
  */
 
+#include <cstdint>
+#include <limits>
 #include <vector>
 #include "sim/vec2.hpp"
+#include "sim/wall_kernels.hpp"
 
 namespace sim {
 
@@ -116,6 +120,7 @@ struct WallSegment {
     Vec2 p1;     ///< Segment end point
     Vec2 n_hat;  ///< Unit outward normal (must be normalized)
     int  id{-1}; ///< Optional identifier (used for deterministic tie-breaks).
+    double absorb{0.0}; ///< Probability that a hit absorbs the particle (0 = reflecting, 1 = absorbing).
 
     WallSegment() = default;
 
@@ -133,6 +138,38 @@ struct WallSegment {
                                              int id_ = -1);
 };
 
+/**
+ * @brief Uniform-grid broad phase for wall segments (CSR layout).
+ *
+ * Each cell lists (in ascending insertion order) the walls whose padded extent overlaps it.
+ * Padding covers the advancer's endpoint tolerance (EPS_POS in segment parameter space),
+ * so every wall that can produce a hit inside a cell is listed in that cell.
+ *
+ * Queries gather the walls of all cells overlapped by the padded displacement p -> p + v,
+ * deduplicate them and test them in insertion order; walls never gathered cannot intersect
+ * the displacement, so the earliest hit and its tie-break match the brute-force scan.
+ */
+struct WallGrid {
+    double      x0{0.0};                    ///< Grid origin (lower-left), x
+    double      y0{0.0};                    ///< Grid origin (lower-left), y
+    double      cell{0.0};                  ///< Cell edge length
+    double      inv_cell{0.0};              ///< 1 / cell
+    int         nx{0};                      ///< Cells along x
+    int         ny{0};                      ///< Cells along y
+    double      max_len{0.0};               ///< Longest wall (bounds clearance() margins in the ring search)
+    std::vector<std::uint32_t> cell_start;  ///< CSR offsets into cell_walls; size nx*ny + 1
+    std::vector<std::uint32_t> cell_walls;  ///< Wall indices per cell (ascending)
+
+    bool empty() const noexcept { return cell_start.empty(); }
+};
+
+/// Nearest wall to a query point (ReflectingWorld::nearest_wall()).
+struct NearestWall {
+    int    wall{-1};                                            ///< Index into walls; -1 if there are none.
+    double distance{std::numeric_limits<double>::infinity()};  ///< Euclidean point-segment distance.
+    Vec2   point{};                                             ///< Closest point on that wall.
+};
+
 /**
  * @brief Lightweight container of reflecting line segments with convience builders.
  * 
@@ -148,12 +185,18 @@ struct WallSegment {
  *     the advancer breaks ties deterministically by 'id' then by insertion index.
  * 
  * Scope:
- *   - No broad-phase acceleration (AABB/BVH) here; naive O(#walls) is used in the advancer.
+ *   - Broad phase is optional: without build_index() the advancer scans all walls
+ *     (O(#walls)); after build_index() it only tests walls in grid cells the swept
+ *     displacement overlaps. Hit selection and tie-breaking are identical either way.
+ *   - compile() caches the walls as aligned SoA columns so the full scan runs the SIMD
+ *     kernel (wall_kernels.hpp); again with identical hit selection.
  *   - No self-intersection checks; callers ensure a coherent world.
  *   - Mutation is not thread-safe during stepping.
  */
 struct ReflectingWorld {
     std::vector<WallSegment> walls;
+    WallGrid                 grid;      ///< Optional broad-phase index; empty until build_index().
+    CompiledWalls            compiled;  ///< Optional SoA copy of 'walls' for the SIMD scan; empty until compile().
 
     /**
      * @brief Add a segment with an explicit outward normal.
@@ -199,6 +242,68 @@ struct ReflectingWorld {
      *   - Typical half-plane for (u, v) with v>=0: n_unit=(0,1), c=0.
      */
     void add_half_plane_strip(const Vec2& n_unit, double c, double span = 1e6, int id = 200);
+
+    /**
+     * @brief Make every wall with identifier @p id absorbing with the given probability.
+     * @param probability Chance that a hit absorbs the particle, in [0, 1]; 0 restores reflection.
+     * @return Number of walls changed. Geometry (and so the index / compiled scan) is unaffected.
+     */
+    std::size_t set_absorbing(int id, double probability = 1.0);
+
+    /// True if any wall has absorb > 0. O(#walls).
+    bool has_absorbing() const noexcept;
+
+    /**
+     * @brief Build the uniform-grid broad phase over the current walls.
+     *
+     * Call once after the geometry is final. The add_* builders drop the index (it would be
+     * stale); if you edit 'walls' directly, call build_index() again or clear_index().
+     *
+     * @param cell_size Grid cell edge length; <= 0 picks one automatically (about one
+     *                  wall per cell, at most 1024 cells per axis).
+     */
+    void build_index(double cell_size = 0.0);
+
+    /// Drop the broad-phase index; the advancer falls back to the full scan.
+    void clear_index() noexcept;
+
+    /// True if build_index() has been called since the last geometry change.
+    bool has_index() const noexcept { return !grid.empty(); }
+
+    /**
+     * @brief Snapshot 'walls' into the compiled SoA form used by the SIMD full scan.
+     *
+     * Call once after the geometry is final. Like the index, the add_* builders drop it;
+     * after editing 'walls' directly call compile() again or compiled.clear().
+     */
+    void compile();
+
+    /// True if compile() has been called since the last geometry change.
+    bool is_compiled() const noexcept { return !compiled.empty(); }
+
+    /**
+     * @brief Conservative distance from @p p to the nearest wall.
+     *
+     * A lower bound on the Euclidean point-segment distance over all walls, shrunk by the
+     * advancer's endpoint tolerance and a roundoff margin: any displacement whose reach
+     * (see advance_with_clearance()) is below this value cannot produce a hit.
+     *
+     * With an index (build_index()) this uses the ring search of nearest_wall(), stopping once
+     * no unvisited wall can lower the value; otherwise all walls are scanned. Both paths return
+     * the same value.
+     *
+     * @return Clearance >= 0; +infinity for a world without walls.
+     */
+    double clearance(const Vec2& p) const noexcept;
+
+    /**
+     * @brief Exact distance from @p p to the nearest wall, with that wall and closest point.
+     *
+     * With an index (build_index()) only grid cells in rings around @p p are searched, until
+     * the ring radius exceeds the best distance; otherwise all walls are scanned. Ties go to
+     * the lowest wall index, so both paths return the same result.
+     */
+    NearestWall nearest_wall(const Vec2& p) const noexcept;
 };
 
 // ===============================
@@ -233,8 +338,47 @@ struct ReflectingWorld {
  *     stops at the last computed point and drops the leftover displacement (deterministic fail-safe).
  * 
  * Complexity:
- *      O(#wall x number_of_bounces) per call. No dynamic allocation. Thread-safe w.r.t. world (read-only).
+ *      O(#wall x number_of_bounces) per call without an index; with world.build_index(),
+ *      O(walls in overlapped cells x number_of_bounces). No per-call allocation (the broad
+ *      phase reuses a thread-local scratch buffer). Thread-safe w.r.t. world (read-only).
  */
 void advance_with_reflections(Vec2& x, Vec2 d, const ReflectingWorld& world);
 
+/**
+ * @brief advance_with_reflections() with a cached per-particle clearance (interior early-out).
+ *
+ * @p clearance is a lower bound on the distance from @p x to the nearest wall (0 = unknown).
+ * If the step's reach |d| (1 + EPS_POS) + EPS_POS is below it, x <- x + d is applied without
+ * any intersection test and the clearance shrinks by the reach (triangle inequality). Otherwise
+ * the full advancer runs and the clearance is recomputed with world.clearance().
+ *
+ * @post x is bit-identical to advance_with_reflections(x, d, world).
+ * @note Start particles with clearance = 0 and reset it whenever the world changes.
+ *       The per-step EPS_POS margin also absorbs position roundoff for |x| up to ~1e3.
+ */
+void advance_with_clearance(Vec2& x, Vec2 d, const ReflectingWorld& world, double& clearance);
+
+/// First contact with an absorbing wall reported by advance_to_absorbing().
+struct WallContact {
+    int    wall{-1};        ///< Index into world.walls of the wall reached; -1 if the step completed.
+    int    id{-1};          ///< That wall's id.
+    double absorb{0.0};     ///< That wall's absorb probability.
+    Vec2   point{};         ///< Contact point on the wall (not nudged).
+    double fraction{1.0};   ///< Fraction of the path length of d travelled up to the contact.
+};
+
+/**
+ * @brief advance_with_reflections() that stops at the first hit on a wall with absorb > 0.
+ *
+ * On such a hit, x is the contact point nudged off the wall and d the reflected remainder,
+ * exactly as a reflection would leave them: the caller either retires the particle at
+ * contact.point or calls again with (x, d) to let it reflect. Otherwise x is the final
+ * position, d = 0 and the returned wall is -1. Reflecting walls behave as in
+ * advance_with_reflections(); without absorbing walls the results are bit-identical.
+ *
+ * @param clearance Optional clearance cache (see advance_with_clearance()); recomputed after
+ *                  every full scan.
+ */
+WallContact advance_to_absorbing(Vec2& x, Vec2& d, const ReflectingWorld& world, double* clearance = nullptr);
+
 } // namespace sim 
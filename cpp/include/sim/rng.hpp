@@ -1,42 +1,169 @@
-/* 
+/*
 * @file rng.hpp
-* @brief Gaussian random number generator using Mersenne Twister.
+* @brief Gaussian random number generator with selectable engine (Mersenne Twister or Philox)
+*        and normal sampler (legacy or Ziggurat).
 */
 
 #pragma once
+#include <array>
+#include <cstddef>
 #include <cstdint>
+#include <iosfwd>
+#include <memory>
 #include <random>
 
 /*
 * @class RNG
 * @brief Generates standard normal random numbers (mean 0, stddev 1).
-* 
-* Backed by 'std::mt19937'. Default construction is intended to seed from
-* hardware entropy (see .cpp), and an overload allows deterministic seeding
-* for reproducible simulations.
 *
-* @note: Not thread-safe. Prefer one RNG instance per thread
+* Two engines are available:
+*   - RngEngine::MT19937: 'std::mt19937' + 'std::normal_distribution' (legacy; default).
+*     Default construction seeds from hardware entropy (see .cpp), and an overload
+*     allows deterministic seeding for reproducible simulations. Kept bit-compatible
+*     with earlier runs.
+*   - RngEngine::Philox4x32: counter-based Philox4x32-10. Output is a pure function of
+*     (seed, stream, step, draw index), so per-stream state is a few dozen bytes, any
+*     step can be regenerated with seek_step() without replaying earlier steps, and
+*     independent streams need no coordination (parallel/SIMD friendly).
+*
+* Two normal samplers are available (NormalMethod):
+*   - Legacy: std::normal_distribution for MT19937, Box-Muller for Philox.
+*   - Ziggurat: 256-layer table method (ziggurat.hpp); same numbers with any standard
+*     library, cheaper per draw, and fill_gauss() evaluates its fast path in bulk.
+*
+* @note: Not thread-safe. Prefer one RNG instance per thread (or per particle).
 */
 
 namespace sim {
 
+/// Underlying bit generator used by RNG.
+enum class RngEngine {
+    MT19937,        ///< std::mt19937 + std::normal_distribution (legacy, ~5 KB state).
+    Philox4x32      ///< Counter-based Philox4x32-10 keyed by (seed, stream, step).
+};
+
+/// Algorithm used to turn uniform bits into N(0, 1) variates.
+enum class NormalMethod {
+    Legacy,         ///< MT19937: std::normal_distribution (old runs); Philox: Box-Muller.
+    Ziggurat        ///< Table-based Ziggurat; portable across standard libraries.
+};
+
+/**
+ * @brief Philox4x32-10 block function (Salmon et al., "Parallel random numbers: as easy
+ *        as 1, 2, 3", SC'11). Stateless: maps (counter, key) to four 32-bit words.
+ */
+struct Philox4x32 {
+    using counter_type = std::array<std::uint32_t, 4>;
+    using key_type     = std::array<std::uint32_t, 2>;
+
+    static counter_type block(counter_type ctr, key_type key) noexcept {
+        constexpr std::uint32_t M0 = 0xD2511F53u, M1 = 0xCD9E8D57u;
+        constexpr std::uint32_t W0 = 0x9E3779B9u, W1 = 0xBB67AE85u;
+        for (int r = 0; r < 10; ++r) {
+            if (r > 0) { key[0] += W0; key[1] += W1; }
+            const std::uint64_t p0 = static_cast<std::uint64_t>(M0) * ctr[0];
+            const std::uint64_t p1 = static_cast<std::uint64_t>(M1) * ctr[2];
+            const std::uint32_t hi0 = static_cast<std::uint32_t>(p0 >> 32), lo0 = static_cast<std::uint32_t>(p0);
+            const std::uint32_t hi1 = static_cast<std::uint32_t>(p1 >> 32), lo1 = static_cast<std::uint32_t>(p1);
+            ctr = counter_type{hi1 ^ ctr[1] ^ key[0], lo1, hi0 ^ ctr[3] ^ key[1], lo0};
+        }
+        return ctr;
+    }
+};
+
 class RNG {
     public:
-        /// Seed from hardware entropy (implementation in .cpp).
+        /// Seed from hardware entropy (implementation in .cpp). Uses MT19937.
         RNG();
 
-        /// Deterministic seeding for reproducibility.
+        /// Deterministic seeding for reproducibility. Uses MT19937 (legacy streams).
         explicit RNG(unsigned int seed);
 
+        /**
+         * @brief Deterministic seeding with an explicit engine.
+         * @param engine  Bit generator to use.
+         * @param seed    Seed (MT19937 uses the low 32 bits; Philox uses all 64 as its key).
+         * @param stream  Independent stream id (e.g., particle index). Philox places it in the
+         *                counter; MT19937 has no streams and uses seed + stream (legacy policy).
+         * @param normal  Normal sampler used by gauss() / fill_gauss().
+         */
+        RNG(RngEngine engine, std::uint64_t seed, std::uint64_t stream = 0,
+            NormalMethod normal = NormalMethod::Legacy);
+
+        RNG(const RNG& other);
+        RNG& operator=(const RNG& other);
+        RNG(RNG&&) noexcept = default;
+        RNG& operator=(RNG&&) noexcept = default;
+        ~RNG() = default;
+
         /// Draw a standard normal sample N(0, 1).
         [[nodiscard]] double gauss();
 
+        /**
+         * @brief Fill @p out[0..n) with N(0, 1) samples.
+         * Always identical to n successive gauss() calls; with NormalMethod::Ziggurat the
+         * fast path is evaluated for a whole chunk at once.
+         */
+        void fill_gauss(double* out, std::size_t n);
+
+        /// Draw a uniform sample in [0, 1) with 53 random bits.
+        [[nodiscard]] double uniform();
+
         /// Convenience: same as gauss().
         double operator()() { return gauss(); }
 
+        /**
+         * @brief Position a counter-based stream at the start of step @p step.
+         *
+         * Philox: subsequent draws are (seed, stream, step, 0), (.., 1), ...; so the numbers of
+         * any step can be regenerated directly. MT19937: no-op (sequential stream).
+         */
+        void seek_step(std::uint64_t step) noexcept;
+
+        /// Engine selected at construction.
+        RngEngine engine() const noexcept { return engine_; }
+
+        /// Normal sampler selected at construction.
+        NormalMethod normal_method() const noexcept { return normal_; }
+
+        /// True for engines whose output is addressed by (seed, stream, step) counters.
+        bool counter_based() const noexcept { return engine_ == RngEngine::Philox4x32; }
+
+        /**
+         * @brief Write the complete generator state (engine, sampler, buffered variates) in
+         *        binary form; load() restores a generator that continues the same sequence.
+         *        MT19937 state is stored as the uint32 words of the engine's text form
+         *        (~2.5 KB per generator). That form differs between standard libraries, so
+         *        it is tagged with the writer's library and load() rejects a mismatch.
+         */
+        void save(std::ostream& os) const;
+
+        /// Restore a save()d state; throws std::runtime_error if the data is malformed.
+        void load(std::istream& is);
+
     private:
-        std::mt19937 gen;
-        std::normal_distribution<double> dist{0.0, 1.0};
+        /// Legacy engine state (~5 KB); heap-allocated so Philox RNGs stay small.
+        struct MtState {
+            std::mt19937 gen;
+            std::normal_distribution<double> dist{0.0, 1.0};
+        };
+
+        std::uint32_t next_u32();
+        std::uint64_t next_u64();
+
+        RngEngine                   engine_{RngEngine::MT19937};
+        NormalMethod                normal_{NormalMethod::Legacy};
+        std::unique_ptr<MtState>    mt_;
+
+        // Philox state: key = seed; counter = {block, stream_lo, step_lo, step_hi}.
+        Philox4x32::key_type        key_{};
+        std::uint32_t               stream_{0};
+        std::uint64_t               step_{0};
+        std::uint32_t               block_{0};      ///< Next block index within the current step.
+        Philox4x32::counter_type    buf_{};         ///< Current output block.
+        std::uint32_t               buf_pos_{4};    ///< Next unused word in buf_ (4 = empty).
+        bool                        has_spare_{false};
+        double                      spare_{0.0};    ///< Second Box-Muller variate.
     };
 
-} // namespace sim
\ No newline at end of file
+} // namespace sim
@@ -15,61 +15,30 @@
  * Public-skeleton note: heavy implementations live in .cpp files and may be compiled to throw
  * (e.g., when PUBLIC_SKELETON is enabled).
  * 
+ * Simulation is a runtime-dispatched facade over BasicSimulation<MixedStep, ReflectingWorld, RNG>
+ * (basic_simulation.hpp): run() groups particles by step model and runs each group with a
+ * specialized step policy. Code that knows its step model, geometry and RNG at compile time can use
+ * BasicSimulation directly.
+ *
  * Key types: sim::Simulation, sim::SimulationConfig, sim::StepType, BrownianParams, SpecifiedStepParams.
- * @see sim::reflecting_world.hpp, sim::step_generators.hpp
+ * @see sim::basic_simulation.hpp, sim::reflecting_world.hpp, sim::step_generators.hpp, sim::particle_store.hpp
  */
 
 #include <cstddef>
+#include <string>
 #include <vector>
-#include <functional>
 
 #include "sim/vec2.hpp"
 #include "sim/rng.hpp"
 #include "sim/reflecting_world.hpp"
 #include "sim/step_generators.hpp"
+#include "sim/particle_store.hpp"
+#include "sim/basic_simulation.hpp"
 
 namespace sim {
 
-    /**
-     * @enum StepType
-     * @brief Selects the step model used to advance a particle.
-     * 
-     * Use this to choose how each particle's position increment is generated 
-     * during a simulation step.
-     * 
-     * - StepType::Brownian - Use a Brownian/gaussian step generator
-     *                         (see @ref BrownianParams for defaults).
-     * - StepType::Specified - Use a caller-provided step generator (e.g., a 
-     *                         mapping steps).
-     */
-    enum class StepType {
-        Brownian,       ///< Step Brownian (Gaussian) increments.
-        Specified       ///< Externally specified step generator per particle.
-    };
-
-    /**
-     * @struct SimulationConfig
-     * @brief Run-wide settings for a simulation.
-     * 
-     * Notes: 
-     * - History storage can be memory-intensive; use 'store_every' to decimate.
-     * - If 'deterministic == true', each particle's RNG is seeded with
-     *   'base_seed + particle_index', ensuring reproducible runs.
-     */
-    struct SimulationConfig {
-        std::size_t n_particles     {1};        ///< Number of independent particles to simulate. @pre n_particles >=1.
-        std::size_t n_steps         {0};        ///< Total number of integration steps to run. @pre n_steps >= 0.
-
-        bool        record_history  {true};     ///< If true, store particle trajectories for post-analysis.
-        std::size_t store_every     {1};        ///< Keep 1 of every k frames (decimation factor). @pre store_every >= 1.
-
-        // RNG policy
-        unsigned int base_seed      {5489u};    ///< Base seed used to derive per-particle seeds.
-        bool         deterministic  {true};     ///< If true, per-particle seed = base_seed + i; if false, use hardware seeding.
-
-        // Default Brownian parameters (can be overridden per particle if desired)
-        BrownianParams brownian{};              ///< Default Gaussian step configuration for StepType::Brownian.
-    };
+    // Runtime-dispatched core; compiled once in simulation.cpp.
+    extern template class BasicSimulation<MixedStep, ReflectingWorld, RNG>;
 
     /**
      * @brief Simulation driver: manages particles, applies step generators, and enforces reflections.
@@ -79,6 +48,10 @@ namespace sim {
      *   - By default, BrownianParams from SimulationConfig are used for Brownian particles.
      *   - A custom specified-step callback can be provided (e.g., time-/state-dependent).
      *   - Public-skeleton: heavy logic lives in .cpp and may be compiled to throw when PUBLIC_SKELETON is defined.
+     *   - run() picks the step policies once per call: mixed populations are grouped by step
+     *     model (and Brownian params) and each group runs BrownianStep or CallbackStep /
+     *     SpecifiedParamsStep; particle order in positions() and history() is unchanged.
+     *     All choices give bit-identical results to the per-particle MixedStep path.
      */
     class Simulation {
         public:
@@ -97,12 +70,10 @@ namespace sim {
              * 
              * @note Reflections against boundaries defined by @ref ReflectingWorld are applied
              *       by the simulation after this displacement is generated
+             * @note With @ref SimulationConfig::n_threads > 1 the callback is invoked concurrently
+             *       for different particles; it must be safe to call from several threads.
              */
-            using SpecifiedCallback = 
-                std::function<Vec2(std::size_t particle_index,
-                                   std::size_t step_index,
-                                   const Vec2& position,
-                                   RNG& rng)>;
+            using SpecifiedCallback = ::sim::SpecifiedCallback;
 
             /**
              * @brief Construct a simulation bound to a reflecting world.
@@ -183,6 +154,30 @@ namespace sim {
              */
             void set_position(std::size_t i, const Vec2& p);
 
+            /**
+             * @brief Stream recorded frames to a sink instead of keeping them in history().
+             * @param sink Destination (not owned; must outlive the runs), or nullptr for the
+             *             in-memory history.
+             * @param first_frame Frames @p sink already holds; pass streamed_frames() to continue
+             *                    a stream after load_checkpoint().
+             * @note Frames are written on a background thread in blocks bounded by
+             *       @ref SimulationConfig::history_buffer_bytes; history() stays empty.
+             * @see HistorySink, BinaryHistoryFileSink, CallbackHistorySink
+             */
+            void set_history_sink(HistorySink* sink, std::size_t first_frame = 0);
+
+            /**
+             * @brief Attach an observer that sees the positions at its output times during run().
+             * @param observer Accumulator (not owned; must outlive the runs), e.g. a HistogramObserver.
+             * @note Output 0 is the positions at the start of the next run(); then one output every
+             *       observer->every() steps. Works with @c record_history == false.
+             * @see PositionObserver, HistogramObserver
+             */
+            void add_observer(PositionObserver* observer);
+
+            /// @brief Detach all observers.
+            void clear_observers() noexcept;
+
             /**
              * @brief Run the simulation for @c config().n_steps steps.
              * 
@@ -195,20 +190,92 @@ namespace sim {
              * @complexity O(n_particles * n_steps)
              * @note RNG seeding follows @ref SimulationConfig::deterministic and
              *       @ref SimulationConfig::base_seed (per-particle @c base_seed + i).
+             * @note With @ref SimulationConfig::n_threads != 1, particles are split into contiguous
+             *       ranges advanced concurrently; positions() and history() are bit-identical to the
+             *       serial run. Exceptions from step generators are rethrown on the calling thread.
+             * @note @ref SimulationConfig::loop_order selects step-major or particle-major (tiled)
+             *       traversal within each range; both give identical results.
+             * @note Finishes the current run instead when one is in progress (run_until(),
+             *       load_checkpoint()).
              */
             void run();
 
+            /**
+             * @brief Advance the current run to its step @p step; reaching n_steps completes it.
+             *
+             * Splitting a run into run_until() segments gives bit-identical results to run():
+             * the callback and specified_step() see the same step index k (counted from the
+             * start of the run), history frames stay on the store_every grid and observer
+             * outputs keep their numbering. Between segments positions(), history() and
+             * attached observers are up to date, so output can be interleaved with stepping.
+             * A streamed history keeps its writer for the whole run; frames recorded so far may
+             * wait in its buffer until it fills, the run ends, or save_checkpoint() /
+             * set_history_sink() is called.
+             * @throws std::out_of_range unless run_position() < step <= config().n_steps
+             *         (nothing is run).
+             */
+            void run_until(std::size_t step);
+
+            /**
+             * @brief Advance @p k steps: continue the current run, completing it and starting
+             *        new runs as needed (the same as back-to-back run() calls when summed up).
+             */
+            void run_steps(std::size_t k);
+
+            /// Steps of the current run already done; 0 between runs.
+            std::size_t run_position() const noexcept;
+
+            // ---- Checkpoints ----
+
+            /**
+             * @brief Save the complete state (particles, RNG streams, history, observers) to @p path.
+             * @note Also written automatically during run() with
+             *       @ref SimulationConfig::checkpoint_every. The file is replaced atomically.
+             * @throws std::runtime_error on I/O errors or an observer without save_state().
+             */
+            void save_checkpoint(const std::string& path) const;
+
+            /**
+             * @brief Restore a saved state; the next run() finishes an interrupted run.
+             * @pre The simulation uses the same world, callback and observers, and its config
+             *      matches the saved one in n_particles, n_steps, store_every, record_history,
+             *      rng_engine and normal_method.
+             * @throws std::runtime_error on a mismatch or an unreadable file.
+             */
+            void load_checkpoint(const std::string& path);
+
+            /// Frames delivered to the history sink so far (see set_history_sink()).
+            std::size_t streamed_frames() const noexcept;
+
             // ---- Accessors ----
 
             /**
              * @brief Current particle positions.
-             * @return Reference to a vector of size @c n_particles.
+             * @return Zero-copy view of size @c n_particles over the SoA x[]/y[] columns.
+             * @note Use @c positions().to_vector() (or assign to a std::vector<Vec2>) for an
+             *       owning copy. The view is valid until the simulation is destroyed.
+             */
+            PositionsView positions() const noexcept;
+
+            /**
+             * @brief Column-wise per-particle state (positions, params, RNGs).
+             * @return Read-only reference to the particle store.
              */
-            const std::vector<Vec2>& positions() const noexcept;
+            const ParticleStore& particles() const noexcept;
+
+            /**
+             * @brief Number of particles absorbed by walls made absorbing with
+             *        ReflectingWorld::set_absorbing().
+             * @note For each particle, particles().alive, exit_step (steps from the first run(),
+             *       including the fraction of the last one; multiply by dt for a time) and
+             *       exit_wall give the first-passage record; positions() holds the exit point.
+             */
+            std::size_t n_absorbed() const noexcept;
 
             /**
              * @brief Recorded trajectories (if enabled).
-             * @return Vector of per-particle polylines; empty if @c record_history == false.
+             * @return Vector of per-particle polylines; empty if @c record_history == false
+             *         or a history sink is attached.
              * @note Decimated by @ref SimulationConfig::stor_every.
              */
             const std::vector<std::vector<Vec2>>& history() const noexcept;
@@ -220,22 +287,12 @@ namespace sim {
             const SimulationConfig& config() const noexcept;
 
         private:
-            // Not owned; world geometry and reflection policy.
-            const ReflectingWorld*  world_;
-
-            // Effective configuration for this run.
-            SimulationConfig        cfg_;
-
-            // State
-            std::vector<Vec2>                   pos_;               ///< Current positions.
-            std::vector<std::vector<Vec2>>      hist_;              ///< Trajectories (optional).
-            std::vector<StepType>               step_type_;         ///< Per-particle step model.
-            std::vector<BrownianParams>         brownian_params_;   ///< Per-particle Brownian overrides.
-
-            // Randomness & specified-step configuration
-            std::vector<RNG>                    rngs_;              ///< Rer-particle RNGs
-            std::vector<SpecifiedStepParams>    spec_params_;       ///< Per-particle specified-step params
-            SpecifiedCallback                   specified_cb_{};    ///< Optional specified-step callback.
+            using Core = BasicSimulation<MixedStep, ReflectingWorld, RNG>;
+
+            Core core_;     ///< Particle state, history, execution; MixedStep holds the callback.
+
+            /// Pick the step policies for the current step types and advance to @p until.
+            void advance(std::size_t until);
     };
 
 } // namespace sim
\ No newline at end of file
@@ -8,6 +8,8 @@
  * 
  * Included models:
  *   - Brownian (Euler-Maruyama): dx = mu * dt + sqrt(2*d*dt) ξ,  ξ ~ N(0, I₂).
+ *   - Batched Brownian: same formula for N particles at once from a block of
+ *     pre-drawn normals (AVX-512 / AVX2 / scalar paths, selected at compile time).
  *   - Specified (mapped/user-supplied) step: interface only in the public skeleton.
  * 
  * Responsibilities:
@@ -58,6 +60,57 @@
      */
     Vec2 brownian_step(const BrownianParams& p, ::sim::RNG& rng) noexcept;
 
+    /**
+     * @brief Precomputed per-group Brownian coefficients.
+     *
+     * Hoists sqrt(2*D*dt) and mu*dt out of the per-step path; one instance serves every
+     * particle that shares the same BrownianParams.
+     */
+    struct BrownianCoeffs {
+        double sigma    {0.0};  ///< sqrt(2 * D * dt)
+        double drift_x  {0.0};  ///< mu_x * dt
+        double drift_y  {0.0};  ///< mu_y * dt
+    };
+
+    /// Build BrownianCoeffs from parameters (same arithmetic as brownian_step).
+    BrownianCoeffs brownian_coeffs(const BrownianParams& p) noexcept;
+
+    /**
+     * @brief Batched Brownian displacements for a homogeneous group.
+     *
+     * Computes dx[j] = drift_x + sigma * gx[j], dy[j] = drift_y + sigma * gy[j] for j < n.
+     * With the same normals, results equal brownian_step() for the originating params
+     * (up to FMA contraction if the compiler fuses the scalar path).
+     *
+     * @param c       Precomputed coefficients shared by all n entries.
+     * @param n       Number of displacements.
+     * @param gx,gy   Standard normal draws (x and y), length n.
+     * @param dx,dy   [out] Displacement components, length n. May not alias gx/gy.
+     */
+    void brownian_fill(const BrownianCoeffs& c,
+                       std::size_t n,
+                       const double* gx, const double* gy,
+                       double* dx, double* dy) noexcept;
+
+    /**
+     * @brief Batched Brownian displacements with per-entry parameters (SoA columns).
+     *
+     * Computes dx[j] = mu_x[j]*dt[j] + sqrt(2*D[j]*dt[j]) * gx[j] (same for y) for j < n.
+     *
+     * @param n                     Number of displacements.
+     * @param dt,D,mu_x,mu_y        Parameter columns, length n.
+     * @param gx,gy                 Standard normal draws, length n.
+     * @param dx,dy                 [out] Displacement components, length n.
+     */
+    void brownian_fill(std::size_t n,
+                       const double* dt, const double* D,
+                       const double* mu_x, const double* mu_y,
+                       const double* gx, const double* gy,
+                       double* dx, double* dy) noexcept;
+
+    /// Instruction set the batched kernels were compiled for: "avx512", "avx2" or "scalar".
+    const char* brownian_fill_isa() noexcept;
+
     /**
      * @brief Parameters for a position-dependent "specified" step (public skeleton).
      * 
@@ -0,0 +1,23 @@
+#pragma once
+/**
+ * @file strict_fp.hpp
+ * @brief Turn off floating-point contraction (FMA) for the rest of the including file.
+ *
+ * What the file is for:
+ *   The SIMD wall kernels and the scalar advancer must pick bit-identical hits (see
+ *   wall_kernels.hpp, Equivalence). On FMA-capable targets (-march=native, -mfma) GCC and
+ *   Clang would fuse a*b - c*d in the scalar code but not in the explicit mul/sub
+ *   intrinsics, and t or x would differ in the last ulp. Including this header disables
+ *   contraction in that translation unit, whatever flags the build passes.
+ *
+ * Usage:
+ *   Include it FIRST in a .cpp file (before its own header), so that inline functions from
+ *   later includes (Vec2 helpers, cross2) are compiled under the same setting. Do not
+ *   include it from headers.
+ */
+
+#if defined(__clang__)
+#pragma clang fp contract(off)
+#elif defined(__GNUC__)
+#pragma GCC optimize("fp-contract=off")
+#endif
@@ -0,0 +1,156 @@
+#pragma once
+/**
+ * @file sweep.hpp
+ * @brief Parameter-sweep tasks: params_list.txt rows run in-process, results.txt per row.
+ *
+ * What the file is for:
+ *   The SLURM array scripts used to write a params module and recompile the Fortran solver for
+ *   every row of params_list.txt, spending tens of seconds in the compiler per parameter set.
+ *   The mc_sweep driver (cpp/apps/mc_sweep.cpp) is built once and runs any number of rows: each
+ *   row configures a simulation at runtime and writes its results.txt in the directory layout
+ *   the scripts and visualization steps already use.
+ *
+ * Rows (generate_params.sh): "tf d x0 y0 nsteps nreals nbins", whitespace-separated; blank
+ *   lines and lines starting with '#' are skipped.
+ *
+ * Model: nreals particles start at (x0, y0) and take nsteps Brownian steps of dt = tf / nsteps
+ *   with diffusion coefficient d, reflecting off the domain boundary:
+ *     - Quarter: quarter plane x, y >= 0 (BoxWorld with infinite upper bounds),
+ *     - Eighth:  wedge 0 <= theta <= pi/4 (WedgeWorld).
+ *   Both use the closed-form reflections of analytic_worlds.hpp.
+ *
+ * Packing: rows with the same nsteps can share one simulation (run_sweep_pack()): each row is a
+ *   contiguous particle range with its own start, BrownianParams (dt, d) and the RNG streams
+ *   it would use alone (BasicSimulation::assign_streams()), and its statistics are taken from
+ *   its own range. A packed row gives the same results.txt as the row run by itself, while
+ *   small rows share one thread pool, one setup and one pass over the steps.
+ *
+ * Local scheduling: without SLURM, run_sweep_local() cuts rows into particle chunks
+ *   (plan_sweep_chunks()) and runs them on a work-stealing loop (work_stealing_for() in
+ *   parallel.hpp), so one long row and many short ones keep every core busy. Chunk [first,
+ *   first + count) of a row draws the RNG streams of those particles in the whole row, so
+ *   histogram counts equal run_sweep_row(); chunk results are merged in chunk order, so
+ *   moments are the same for any thread count and agree with run_sweep_row() to rounding.
+ *
+ * results.txt:
+ *   '#' header lines (geometry, the row, grid extent, out-of-grid count, moments of the final
+ *   x, y, r with standard errors), then one line per grid bin "x y count density" with the bin
+ *   center, the number of particles in it at tf and count / (nreals * bin area). The grid is
+ *   nbins x nbins over [0, L)^2, L = max(x0, y0) + 6 sqrt(2 d tf).
+ *
+ * Errors: malformed rows (including rows with L <= 0, e.g. d = 0 at the origin), rows whose
+ *   start lies outside the geometry's domain (checked when the rows are run, since parsing
+ *   does not know the geometry) and unwritable outputs throw std::runtime_error.
+ */
+
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+#include "sim/observers.hpp"
+#include "sim/rng.hpp"
+
+namespace sim {
+
+    /// Domain of a sweep (which SLURM script / output tree).
+    enum class SweepGeometry {
+        Quarter,    ///< Quarter plane, results under Quarter_plane/
+        Eighth      ///< Eighth-plane wedge, results under Eighth_Wedge/
+    };
+
+    /// One params_list.txt row.
+    struct SweepParams {
+        double      tf{0.0};        ///< Final time.
+        double      d{0.0};         ///< Diffusion coefficient.
+        double      x0{0.0};        ///< Start position.
+        double      y0{0.0};
+        std::size_t nsteps{0};      ///< Time steps (dt = tf / nsteps).
+        std::size_t nreals{0};      ///< Realizations (particles).
+        std::size_t nbins{0};       ///< Histogram bins per axis.
+
+        std::array<std::string, 7> text;    ///< Fields as written; used verbatim in output paths, like the scripts.
+    };
+
+    /// Run settings shared by every row.
+    struct SweepOptions {
+        SweepGeometry geometry{SweepGeometry::Quarter};
+        std::string   out_root{"."};        ///< Directory holding Quarter_plane/ or Eighth_Wedge/.
+        std::size_t   n_threads{1};         ///< Threads per simulation (run_sweep_local(): workers); 0 = hardware concurrency.
+        std::size_t   pack_particles{0};    ///< Pack rows into simulations of up to this many particles (0 = one row each).
+        std::size_t   chunk_particles{0};   ///< run_sweep_local(): particles per chunk (0 = whole rows).
+        unsigned int  base_seed{5489u};     ///< As SimulationConfig::base_seed (same seeds for every row).
+        RngEngine     rng_engine{RngEngine::MT19937};
+    };
+
+    /// Work item of run_sweep_local(): particles [first, first + count) of row @c row.
+    struct SweepChunk {
+        std::size_t row{0};
+        std::size_t first{0};
+        std::size_t count{0};
+    };
+
+    /// Final-time statistics of one row.
+    struct SweepResult {
+        HistogramObserver histogram;        ///< Grid histogram; output 0 = start, output 1 = positions at tf.
+        MomentObserver    moments;          ///< Moments of x, y, r (about the origin), outputs as histogram.
+        double            extent{0.0};      ///< Grid side L.
+    };
+
+    /// Parse one row; throws std::runtime_error if it does not have seven valid fields.
+    SweepParams parse_sweep_row(const std::string& line);
+
+    /// Parse every row of a params_list.txt stream (skipping blanks and comments).
+    std::vector<SweepParams> read_params_list(std::istream& is);
+
+    /// Same as read_params_list() on the file at @p path.
+    std::vector<SweepParams> read_params_list(const std::string& path);
+
+    /// "<root>/Quarter_plane/<nreals>_realizations/<nsteps>_time_steps/Initial_pos_X0_<x0>_Y0_<y0>/t_<tf>/d_<d>".
+    std::string sweep_output_dir(const SweepParams& p, SweepGeometry geometry, const std::string& root);
+
+    /**
+     * @brief Group row indices into packs: rows with equal nsteps, in order of appearance, up to
+     *        @p max_particles realizations per pack (a larger row gets a pack of its own).
+     *        max_particles = 0 gives one pack per row.
+     */
+    std::vector<std::vector<std::size_t>> plan_sweep_packs(const std::vector<SweepParams>& rows,
+                                                           std::size_t max_particles);
+
+    /**
+     * @brief Simulate @p rows in one population; results in row order (see file notes).
+     * @throws std::invalid_argument if the rows do not share nsteps.
+     */
+    std::vector<SweepResult> run_sweep_pack(const std::vector<SweepParams>& rows, const SweepOptions& opt);
+
+    /// Simulate one row.
+    SweepResult run_sweep_row(const SweepParams& p, const SweepOptions& opt);
+
+    /// Cut every row into chunks of @p chunk_particles particles (the last one smaller); 0 = whole rows.
+    std::vector<SweepChunk> plan_sweep_chunks(const std::vector<SweepParams>& rows, std::size_t chunk_particles);
+
+    /// Called by run_sweep_local() with each finished row (index into the rows given).
+    using SweepRowDone = std::function<void(std::size_t row, const SweepResult& result)>;
+
+    /**
+     * @brief Run @p rows as chunks of opt.chunk_particles on opt.n_threads work-stealing threads
+     *        (see file notes); pack_particles is not used.
+     *
+     * @p done runs once per row, as soon as its last chunk finishes, on whichever worker ran
+     * that chunk; calls for different rows may overlap. Exceptions (from a chunk or @p done)
+     * stop the scheduler and are rethrown here.
+     */
+    void run_sweep_local(const std::vector<SweepParams>& rows, const SweepOptions& opt, const SweepRowDone& done);
+
+    /// Write @p r as results.txt content (see file notes).
+    void write_sweep_results(std::ostream& os, const SweepParams& p, SweepGeometry geometry, const SweepResult& r);
+
+    /// Write results.txt for @p p under sweep_output_dir(); returns the file path.
+    std::string save_sweep_results(const SweepParams& p, const SweepOptions& opt, const SweepResult& r);
+
+    /// run_sweep_row() and save_sweep_results().
+    std::string run_sweep_task(const SweepParams& p, const SweepOptions& opt);
+
+} // namespace sim
@@ -0,0 +1,110 @@
+#pragma once
+/**
+ * @file walk_on_spheres.hpp
+ * @brief Walk-on-spheres estimator for Dirichlet (exit) problems on ReflectingWorld geometry.
+ *
+ * What the file is for:
+ *   Estimating u(x0) = E[g(X_exit)] (harmonic functions with boundary data g, exit
+ *   distributions) with time-stepped Brownian motion needs many small steps per walk. Walk on
+ *   spheres jumps straight to a uniform point on the largest empty circle around the walker,
+ *   ReflectingWorld::nearest_wall(), until it is within epsilon of a wall; a walk typically
+ *   takes O(log 1/epsilon) jumps. Build the world's index (build_index()) so the distance
+ *   query only searches nearby cells.
+ *
+ * Core concepts:
+ *   - WosConfig: walks per query point, stopping distance, step cap, threads and the RNG
+ *     policy (same fields and meaning as SimulationConfig).
+ *   - WalkOnSpheres::estimate(): Moments of g at the exit points (mean = estimate of u(x0),
+ *     std_error() its Monte Carlo error), of the number of jumps, and exits per wall
+ *     (harmonic measure). Walks that do not finish (step cap, no wall in reach) are counted
+ *     separately and excluded from the moments.
+ *
+ * Reproducibility:
+ *   Walk j of query q draws from the stream of particle first_walk + q * n_walks + j of a
+ *   Simulation with the same seeding fields (seed_rngs()); Philox streams are re-seeked per
+ *   jump. Walks are accumulated in fixed chunks of kWosChunk merged in chunk order, so for
+ *   deterministic seeds results are bit-identical for any n_threads, with or without index.
+ *
+ * See also: reflecting_world.hpp (nearest_wall, build_index), observers.hpp (Moments).
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "sim/vec2.hpp"
+#include "sim/rng.hpp"
+#include "sim/reflecting_world.hpp"
+#include "sim/observers.hpp"
+#include "sim/parallel.hpp"
+
+namespace sim {
+
+    /// Walks per accumulation chunk (fixed, so the merge order does not depend on threads).
+    constexpr std::size_t kWosChunk = 256;
+
+    /// Run settings for WalkOnSpheres.
+    struct WosConfig {
+        std::size_t  n_walks        {1000};     ///< Walks per query point. @pre n_walks >= 1.
+        double       epsilon        {1e-6};     ///< A walk exits once the nearest wall is within epsilon. @pre epsilon > 0.
+        std::size_t  max_steps      {100000};   ///< Jumps per walk before it is abandoned (counted in n_unfinished).
+        std::size_t  n_threads      {1};        ///< Threads per query; 0 = hardware concurrency.
+
+        // RNG policy (as in SimulationConfig)
+        unsigned int base_seed      {5489u};    ///< Base seed used to derive per-walk seeds.
+        bool         deterministic  {true};     ///< If false, seed from hardware entropy.
+        std::size_t  first_walk     {0};        ///< Global index of walk 0 of query 0 (offsets the streams, as first_particle).
+        RngEngine    rng_engine     {RngEngine::MT19937}; ///< MT19937 or counter-based Philox4x32.
+    };
+
+    /**
+     * @brief Boundary data g: value at an exit point on wall @p wall_id (WallSegment::id).
+     * Called concurrently from worker threads when n_threads > 1.
+     */
+    using BoundaryValue = std::function<double(const Vec2& exit_point, int wall_id)>;
+
+    /// Result for one query point.
+    struct WosEstimate {
+        Moments                     value;          ///< g at the exit points of finished walks.
+        Moments                     steps;          ///< Jumps per finished walk.
+        std::vector<std::uint64_t>  exits;          ///< Finished walks per wall index (harmonic measure).
+        std::uint64_t               n_unfinished{0};///< Walks that hit max_steps or had no wall in reach.
+
+        /// Merge another estimate for the same point (chunk order matters for bit-identity).
+        void merge(const WosEstimate& other);
+    };
+
+    /**
+     * @brief Walk-on-spheres engine bound to a world (not owned).
+     *
+     * Walls are treated as the Dirichlet boundary regardless of their normals or absorb
+     * flags; start points must lie inside the domain they enclose.
+     */
+    class WalkOnSpheres {
+        public:
+            WalkOnSpheres(const ReflectingWorld& world, const WosConfig& cfg);
+
+            /**
+             * @brief Run config().n_walks walks from @p x0.
+             * @param query Query number q selecting the walks' streams (see file notes).
+             */
+            WosEstimate estimate(const Vec2& x0, const BoundaryValue& g, std::size_t query = 0);
+
+            /// estimate(points[q], g, q) for every point.
+            std::vector<WosEstimate> estimate(const std::vector<Vec2>& points, const BoundaryValue& g);
+
+            const WosConfig& config() const noexcept { return cfg_; }
+            const ReflectingWorld& world() const noexcept { return *world_; }
+
+        private:
+            /// Walks [first, first + count) of one chunk; first is the global walk index.
+            WosEstimate run_chunk(const Vec2& x0, const BoundaryValue& g, std::size_t first, std::size_t count) const;
+
+            const ReflectingWorld*      world_;     ///< Not owned.
+            WosConfig                   cfg_;
+            std::unique_ptr<ThreadPool> pool_;      ///< Lazily created when n_threads > 1.
+    };
+
+} // namespace sim
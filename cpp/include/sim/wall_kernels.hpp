@@ -0,0 +1,116 @@
+#pragma once
+/**
+ * @file wall_kernels.hpp
+ * @brief Compiled (structure-of-arrays) wall data and batched segment-intersection kernels.
+ *
+ * What the file is for:
+ *   advance_with_reflections() scans walls for the earliest time of impact on every step.
+ *   Stored as an array of WallSegment structs, each scan recomputes s = p1 - p0 and tests
+ *   one wall at a time. CompiledWalls keeps p0, s, n_hat and id in separate 64-byte aligned
+ *   columns (padded to a multiple of 8), so the kernel can test 4 (AVX2) or 8 (AVX-512)
+ *   walls per instruction.
+ *
+ * Core concepts:
+ *   - CompiledWalls: immutable snapshot of a wall list; build once after the geometry is
+ *     final (ReflectingWorld::compile()) and reuse for every step.
+ *   - WallHit: earliest hit found so far (t, insertion index, id, normal).
+ *   - scan_walls(): SIMD kernel chosen at compile time (-mavx512f / -mavx2 / -march=native).
+ *     scan_walls_scalar() is the portable reference.
+ *
+ * Equivalence:
+ *   Both kernels evaluate denom, t and u with the same IEEE operations as the scalar
+ *   advancer (explicit mul/sub/div, no FMA), apply the same EPS_DIR / EPS_POS rejection
+ *   tests, and feed surviving lanes to the tie-break in ascending wall index. The selected
+ *   hit is therefore bit-identical to the generic scan for every ISA. The scalar
+ *   expressions must not be contracted into FMAs; wall_kernels.cpp and reflecting_world.cpp
+ *   include strict_fp.hpp, which turns contraction off for them regardless of build flags.
+ *
+ * Padding:
+ *   Lanes past size() hold degenerate walls (s = 0), which the EPS_DIR test always rejects.
+ *
+ * See also: reflecting_world.hpp (owner and advancer).
+ */
+
+#include <cstddef>
+#include <limits>
+#include <new>
+#include <vector>
+
+#include "sim/vec2.hpp"
+
+namespace sim {
+
+    /// Minimal C++17 allocator returning storage aligned to @p Align bytes.
+    template <class T, std::size_t Align = 64>
+    struct AlignedAllocator {
+        using value_type = T;
+
+        template <class U>
+        struct rebind { using other = AlignedAllocator<U, Align>; };
+
+        AlignedAllocator() noexcept = default;
+        template <class U>
+        AlignedAllocator(const AlignedAllocator<U, Align>&) noexcept {}
+
+        T* allocate(std::size_t n) {
+            return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(Align)));
+        }
+        void deallocate(T* p, std::size_t) noexcept {
+            ::operator delete(p, std::align_val_t(Align));
+        }
+
+        template <class U>
+        bool operator==(const AlignedAllocator<U, Align>&) const noexcept { return true; }
+        template <class U>
+        bool operator!=(const AlignedAllocator<U, Align>&) const noexcept { return false; }
+    };
+
+    /// Earliest wall hit found so far during one scan.
+    struct WallHit {
+        double t   = std::numeric_limits<double>::infinity(); ///< earliest hit along v
+        int    idx = -1;                                      ///< insertion index of hit wall
+        int    id  = -1;                                      ///< id of hit wall
+        Vec2   n{0.0, 0.0};                                   ///< unit normal of hit wall
+    };
+
+    /**
+     * @brief Wall list in SoA form: p0, direction s = p1 - p0, unit normal and id columns.
+     *
+     * Columns are 64-byte aligned and padded to a multiple of kLanes entries.
+     */
+    struct CompiledWalls {
+        static constexpr std::size_t kLanes = 8;   ///< Padding granularity (widest SIMD width).
+
+        using Column = std::vector<double, AlignedAllocator<double>>;
+
+        Column           p0x, p0y;  ///< Segment start
+        Column           sx, sy;    ///< Segment direction p1 - p0 (cached)
+        Column           nx, ny;    ///< Unit normal
+        std::vector<int> id;        ///< Wall id (tie-break key)
+        std::size_t      n{0};      ///< Number of real walls (columns may be longer)
+
+        std::size_t size() const noexcept { return n; }
+        bool empty() const noexcept { return n == 0; }
+
+        /// Remove all walls.
+        void clear() noexcept;
+
+        /// Append wall (p0 -> p1, unit normal n_hat, id); keeps the padding invariant.
+        void push_back(const Vec2& p0, const Vec2& p1, const Vec2& n_hat, int wall_id);
+    };
+
+    /**
+     * @brief Test the path p -> p + v against every wall and update @p best with the
+     *        earliest hit (ties: smaller id, then smaller insertion index).
+     *
+     * Uses AVX-512 / AVX2 when compiled with them; otherwise equals scan_walls_scalar().
+     */
+    void scan_walls(const CompiledWalls& w, const Vec2& p, const Vec2& v, WallHit& best) noexcept;
+
+    /// Portable reference kernel (one wall at a time); same result as scan_walls().
+    void scan_walls_scalar(const CompiledWalls& w, const Vec2& p, const Vec2& v, WallHit& best) noexcept;
+
+    /// Name of the instruction set used by scan_walls(): "avx512", "avx2" or "scalar".
+    const char* scan_walls_isa() noexcept;
+
+} // namespace sim
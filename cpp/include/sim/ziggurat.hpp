@@ -0,0 +1,142 @@
+#pragma once
+/**
+ * @file ziggurat.hpp
+ * @brief Table-based Ziggurat sampler for standard normal variates (single and bulk).
+ *
+ * What the file is for:
+ *   std::normal_distribution is implementation-defined (libstdc++ and libc++ use different
+ *   algorithms and produce different numbers) and pays for a log/sqrt per pair. The Ziggurat
+ *   method (Marsaglia & Tsang 2000; 256 layers as in Doornik 2005) accepts ~98.8% of draws
+ *   with one 64-bit word, one table lookup and one multiply.
+ *
+ * Word sources:
+ *   All functions take a callable `next()` returning uniformly distributed std::uint64_t
+ *   words. Results depend only on that word stream, the tables and IEEE arithmetic. The
+ *   tables are checked-in hex-float constants, so the fast path is exact everywhere; only
+ *   the rare wedge/tail branches (~1.2% of draws) call std::exp / std::log, and a
+ *   known-answer test in test_rng.cpp fails on a libm that rounds those differently.
+ *
+ * Bulk fill:
+ *   ziggurat_fill(next, out, n) is defined to be identical to n sequential
+ *   ziggurat_normal(next) calls (same outputs, same words consumed). It draws words in
+ *   chunks, evaluates the fast path for every word in a branch-free loop the compiler can
+ *   vectorize, then resolves the rare rejections serially in stream order. It never draws
+ *   more words than the equivalent sequential calls would.
+ *
+ * Word layout (per draw): bits 0..7 select the layer; bits 11..63 give a signed uniform
+ * in [-1, 1) that is scaled by the layer width.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+namespace sim {
+
+    /// Layer boundaries x[0..256] (x[0] = V/f(R), x[1] = R, x[256] = 0) and f[i] = exp(-x[i]^2/2).
+    struct ZigguratTables {
+        double x[257];
+        double f[257];
+    };
+
+    /// The 256-layer tables (compile-time constants, see ziggurat.cpp).
+    const ZigguratTables& ziggurat_tables() noexcept;
+
+    namespace detail {
+
+        /// Signed uniform in [-1, 1) from the top 53 bits.
+        inline double zig_signed_unit(std::uint64_t u) noexcept {
+            return static_cast<double>(u >> 11) * 0x1.0p-52 - 1.0;
+        }
+
+        /// Uniform in [0, 1) from the top 53 bits.
+        inline double zig_unit(std::uint64_t u) noexcept {
+            return static_cast<double>(u >> 11) * 0x1.0p-53;
+        }
+
+        /// Tail beyond R (Marsaglia 1964): x = -ln(u1)/R until -2 ln(u2) >= x^2.
+        template <class Next>
+        double zig_tail(bool negative, Next& next) {
+            const double r = ziggurat_tables().x[1];
+            double x, y;
+            do {
+                x = std::log(1.0 - zig_unit(next())) / r;   // <= 0
+                y = std::log(1.0 - zig_unit(next()));       // <= 0
+            } while (-2.0 * y < x * x);
+            return negative ? x - r : r - x;
+        }
+
+        /// Complete one draw whose first word is @p u (fast path, wedge, tail, retries).
+        template <class Next>
+        double zig_finish(std::uint64_t u, Next& next) {
+            const ZigguratTables& T = ziggurat_tables();
+            for (;;) {
+                const unsigned i = static_cast<unsigned>(u & 0xffu);
+                const double x = zig_signed_unit(u) * T.x[i];
+                if (std::abs(x) < T.x[i + 1]) return x;                 // inside the rectangle core
+                if (i == 0) return zig_tail(x < 0.0, next);             // base strip: tail
+                const double y = T.f[i + 1] + (T.f[i] - T.f[i + 1]) * zig_unit(next());
+                if (y < std::exp(-0.5 * x * x)) return x;               // wedge accepted
+                u = next();                                             // reject: retry
+            }
+        }
+
+    } // namespace detail
+
+    /**
+     * @brief Draw one standard normal variate.
+     * @param next Callable returning uniform std::uint64_t words.
+     */
+    template <class Next>
+    double ziggurat_normal(Next&& next) {
+        const std::uint64_t u = next();
+        return detail::zig_finish(u, next);
+    }
+
+    /**
+     * @brief Fill @p out[0..n) with standard normal variates.
+     *
+     * Equivalent to n sequential ziggurat_normal(next) calls (bitwise), but evaluates the
+     * fast path for a chunk of words at once.
+     */
+    template <class Next>
+    void ziggurat_fill(Next&& next, double* out, std::size_t n) {
+        constexpr std::size_t kChunk = 256;
+        const ZigguratTables& T = ziggurat_tables();
+
+        std::uint64_t words[kChunk];
+        double        cand[kChunk];
+        unsigned char accept[kChunk];
+
+        std::size_t done = 0;
+        while (done < n) {
+            // Each output consumes >= 1 word, so drawing (outputs still needed) words never
+            // over-draws relative to sequential calls.
+            const std::size_t m = std::min(kChunk, n - done);
+            for (std::size_t j = 0; j < m; ++j) words[j] = next();
+
+            // Fast path for every word position (branch-free; vectorizable).
+            for (std::size_t j = 0; j < m; ++j) {
+                const unsigned i = static_cast<unsigned>(words[j] & 0xffu);
+                const double x = detail::zig_signed_unit(words[j]) * T.x[i];
+                cand[j]   = x;
+                accept[j] = static_cast<unsigned char>(std::abs(x) < T.x[i + 1]);
+            }
+
+            // Serial pass in stream order. A rejection resumes from the buffered words
+            // (then the live source), exactly as the sequential sampler would.
+            std::size_t p = 0;
+            auto buffered = [&]() -> std::uint64_t { return p < m ? words[p++] : next(); };
+            while (p < m && done < n) {
+                if (accept[p]) {
+                    out[done++] = cand[p++];
+                } else {
+                    const std::uint64_t u = words[p++];
+                    out[done++] = detail::zig_finish(u, buffered);
+                }
+            }
+        }
+    }
+
+} // namespace sim
@@ -0,0 +1,69 @@
+// cpp/src/adaptive.cpp
+//
+// Batched driver with precision-based stopping (see adaptive.hpp).
+
+#include "sim/adaptive.hpp"
+
+#include <cassert>
+#include <chrono>
+#include <cmath>
+
+namespace sim {
+
+    bool StopTarget::met(const Moments& m) const noexcept {
+        if (m.n < 2) return false;
+        const double se = m.std_error();
+        return (abs_error > 0.0 && se <= abs_error) ||
+               (rel_error > 0.0 && se <= rel_error * std::abs(m.mean));
+    }
+
+    namespace {
+        bool all_met(const AdaptiveConfig& acfg, const MomentObserver& moments) {
+            if (acfg.targets.empty() || moments.n_outputs() == 0) return false;
+            for (const StopTarget& t : acfg.targets) {
+                const std::size_t f = t.output == StopTarget::kLastOutput ? moments.n_outputs() - 1 : t.output;
+                if (f >= moments.n_outputs() || !t.met(moments.moments(f, t.quantity))) return false;
+            }
+            return true;
+        }
+    } // namespace
+
+    AdaptiveResult run_adaptive(const ReflectingWorld& world, const SimulationConfig& cfg,
+                                const AdaptiveConfig& acfg, MomentObserver& moments,
+                                const BatchSetup& setup,
+                                const std::vector<PositionObserver*>& observers) {
+        assert(acfg.batch_size >= 2 && "run_adaptive: batch_size must be >= 2");
+        using clock = std::chrono::steady_clock;
+        const auto t0 = clock::now();
+
+        SimulationConfig bcfg = cfg;
+        bcfg.n_particles = acfg.batch_size;
+        bcfg.record_history = false;
+
+        AdaptiveResult res;
+        while (res.n_batches < acfg.max_batches) {
+            bcfg.first_particle = cfg.first_particle + res.n_batches * acfg.batch_size;
+            Simulation sim(world, bcfg);
+            if (setup) setup(sim, bcfg.first_particle);
+            sim.add_observer(&moments);
+            for (PositionObserver* o : observers) sim.add_observer(o);
+            sim.run();
+
+            ++res.n_batches;
+            res.n_particles += acfg.batch_size;
+            res.seconds = std::chrono::duration<double>(clock::now() - t0).count();
+
+            if (res.n_batches >= acfg.min_batches && all_met(acfg, moments)) {
+                res.reason = StopReason::Converged;
+                return res;
+            }
+            if (acfg.max_seconds > 0.0 && res.seconds >= acfg.max_seconds) {
+                res.reason = StopReason::TimeBudget;
+                return res;
+            }
+        }
+        res.reason = StopReason::MaxBatches;
+        return res;
+    }
+
+} // namespace sim
@@ -0,0 +1,89 @@
+/// @file analytic_worlds.cpp
+/// @brief Closed-form reflections for box, half-plane and wedge domains.
+/// @details See analytic_worlds.hpp for the public API/contract.
+
+/// Method (all three): specular reflection off a straight wall is a mirror map, so instead of
+/// tracing bounces we move along the straight, unfolded path and map its endpoint back.
+///  - Box: x and y decouple; each coordinate follows a triangle wave (fold()).
+///  - Half-plane: at most one bounce; mirror the endpoint.
+///  - Wedge: mirror copies of the wedge tile the plane by angle; the polar angle swept by the
+///    straight path is atan2(x × q, x · q), so the unfolded angle is theta(x) + sweep. Fold it
+///    into [0, angle] and keep the radius |x + d| (mirrors through the apex preserve it).
+
+/// Determinism:
+///  - No tie-breaks are needed; corner hits fold consistently (the map is continuous).
+
+#include "sim/analytic_worlds.hpp"
+#include "sim/reflecting_world.hpp"
+#include <cassert>
+#include <cmath>
+
+namespace sim {
+
+    namespace {
+        /// Fold u into [lo, hi] by repeated mirroring at the bounds; either bound may be infinite.
+        inline double fold(double u, double lo, double hi) {
+            if (u >= lo && u <= hi) return u;
+            const double L = hi - lo;
+            if (!std::isfinite(L)) {
+                // One-sided interval: a single mirror at the finite bound.
+                return u < lo ? 2.0 * lo - u : 2.0 * hi - u;
+            }
+            double t = std::fmod(u - lo, 2.0 * L);
+            if (t < 0.0) t += 2.0 * L;
+            if (t > L) t = 2.0 * L - t;
+            return lo + t;
+        }
+
+        /// Same negligible-displacement rule as the generic advancer.
+        inline bool negligible(const Vec2& d) {
+            return std::abs(d.x) <= EPS_DIR && std::abs(d.y) <= EPS_DIR;
+        }
+    } // namespace
+
+    HalfPlaneWorld HalfPlaneWorld::from_normal(const Vec2& n, double c) {
+        const double len = n.norm();
+        assert(len > EPS_DIR && "HalfPlaneWorld::from_normal: normal is near zero");
+        return HalfPlaneWorld{ Vec2{n.x / len, n.y / len}, c / len };
+    }
+
+    void advance_with_reflections(Vec2& x, Vec2 d, const BoxWorld& world) {
+        assert(world.xmin < world.xmax && world.ymin < world.ymax && "BoxWorld: invalid bounds");
+        if (negligible(d)) return;
+        x = Vec2{ fold(x.x + d.x, world.xmin, world.xmax),
+                  fold(x.y + d.y, world.ymin, world.ymax) };
+    }
+
+    void advance_with_reflections(Vec2& x, Vec2 d, const HalfPlaneWorld& world) {
+        if (negligible(d)) return;
+        const Vec2 q = x + d;
+        const double s = world.n_hat.dot(q) - world.c;     // signed distance of the endpoint
+        x = (s >= 0.0) ? q : q - (2.0 * s) * world.n_hat;
+    }
+
+    void advance_with_reflections(Vec2& x, Vec2 d, const WedgeWorld& world) {
+        const double a = world.angle;
+        assert(a > 0.0 && a <= 3.141592653589793 && "WedgeWorld: angle must be in (0, pi]");
+        if (negligible(d)) return;
+
+        const Vec2 q = x + d;
+
+        // Unfolded polar angle of the endpoint (monotone along the straight path).
+        double phi;
+        if (x.x == 0.0 && x.y == 0.0) {
+            phi = std::atan2(q.y, q.x);                     // starting at the apex
+        } else {
+            const double sweep = std::atan2(x.x * q.y - x.y * q.x, x.dot(q));
+            phi = std::atan2(x.y, x.x) + sweep;
+        }
+        if (phi >= 0.0 && phi <= a) {
+            x = q;                                          // no ray crossed
+            return;
+        }
+
+        const double r = q.norm();
+        const double folded = fold(phi, 0.0, a);
+        x = Vec2{ r * std::cos(folded), r * std::sin(folded) };
+    }
+
+} // namespace sim
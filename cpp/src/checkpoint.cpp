@@ -0,0 +1,64 @@
+// cpp/src/checkpoint.cpp
+//
+// Checkpoint primitives (see checkpoint.hpp).
+
+#include "sim/checkpoint.hpp"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace sim {
+
+    namespace {
+        constexpr char kMagic[8] = {'D', 'M', 'M', 'C', 'C', 'K', 'P', '1'};
+        constexpr std::uint32_t kByteOrder = 0x01020304u;
+    } // namespace
+
+    namespace detail {
+        void write_string(std::ostream& os, const std::string& s) {
+            write_pod<std::uint64_t>(os, s.size());
+            os.write(s.data(), static_cast<std::streamsize>(s.size()));
+        }
+
+        std::string read_string(std::istream& is) {
+            std::vector<char> bytes;
+            read_vector(is, bytes);
+            return std::string(bytes.begin(), bytes.end());
+        }
+    } // namespace detail
+
+    void write_checkpoint_header(std::ostream& os) {
+        os.write(kMagic, sizeof(kMagic));
+        detail::write_pod(os, kByteOrder);
+        detail::write_pod(os, kCheckpointVersion);
+    }
+
+    void read_checkpoint_header(std::istream& is) {
+        char magic[8];
+        if (!is.read(magic, sizeof(magic)) || std::memcmp(magic, kMagic, sizeof(magic)) != 0) {
+            throw std::runtime_error("checkpoint: not a checkpoint file");
+        }
+        if (detail::read_pod<std::uint32_t>(is) != kByteOrder) {
+            throw std::runtime_error("checkpoint: written with a different byte order");
+        }
+        if (detail::read_pod<std::uint32_t>(is) != kCheckpointVersion) {
+            throw std::runtime_error("checkpoint: unsupported version");
+        }
+    }
+
+    void write_file_atomically(const std::string& path, const std::function<void(std::ostream&)>& save) {
+        const std::string tmp = path + ".tmp";
+        {
+            std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+            if (!out) throw std::runtime_error("checkpoint: cannot open " + tmp);
+            save(out);
+            out.flush();
+            if (!out) throw std::runtime_error("checkpoint: write failed for " + tmp);
+        }
+        std::error_code ec;
+        std::filesystem::rename(tmp, path, ec);
+        if (ec) throw std::runtime_error("checkpoint: cannot replace " + path + ": " + ec.message());
+    }
+
+} // namespace sim
@@ -0,0 +1,185 @@
+// cpp/src/codec.cpp
+//
+// Series codecs and the compressed in-memory history (see codec.hpp).
+//
+// Each value maps to a 64-bit key: its IEEE bits (lossless) or q = round(v / 2 tol) (lossy).
+// The first key is stored raw; every later one as z = zigzag(key - key_prev) (wrapping):
+//   '0'                                  z == 0
+//   '1' <nb-1:6> <low nb-1 bits of z>    nb = bit width of z (top bit implied)
+// Same-sign doubles order like their bit patterns, so nearby values give small deltas.
+
+#include "sim/codec.hpp"
+
+#include <cassert>
+#include <cmath>
+#include <cstring>
+
+namespace sim {
+
+    namespace {
+        inline std::uint64_t to_bits(double v) noexcept {
+            std::uint64_t b;
+            std::memcpy(&b, &v, sizeof(b));
+            return b;
+        }
+
+        inline double from_bits(std::uint64_t b) noexcept {
+            double v;
+            std::memcpy(&v, &b, sizeof(v));
+            return v;
+        }
+
+        inline unsigned leading_zeros(std::uint64_t x) noexcept {
+        #if defined(__GNUC__) || defined(__clang__)
+            return x ? static_cast<unsigned>(__builtin_clzll(x)) : 64u;
+        #else
+            unsigned n = 0;
+            for (std::uint64_t m = std::uint64_t{1} << 63; m && !(x & m); m >>= 1) ++n;
+            return n;
+        #endif
+        }
+
+        inline std::uint64_t mask(unsigned n) noexcept {
+            return n >= 64 ? ~std::uint64_t{0} : ((std::uint64_t{1} << n) - 1);
+        }
+
+        inline std::uint64_t zigzag(std::int64_t d) noexcept {
+            return (static_cast<std::uint64_t>(d) << 1) ^ static_cast<std::uint64_t>(d >> 63);
+        }
+
+        inline std::int64_t unzigzag(std::uint64_t z) noexcept {
+            return static_cast<std::int64_t>(z >> 1) ^ -static_cast<std::int64_t>(z & 1);
+        }
+    } // namespace
+
+    // ---- Bit streams ----
+
+    void BitWriter::put(std::uint64_t v, unsigned n) {
+        v &= mask(n);
+        while (n > 0) {
+            if (used_ == 0) buf_.push_back(0);
+            const unsigned room = 8 - used_;
+            const unsigned take = n < room ? n : room;
+            const auto chunk = static_cast<std::uint8_t>((v >> (n - take)) & mask(take));
+            buf_.back() = static_cast<std::uint8_t>(buf_.back() | (chunk << (room - take)));
+            used_ = (used_ + take) & 7u;
+            n -= take;
+        }
+    }
+
+    std::uint64_t BitReader::get(unsigned n) noexcept {
+        std::uint64_t v = 0;
+        while (n > 0) {
+            const std::size_t byte = pos_ >> 3;
+            const unsigned off  = static_cast<unsigned>(pos_ & 7u);
+            const unsigned room = 8 - off;
+            const unsigned take = n < room ? n : room;
+            const std::uint8_t b = byte < n_bytes_ ? data_[byte] : 0;
+            v = (v << take) | ((b >> (room - take)) & mask(take));
+            pos_ += take;
+            n -= take;
+        }
+        return v;
+    }
+
+    // ---- Series encoder / decoder ----
+
+    SeriesEncoder::SeriesEncoder(double tolerance)
+        : tol_(tolerance), inv_step_(tolerance > 0.0 ? 0.5 / tolerance : 0.0)
+    {
+        assert(tolerance >= 0.0 && "SeriesEncoder: tolerance must be >= 0");
+    }
+
+    void SeriesEncoder::push(double v) {
+        std::uint64_t key;
+        if (tol_ > 0.0) {
+            assert(std::isfinite(v) && std::abs(v * inv_step_) < 4.6e18 && "SeriesEncoder: value out of quantizer range");
+            key = static_cast<std::uint64_t>(std::llround(v * inv_step_));
+        } else {
+            key = to_bits(v);
+        }
+
+        if (count_ == 0) {
+            out_.put(key, 64);
+        } else {
+            const std::uint64_t z = zigzag(static_cast<std::int64_t>(key - prev_));
+            if (z == 0) {
+                out_.put(0, 1);
+            } else {
+                const unsigned nb = 64 - leading_zeros(z);
+                out_.put(1, 1);
+                out_.put(nb - 1, 6);
+                out_.put(z, nb - 1);
+            }
+        }
+        prev_ = key;
+        ++count_;
+    }
+
+    void decode_series(const std::uint8_t* data, std::size_t n_bytes, std::size_t count,
+                       double tolerance, double* out) {
+        if (count == 0) return;
+        BitReader in(data, n_bytes);
+        const double step = 2.0 * tolerance;
+        const auto value = [&](std::uint64_t key) {
+            return tolerance > 0.0 ? static_cast<double>(static_cast<std::int64_t>(key)) * step : from_bits(key);
+        };
+
+        std::uint64_t key = in.get(64);
+        out[0] = value(key);
+        for (std::size_t k = 1; k < count; ++k) {
+            if (in.get(1)) {
+                const unsigned nb = static_cast<unsigned>(in.get(6)) + 1;
+                const std::uint64_t z = (std::uint64_t{1} << (nb - 1)) | in.get(nb - 1);
+                key += static_cast<std::uint64_t>(unzigzag(z));
+            }
+            out[k] = value(key);
+        }
+    }
+
+    // ---- CompressedHistory ----
+
+    void CompressedHistory::begin(std::size_t n_particles, std::size_t store_every) {
+        n_frames_ = 0;
+        store_every_ = store_every;
+        xs_.assign(n_particles, SeriesEncoder(tol_));
+        ys_.assign(n_particles, SeriesEncoder(tol_));
+    }
+
+    void CompressedHistory::write(const HistoryFrames& frames) {
+        assert(frames.n_particles == xs_.size() && "CompressedHistory: particle count changed");
+        for (std::size_t f = 0; f < frames.n_frames; ++f) {
+            const double* x = frames.x + f * frames.n_particles;
+            const double* y = frames.y + f * frames.n_particles;
+            for (std::size_t i = 0; i < frames.n_particles; ++i) {
+                xs_[i].push(x[i]);
+                ys_[i].push(y[i]);
+            }
+        }
+        n_frames_ += frames.n_frames;
+    }
+
+    std::size_t CompressedHistory::bytes() const noexcept {
+        std::size_t b = 0;
+        for (std::size_t i = 0; i < xs_.size(); ++i) b += xs_[i].bytes().size() + ys_[i].bytes().size();
+        return b;
+    }
+
+    std::vector<Vec2> CompressedHistory::particle(std::size_t i) const {
+        assert(i < xs_.size() && "CompressedHistory::particle: index out of range");
+        std::vector<double> x(n_frames_), y(n_frames_);
+        decode_series(xs_[i].bytes().data(), xs_[i].bytes().size(), n_frames_, tol_, x.data());
+        decode_series(ys_[i].bytes().data(), ys_[i].bytes().size(), n_frames_, tol_, y.data());
+        std::vector<Vec2> out(n_frames_);
+        for (std::size_t f = 0; f < n_frames_; ++f) out[f] = Vec2{x[f], y[f]};
+        return out;
+    }
+
+    std::vector<std::vector<Vec2>> CompressedHistory::to_vectors() const {
+        std::vector<std::vector<Vec2>> out;
+        out.reserve(xs_.size());
+        for (std::size_t i = 0; i < xs_.size(); ++i) out.push_back(particle(i));
+        return out;
+    }
+
+} // namespace sim
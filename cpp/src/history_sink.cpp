@@ -0,0 +1,159 @@
+// cpp/src/history_sink.cpp
+//
+// History sinks and the double-buffered HistoryWriter declared in history_sink.hpp.
+//
+// Writer protocol:
+//   - submit() waits until the writer is idle, publishes the fill buffer as pending_, sets
+//     busy_ and flips fill_; the producer then fills the other buffer.
+//   - The writer thread calls sink.write(pending_) outside the lock, then clears busy_.
+//   - A sink exception is stored and rethrown by the next submit()/finish() on the producer.
+
+#include "sim/history_sink.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+
+namespace sim {
+
+    // ---- BinaryHistoryFileSink ----
+
+    BinaryHistoryFileSink::BinaryHistoryFileSink(const std::string& path)
+        : path_(path), out_(path, std::ios::binary | std::ios::trunc)
+    {
+        if (!out_) throw std::runtime_error("BinaryHistoryFileSink: cannot open " + path);
+    }
+
+    BinaryHistoryFileSink::BinaryHistoryFileSink(const std::string& path, std::size_t keep_frames)
+        : path_(path)
+    {
+        char magic[8];
+        std::uint64_t shape[2];
+        {
+            std::ifstream in(path, std::ios::binary);
+            if (!in.read(magic, sizeof(magic)) || std::memcmp(magic, "DMMCHST1", sizeof(magic)) != 0 ||
+                !in.read(reinterpret_cast<char*>(shape), sizeof(shape))) {
+                throw std::runtime_error("BinaryHistoryFileSink: " + path + " is not a history file");
+            }
+        }
+        // Everything after frame keep_frames - 1 was written after the checkpoint.
+        const std::uintmax_t keep = sizeof(magic) + sizeof(shape) + keep_frames * 2 * sizeof(double) * shape[0];
+        std::error_code ec;
+        const std::uintmax_t size = std::filesystem::file_size(path, ec);
+        if (ec || size < keep) {
+            throw std::runtime_error("BinaryHistoryFileSink: " + path + " holds fewer frames than the checkpoint");
+        }
+        std::filesystem::resize_file(path, keep, ec);
+        if (ec) throw std::runtime_error("BinaryHistoryFileSink: cannot truncate " + path + ": " + ec.message());
+        out_.open(path, std::ios::binary | std::ios::in | std::ios::out);
+        out_.seekp(0, std::ios::end);
+        if (!out_) throw std::runtime_error("BinaryHistoryFileSink: cannot open " + path);
+    }
+
+    void BinaryHistoryFileSink::begin(std::size_t n_particles, std::size_t store_every) {
+        const char magic[8] = {'D', 'M', 'M', 'C', 'H', 'S', 'T', '1'};
+        const std::uint64_t shape[2] = {n_particles, store_every};
+        out_.write(magic, sizeof(magic));
+        out_.write(reinterpret_cast<const char*>(shape), sizeof(shape));
+    }
+
+    void BinaryHistoryFileSink::write(const HistoryFrames& frames) {
+        const std::streamsize bytes = static_cast<std::streamsize>(frames.n_particles * sizeof(double));
+        for (std::size_t f = 0; f < frames.n_frames; ++f) {
+            out_.write(reinterpret_cast<const char*>(frames.x + f * frames.n_particles), bytes);
+            out_.write(reinterpret_cast<const char*>(frames.y + f * frames.n_particles), bytes);
+        }
+        if (!out_) throw std::runtime_error("BinaryHistoryFileSink: write failed for " + path_);
+    }
+
+    void BinaryHistoryFileSink::flush() {
+        out_.flush();
+        if (!out_) throw std::runtime_error("BinaryHistoryFileSink: flush failed for " + path_);
+    }
+
+    // ---- HistoryWriter ----
+
+    std::size_t history_frames_per_buffer(std::size_t buffer_bytes, std::size_t n_particles,
+                                          std::size_t max_frames) noexcept {
+        const std::size_t frame_bytes = 2 * sizeof(double) * std::max<std::size_t>(1, n_particles);
+        return std::max<std::size_t>(1, std::min(max_frames, buffer_bytes / (2 * frame_bytes)));
+    }
+
+    HistoryWriter::HistoryWriter(HistorySink& sink, std::size_t n_particles, std::size_t frames_per_buffer)
+        : sink_(sink), n_(n_particles), frames_(std::max<std::size_t>(1, frames_per_buffer))
+    {
+        // Default-initialized (not zero-filled): a large buffer costs nothing until it is used.
+        for (int b = 0; b < 2; ++b) {
+            x_[b].reset(new double[frames_ * n_]);
+            y_[b].reset(new double[frames_ * n_]);
+        }
+        thread_ = std::thread([this] { writer_loop(); });
+    }
+
+    HistoryWriter::~HistoryWriter() {
+        {
+            std::unique_lock<std::mutex> lock(mtx_);
+            cv_.wait(lock, [&] { return !busy_; });
+            stop_ = true;
+        }
+        cv_.notify_all();
+        thread_.join();
+    }
+
+    void HistoryWriter::writer_loop() {
+        for (;;) {
+            HistoryFrames block;
+            bool failed;
+            {
+                std::unique_lock<std::mutex> lock(mtx_);
+                cv_.wait(lock, [&] { return stop_ || busy_; });
+                if (!busy_) return;   // stop_ with nothing pending
+                block = pending_;
+                failed = error_ != nullptr;
+            }
+            std::exception_ptr err;
+            try {
+                if (!failed) sink_.write(block);   // after a failure, drop further blocks
+            } catch (...) {
+                err = std::current_exception();
+            }
+            {
+                std::lock_guard<std::mutex> lock(mtx_);
+                if (err && !error_) error_ = err;
+                busy_ = false;
+            }
+            cv_.notify_all();
+        }
+    }
+
+    void HistoryWriter::wait_idle() {
+        std::exception_ptr err;
+        {
+            std::unique_lock<std::mutex> lock(mtx_);
+            cv_.wait(lock, [&] { return !busy_; });
+            err = error_;
+            error_ = nullptr;
+        }
+        if (err) std::rethrow_exception(err);
+    }
+
+    void HistoryWriter::submit(std::size_t first_frame, std::size_t n_frames) {
+        if (n_frames == 0) return;
+        wait_idle();
+        {
+            std::lock_guard<std::mutex> lock(mtx_);
+            pending_ = HistoryFrames{first_frame, n_frames, n_, x_[fill_].get(), y_[fill_].get()};
+            busy_ = true;
+        }
+        cv_.notify_all();
+        fill_ ^= 1u;
+    }
+
+    void HistoryWriter::finish() {
+        wait_idle();
+        sink_.flush();
+    }
+
+} // namespace sim
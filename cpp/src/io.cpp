@@ -0,0 +1,394 @@
+// cpp/src/io.cpp
+//
+// Trajectory file writer/reader (format documented in io.hpp).
+//
+// Offsets: every frame occupies F = 16 * n_particles bytes, so frame f (FrameMajor) or the
+// chunk holding frame f (ParticleMajor, chunk start c*C) lives at header_bytes + first_frame*F.
+// The writer seeks to that offset for every block, which also lets it rewrite the trailing
+// partial ParticleMajor chunk on each flush() and extend it in place on the next run.
+// Compressed chunks are variable-size: they are appended at chunk_offset_, the partial one is
+// rewritten in place (its encoding only grows), and the chunk trailer follows the data.
+
+#include "sim/io.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define SIM_IO_HAVE_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace sim {
+
+    namespace {
+        constexpr std::size_t kDefaultFramesPerChunk = 256;
+
+        /// 64-bit FNV-1a over raw bytes.
+        struct Fnv1a {
+            std::uint64_t h{1469598103934665603ull};
+
+            void bytes(const void* p, std::size_t n) noexcept {
+                const auto* c = static_cast<const unsigned char*>(p);
+                for (std::size_t k = 0; k < n; ++k) {
+                    h ^= c[k];
+                    h *= 1099511628211ull;
+                }
+            }
+            void f64(double v) noexcept { bytes(&v, sizeof(v)); }
+            void tag(const char* s) noexcept { bytes(s, std::strlen(s)); }
+        };
+    } // namespace
+
+    // ---- Header / hashes ----
+
+    TrajectoryHeader make_trajectory_header(const SimulationConfig& cfg, std::uint64_t world_hash,
+                                            TrajectoryLayout layout, std::size_t frames_per_chunk,
+                                            double tolerance) {
+        TrajectoryHeader h;
+        h.layout           = static_cast<std::uint32_t>(layout);
+        h.frames_per_chunk = layout != TrajectoryLayout::FrameMajor
+                                 ? (frames_per_chunk ? frames_per_chunk : kDefaultFramesPerChunk)
+                                 : 0;
+        h.tolerance        = layout == TrajectoryLayout::Compressed ? tolerance : 0.0;
+        h.n_particles      = cfg.n_particles;
+        h.store_every      = cfg.store_every;
+        h.n_steps          = cfg.n_steps;
+        h.base_seed        = cfg.base_seed;
+        h.deterministic    = cfg.deterministic ? 1u : 0u;
+        h.rng_engine       = static_cast<std::uint32_t>(cfg.rng_engine);
+        h.normal_method    = static_cast<std::uint32_t>(cfg.normal_method);
+        h.dt               = cfg.brownian.dt;
+        h.D                = cfg.brownian.D;
+        h.mu_x             = cfg.brownian.mu_x;
+        h.mu_y             = cfg.brownian.mu_y;
+        h.world_hash       = world_hash;
+        return h;
+    }
+
+    std::uint64_t geometry_hash(const ReflectingWorld& world) noexcept {
+        Fnv1a f;
+        f.tag("segments");
+        for (const WallSegment& w : world.walls) {
+            f.f64(w.p0.x);    f.f64(w.p0.y);
+            f.f64(w.p1.x);    f.f64(w.p1.y);
+            f.f64(w.n_hat.x); f.f64(w.n_hat.y);
+            f.bytes(&w.id, sizeof(w.id));
+        }
+        return f.h;
+    }
+
+    std::uint64_t geometry_hash(const BoxWorld& world) noexcept {
+        Fnv1a f;
+        f.tag("box");
+        f.f64(world.xmin); f.f64(world.xmax); f.f64(world.ymin); f.f64(world.ymax);
+        return f.h;
+    }
+
+    std::uint64_t geometry_hash(const HalfPlaneWorld& world) noexcept {
+        Fnv1a f;
+        f.tag("half-plane");
+        f.f64(world.n_hat.x); f.f64(world.n_hat.y); f.f64(world.c);
+        return f.h;
+    }
+
+    std::uint64_t geometry_hash(const WedgeWorld& world) noexcept {
+        Fnv1a f;
+        f.tag("wedge");
+        f.f64(world.angle);
+        return f.h;
+    }
+
+    // ---- TrajectoryWriter ----
+
+    TrajectoryWriter::TrajectoryWriter(const std::string& path, const TrajectoryHeader& header)
+        : path_(path),
+          out_(path, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc),
+          header_(header)
+    {
+        if (!out_) throw std::runtime_error("TrajectoryWriter: cannot open " + path);
+        header_.header_bytes = sizeof(TrajectoryHeader);
+        if (static_cast<TrajectoryLayout>(header_.layout) != TrajectoryLayout::FrameMajor) {
+            if (header_.frames_per_chunk == 0) header_.frames_per_chunk = kDefaultFramesPerChunk;
+        } else {
+            header_.frames_per_chunk = 0;
+        }
+    }
+
+    void TrajectoryWriter::write_at(std::uint64_t offset, const void* data, std::size_t bytes) {
+        out_.seekp(static_cast<std::streamoff>(offset));
+        out_.write(static_cast<const char*>(data), static_cast<std::streamsize>(bytes));
+        if (!out_) throw std::runtime_error("TrajectoryWriter: write failed for " + path_);
+    }
+
+    void TrajectoryWriter::begin(std::size_t n_particles, std::size_t store_every) {
+        header_.n_particles = n_particles;
+        header_.store_every = store_every;
+        header_.n_frames    = 0;
+        chunk_frames_       = 0;
+        chunk_offset_       = header_.header_bytes;
+        chunk_end_          = chunk_offset_;
+        chunk_index_.clear();
+        if (header_.frames_per_chunk) {
+            chunk_x_.assign(static_cast<std::size_t>(header_.frames_per_chunk) * n_particles, 0.0);
+            chunk_y_.assign(chunk_x_.size(), 0.0);
+        }
+        write_at(0, &header_, sizeof(header_));
+    }
+
+    void TrajectoryWriter::write(const HistoryFrames& frames) {
+        const std::size_t n = frames.n_particles;
+        const std::uint64_t frame_bytes = 2 * sizeof(double) * n;
+        for (std::size_t f = 0; f < frames.n_frames; ++f) {
+            const double* x = frames.x + f * n;
+            const double* y = frames.y + f * n;
+            if (header_.frames_per_chunk == 0) {
+                const std::uint64_t off = header_.header_bytes + (frames.first_frame + f) * frame_bytes;
+                write_at(off, x, n * sizeof(double));
+                out_.write(reinterpret_cast<const char*>(y), static_cast<std::streamsize>(n * sizeof(double)));
+            } else {
+                std::copy(x, x + n, chunk_x_.begin() + static_cast<std::ptrdiff_t>(chunk_frames_ * n));
+                std::copy(y, y + n, chunk_y_.begin() + static_cast<std::ptrdiff_t>(chunk_frames_ * n));
+                ++chunk_frames_;
+            }
+            header_.n_frames = frames.first_frame + f + 1;
+            if (chunk_frames_ == header_.frames_per_chunk && chunk_frames_ != 0) {
+                write_chunk(true);
+                chunk_frames_ = 0;
+            }
+        }
+        if (!out_) throw std::runtime_error("TrajectoryWriter: write failed for " + path_);
+    }
+
+    void TrajectoryWriter::write_chunk(bool complete) {
+        const std::size_t n = static_cast<std::size_t>(header_.n_particles);
+        const std::size_t m = chunk_frames_;
+
+        if (static_cast<TrajectoryLayout>(header_.layout) == TrajectoryLayout::Compressed) {
+            // Encode each series, then payload = offsets[2n + 1] + streams.
+            std::vector<std::uint64_t> table(2 * n + 1);
+            std::vector<std::uint8_t> streams;
+            std::vector<double> series(m);
+            for (std::size_t s = 0; s < 2 * n; ++s) {
+                const std::vector<double>& col = (s & 1) ? chunk_y_ : chunk_x_;
+                SeriesEncoder enc(header_.tolerance);
+                for (std::size_t k = 0; k < m; ++k) enc.push(col[k * n + s / 2]);
+                table[s] = table.size() * sizeof(std::uint64_t) + streams.size();
+                streams.insert(streams.end(), enc.bytes().begin(), enc.bytes().end());
+            }
+            streams.resize((streams.size() + 7) & ~std::size_t{7});    // keep chunks 8-byte aligned
+            table[2 * n] = table.size() * sizeof(std::uint64_t) + streams.size();
+            write_at(chunk_offset_, table.data(), table.size() * sizeof(std::uint64_t));
+            out_.write(reinterpret_cast<const char*>(streams.data()), static_cast<std::streamsize>(streams.size()));
+            chunk_end_ = chunk_offset_ + table[2 * n];
+            if (complete) {
+                chunk_index_.push_back(chunk_offset_);
+                chunk_offset_ = chunk_end_;
+            }
+            return;
+        }
+
+        // Transpose the buffered frames: x[particle][m] then y[particle][m].
+        std::vector<double> out(2 * n * m);
+        for (std::size_t i = 0; i < n; ++i) {
+            for (std::size_t k = 0; k < m; ++k) {
+                out[i * m + k]         = chunk_x_[k * n + i];
+                out[(n + i) * m + k]   = chunk_y_[k * n + i];
+            }
+        }
+        const std::uint64_t first = header_.n_frames - m;
+        write_at(header_.header_bytes + first * 2 * sizeof(double) * n, out.data(), out.size() * sizeof(double));
+    }
+
+    void TrajectoryWriter::flush() {
+        if (chunk_frames_ > 0) write_chunk(false);  // partial chunk; rewritten when it grows
+        if (static_cast<TrajectoryLayout>(header_.layout) == TrajectoryLayout::Compressed) {
+            // Trailer: start of every chunk (including a partial one), then the end of data.
+            std::vector<std::uint64_t> index = chunk_index_;
+            if (chunk_frames_ > 0) index.push_back(chunk_offset_);
+            const std::uint64_t end = chunk_frames_ > 0 ? chunk_end_ : chunk_offset_;
+            index.push_back(end);
+            write_at(end, index.data(), index.size() * sizeof(std::uint64_t));
+            header_.index_offset = end;
+        }
+        write_at(0, &header_, sizeof(header_));
+        out_.flush();
+        if (!out_) throw std::runtime_error("TrajectoryWriter: flush failed for " + path_);
+    }
+
+    // ---- TrajectoryReader ----
+
+    TrajectoryReader::TrajectoryReader(const std::string& path) {
+#ifdef SIM_IO_HAVE_MMAP
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) throw std::runtime_error("TrajectoryReader: cannot open " + path);
+        struct stat st{};
+        if (::fstat(fd, &st) != 0) {
+            ::close(fd);
+            throw std::runtime_error("TrajectoryReader: cannot stat " + path);
+        }
+        size_ = static_cast<std::size_t>(st.st_size);
+        if (size_ > 0) {
+            void* p = ::mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+            if (p == MAP_FAILED) {
+                ::close(fd);
+                throw std::runtime_error("TrajectoryReader: mmap failed for " + path);
+            }
+            base_ = static_cast<const unsigned char*>(p);
+            mapped_ = true;
+        }
+        ::close(fd);    // the mapping keeps the file referenced
+#else
+        std::ifstream in(path, std::ios::binary | std::ios::ate);
+        if (!in) throw std::runtime_error("TrajectoryReader: cannot open " + path);
+        size_ = static_cast<std::size_t>(in.tellg());
+        fallback_.resize(size_);
+        in.seekg(0);
+        in.read(reinterpret_cast<char*>(fallback_.data()), static_cast<std::streamsize>(size_));
+        base_ = fallback_.data();
+#endif
+
+        // ---- Validate the header before exposing any view ----
+        const auto fail = [&](const char* what) {
+            release();
+            throw std::runtime_error(std::string("TrajectoryReader: ") + what + " in " + path);
+        };
+        if (size_ < sizeof(TrajectoryHeader)) fail("file shorter than the header");
+        std::memcpy(&header_, base_, sizeof(header_));
+        if (std::memcmp(header_.magic, "DMMCTRJ1", 8) != 0) fail("bad magic");
+        if (header_.byte_order != 0x01020304u) fail("foreign byte order");
+        if (header_.version != kTrajectoryVersion) fail("unsupported version");
+        if (header_.header_bytes < sizeof(TrajectoryHeader) || header_.header_bytes % alignof(double) != 0) {
+            fail("bad header size");
+        }
+        if (header_.layout > static_cast<std::uint32_t>(TrajectoryLayout::Compressed)) fail("unknown layout");
+        if (layout() != TrajectoryLayout::FrameMajor && header_.frames_per_chunk == 0) fail("zero chunk length");
+        if (layout() == TrajectoryLayout::Compressed) {
+            if (n_frames() == 0) return;   // nothing flushed yet; no trailer
+            const std::uint64_t index_bytes = (n_chunks() + 1) * sizeof(std::uint64_t);
+            if (header_.index_offset % alignof(std::uint64_t) != 0 || header_.index_offset < header_.header_bytes ||
+                header_.index_offset + index_bytes > size_) {
+                fail("bad chunk index");
+            }
+            for (std::size_t c = 0; c <= n_chunks(); ++c) {
+                if (chunk_index()[c] > header_.index_offset || (c > 0 && chunk_index()[c] < chunk_index()[c - 1])) {
+                    fail("bad chunk index");
+                }
+            }
+        } else {
+            const std::uint64_t data_bytes = header_.n_frames * 2 * sizeof(double) * header_.n_particles;
+            if (header_.header_bytes + data_bytes > size_) fail("truncated frame data");
+        }
+    }
+
+    TrajectoryReader::~TrajectoryReader() { release(); }
+
+    TrajectoryReader::TrajectoryReader(TrajectoryReader&& other) noexcept { *this = std::move(other); }
+
+    TrajectoryReader& TrajectoryReader::operator=(TrajectoryReader&& other) noexcept {
+        if (this != &other) {
+            release();
+            base_     = std::exchange(other.base_, nullptr);
+            size_     = std::exchange(other.size_, 0);
+            mapped_   = std::exchange(other.mapped_, false);
+            fallback_ = std::move(other.fallback_);
+            header_   = other.header_;
+        }
+        return *this;
+    }
+
+    void TrajectoryReader::release() noexcept {
+#ifdef SIM_IO_HAVE_MMAP
+        if (mapped_) ::munmap(const_cast<unsigned char*>(base_), size_);
+#endif
+        base_ = nullptr;
+        size_ = 0;
+        mapped_ = false;
+        fallback_.clear();
+    }
+
+    PositionsView TrajectoryReader::frame(std::size_t f) const {
+        if (layout() != TrajectoryLayout::FrameMajor) {
+            throw std::logic_error("TrajectoryReader::frame: file is not frame-major");
+        }
+        assert(f < n_frames() && "TrajectoryReader::frame: frame index out of range");
+        const std::size_t n = n_particles();
+        const double* p = data() + f * 2 * n;
+        return PositionsView(p, p + n, n);
+    }
+
+    std::size_t TrajectoryReader::n_chunks() const noexcept {
+        const std::size_t c = static_cast<std::size_t>(header_.frames_per_chunk);
+        return c == 0 ? 0 : (n_frames() + c - 1) / c;
+    }
+
+    PositionsView TrajectoryReader::particle_chunk(std::size_t i, std::size_t c) const {
+        if (layout() != TrajectoryLayout::ParticleMajor) {
+            throw std::logic_error("TrajectoryReader::particle_chunk: file is not (uncompressed) particle-major");
+        }
+        assert(i < n_particles() && c < n_chunks() && "TrajectoryReader::particle_chunk: index out of range");
+        const std::size_t n = n_particles();
+        const std::size_t C = static_cast<std::size_t>(header_.frames_per_chunk);
+        const std::size_t m = std::min(C, n_frames() - c * C);
+        const double* base = data() + c * C * 2 * n;
+        return PositionsView(base + i * m, base + (n + i) * m, m);
+    }
+
+    std::size_t TrajectoryReader::decode_chunk(std::size_t i, std::size_t c, double* x, double* y) const {
+        const std::size_t n = n_particles();
+        const std::size_t C = static_cast<std::size_t>(header_.frames_per_chunk);
+        const std::size_t m = std::min(C, n_frames() - c * C);
+        const unsigned char* payload = base_ + chunk_index()[c];
+        const std::size_t payload_bytes = static_cast<std::size_t>(chunk_index()[c + 1] - chunk_index()[c]);
+        std::uint64_t table[3];     // x_i, y_i, next
+        if (payload_bytes < (2 * n + 1) * sizeof(std::uint64_t)) {
+            throw std::runtime_error("TrajectoryReader: corrupt compressed chunk");
+        }
+        std::memcpy(table, payload + 2 * i * sizeof(std::uint64_t), sizeof(table));
+        if (table[0] > table[1] || table[1] > table[2] || table[2] > payload_bytes) {
+            throw std::runtime_error("TrajectoryReader: corrupt compressed chunk");
+        }
+        decode_series(payload + table[0], static_cast<std::size_t>(table[1] - table[0]), m, header_.tolerance, x);
+        decode_series(payload + table[1], static_cast<std::size_t>(table[2] - table[1]), m, header_.tolerance, y);
+        return m;
+    }
+
+    Vec2 TrajectoryReader::at(std::size_t f, std::size_t i) const {
+        assert(f < n_frames() && i < n_particles() && "TrajectoryReader::at: index out of range");
+        if (layout() == TrajectoryLayout::FrameMajor) return frame(f)[i];
+        const std::size_t C = static_cast<std::size_t>(header_.frames_per_chunk);
+        if (layout() == TrajectoryLayout::Compressed) {
+            std::vector<double> x(C), y(C);
+            decode_chunk(i, f / C, x.data(), y.data());
+            return Vec2{x[f % C], y[f % C]};
+        }
+        return particle_chunk(i, f / C)[f % C];
+    }
+
+    std::vector<Vec2> TrajectoryReader::particle(std::size_t i) const {
+        std::vector<Vec2> out;
+        out.reserve(n_frames());
+        if (layout() == TrajectoryLayout::FrameMajor) {
+            for (std::size_t f = 0; f < n_frames(); ++f) out.push_back(frame(f)[i]);
+        } else if (layout() == TrajectoryLayout::Compressed) {
+            const std::size_t C = static_cast<std::size_t>(header_.frames_per_chunk);
+            std::vector<double> x(C), y(C);
+            for (std::size_t c = 0; c < n_chunks(); ++c) {
+                const std::size_t m = decode_chunk(i, c, x.data(), y.data());
+                for (std::size_t k = 0; k < m; ++k) out.push_back(Vec2{x[k], y[k]});
+            }
+        } else {
+            for (std::size_t c = 0; c < n_chunks(); ++c) {
+                for (Vec2 p : particle_chunk(i, c)) out.push_back(p);
+            }
+        }
+        return out;
+    }
+
+} // namespace sim
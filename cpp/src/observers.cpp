@@ -0,0 +1,357 @@
+// cpp/src/observers.cpp
+//
+// HistogramObserver, Moments and MomentObserver (see observers.hpp).
+//
+// Binning: u = (value - lo) * (1 / width); the bin is floor(u) when 0 <= u < n, else the
+// 'outside' column. NaN fails both comparisons and lands outside as well.
+//
+// Moments: with d = v - mean and n the new count, add() applies
+//   M4 += d^4 (n-1)(n^2-3n+3)/n^3 + 6 d^2 M2/n^2 - 4 d M3/n
+//   M3 += d^3 (n-1)(n-2)/n^2 - 3 d M2/n
+//   M2 += d^2 (n-1)/n
+// (old M2, M3 on the right). merge() uses the pairwise forms of the same sums.
+
+#include "sim/observers.hpp"
+#include "sim/checkpoint.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <iomanip>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+namespace sim {
+
+    void PositionObserver::save_state(std::ostream& /*os*/) const {
+        throw std::runtime_error("PositionObserver: this observer does not support checkpoints");
+    }
+
+    void PositionObserver::load_state(std::istream& /*is*/) {
+        throw std::runtime_error("PositionObserver: this observer does not support checkpoints");
+    }
+
+    HistogramObserver::HistogramObserver(Kind kind, Vec2 center, double u_lo, double u_hi, std::size_t nu,
+                                         double v_lo, double v_hi, std::size_t nv, std::size_t every)
+        : PositionObserver(every), kind_(kind), center_(center),
+          u_lo_(u_lo), u_w_((u_hi - u_lo) / static_cast<double>(nu)), u_inv_(static_cast<double>(nu) / (u_hi - u_lo)),
+          v_lo_(v_lo), v_w_((v_hi - v_lo) / static_cast<double>(nv)), v_inv_(static_cast<double>(nv) / (v_hi - v_lo)),
+          nx_(nu), ny_(nv)
+    {
+        assert(every >= 1 && "HistogramObserver: every must be >= 1");
+        assert(nu >= 1 && nv >= 1 && "HistogramObserver: need at least one bin per axis");
+        assert(u_hi > u_lo && v_hi > v_lo && "HistogramObserver: empty bin range");
+    }
+
+    HistogramObserver HistogramObserver::radial(Vec2 center, double r_max, std::size_t n_bins, std::size_t every) {
+        return HistogramObserver(Kind::Radial, center, 0.0, r_max, n_bins, 0.0, 1.0, 1, every);
+    }
+
+    HistogramObserver HistogramObserver::angular(Vec2 center, double theta_min, double theta_max,
+                                                 std::size_t n_bins, std::size_t every) {
+        return HistogramObserver(Kind::Angular, center, theta_min, theta_max, n_bins, 0.0, 1.0, 1, every);
+    }
+
+    HistogramObserver HistogramObserver::grid(double x_min, double x_max, std::size_t nx,
+                                              double y_min, double y_max, std::size_t ny, std::size_t every) {
+        return HistogramObserver(Kind::Grid, Vec2{0.0, 0.0}, x_min, x_max, nx, y_min, y_max, ny, every);
+    }
+
+    namespace {
+        /// floor((value - lo) * inv) if it lies in [0, n), else n.
+        inline std::size_t axis_bin(double value, double lo, double inv, std::size_t n) noexcept {
+            const double u = (value - lo) * inv;
+            return (u >= 0.0 && u < static_cast<double>(n)) ? static_cast<std::size_t>(u) : n;
+        }
+    } // namespace
+
+    std::size_t HistogramObserver::bin(double x, double y) const noexcept {
+        switch (kind_) {
+            case Kind::Radial:
+                return axis_bin(std::hypot(x - center_.x, y - center_.y), u_lo_, u_inv_, nx_);
+            case Kind::Angular:
+                return axis_bin(std::atan2(y - center_.y, x - center_.x), u_lo_, u_inv_, nx_);
+            case Kind::Grid: {
+                const std::size_t ix = axis_bin(x, u_lo_, u_inv_, nx_);
+                const std::size_t iy = axis_bin(y, v_lo_, v_inv_, ny_);
+                return (ix < nx_ && iy < ny_) ? iy * nx_ + ix : n_bins();
+            }
+        }
+        return n_bins();
+    }
+
+    void HistogramObserver::begin(std::size_t n_slots, std::size_t first_output, std::size_t n_outputs) {
+        run_first_ = first_output;
+        run_outputs_ = n_outputs;
+        local_.resize(std::max<std::size_t>(1, n_slots));
+        for (auto& l : local_) l.clear();   // keeps capacity for the next run
+    }
+
+    void HistogramObserver::observe(std::size_t slot, std::size_t output,
+                                    const double* x, const double* y, std::size_t count) {
+        assert(slot < local_.size() && "HistogramObserver::observe: slot out of range");
+        assert(output >= run_first_ && output - run_first_ < run_outputs_ &&
+               "HistogramObserver::observe: output outside the announced range");
+        const std::size_t width = n_bins() + 1;
+        auto& l = local_[slot];
+        if (l.empty()) l.assign(run_outputs_ * width, 0);
+        std::uint64_t* row = l.data() + (output - run_first_) * width;
+        for (std::size_t j = 0; j < count; ++j) ++row[bin(x[j], y[j])];
+    }
+
+    void HistogramObserver::end() {
+        const std::size_t width = n_bins() + 1;
+        const std::size_t n_out = std::max(n_outputs_, run_first_ + run_outputs_);
+        counts_.resize(n_out * width, 0);
+        n_outputs_ = n_out;
+
+        std::uint64_t* dst = counts_.data() + run_first_ * width;
+        for (auto& l : local_) {
+            for (std::size_t k = 0; k < l.size(); ++k) dst[k] += l[k];
+            l.clear();
+        }
+    }
+
+    std::uint64_t HistogramObserver::total(std::size_t f) const noexcept {
+        std::uint64_t t = 0;
+        for (std::size_t b = 0; b <= n_bins(); ++b) t += count(f, b);
+        return t;
+    }
+
+    void HistogramObserver::merge(const HistogramObserver& other) {
+        if (other.kind_ != kind_ || other.every() != every() || other.nx_ != nx_ || other.ny_ != ny_ ||
+            other.u_lo_ != u_lo_ || other.u_w_ != u_w_ || other.v_lo_ != v_lo_ || other.v_w_ != v_w_ ||
+            other.center_.x != center_.x || other.center_.y != center_.y) {
+            throw std::invalid_argument("HistogramObserver::merge: different kind, bins or every()");
+        }
+        n_outputs_ = std::max(n_outputs_, other.n_outputs_);
+        counts_.resize(n_outputs_ * (n_bins() + 1), 0);
+        for (std::size_t k = 0; k < other.counts_.size(); ++k) counts_[k] += other.counts_[k];
+    }
+
+    void HistogramObserver::clear() noexcept {
+        counts_.clear();
+        n_outputs_ = 0;
+    }
+
+    void HistogramObserver::save_state(std::ostream& os) const {
+        detail::write_pod<std::uint64_t>(os, every());
+        detail::write_pod<std::uint64_t>(os, n_bins());
+        detail::write_pod<std::uint64_t>(os, n_outputs_);
+        detail::write_vector(os, counts_);
+    }
+
+    void HistogramObserver::load_state(std::istream& is) {
+        const auto every = detail::read_pod<std::uint64_t>(is);
+        const auto bins = detail::read_pod<std::uint64_t>(is);
+        if (every != this->every() || bins != n_bins()) {
+            throw std::runtime_error("HistogramObserver::load_state: different every() or bins");
+        }
+        const auto n_out = detail::read_pod<std::uint64_t>(is);
+        std::vector<std::uint64_t> counts;
+        detail::read_vector(is, counts);
+        if (counts.size() != n_out * (bins + 1)) {
+            throw std::runtime_error("HistogramObserver::load_state: count table has the wrong size");
+        }
+        n_outputs_ = static_cast<std::size_t>(n_out);
+        counts_ = std::move(counts);
+    }
+
+    void HistogramObserver::write_text(std::ostream& os) const {
+        for (std::size_t f = 0; f < n_outputs_; ++f) {
+            const std::uint64_t t = total(f);
+            const double inv_t = t ? 1.0 / static_cast<double>(t) : 0.0;
+            for (std::size_t b = 0; b < n_bins(); ++b) {
+                os << f * every() << ' ';
+                if (kind_ == Kind::Grid) {
+                    os << center_u(b % nx_) << ' ' << center_v(b / nx_) << ' ';
+                } else {
+                    os << center_u(b) << ' ';
+                }
+                os << count(f, b) << ' ' << static_cast<double>(count(f, b)) * inv_t << '\n';
+            }
+        }
+    }
+
+    // ---- Moments ----
+
+    void Moments::add(double v) noexcept {
+        const double n1 = static_cast<double>(n);
+        ++n;
+        const double nn = static_cast<double>(n);
+        const double d = v - mean;
+        const double dn = d / nn;
+        const double dn2 = dn * dn;
+        const double term = d * dn * n1;
+        mean += dn;
+        m4 += term * dn2 * (nn * nn - 3.0 * nn + 3.0) + 6.0 * dn2 * m2 - 4.0 * dn * m3;
+        m3 += term * dn * (nn - 2.0) - 3.0 * dn * m2;
+        m2 += term;
+    }
+
+    void Moments::merge(const Moments& o) noexcept {
+        if (o.n == 0) return;
+        if (n == 0) {
+            *this = o;
+            return;
+        }
+        const double na = static_cast<double>(n);
+        const double nb = static_cast<double>(o.n);
+        const double nt = na + nb;
+        const double d = o.mean - mean;
+        const double d2 = d * d;
+
+        const double m4n = m4 + o.m4
+                         + d2 * d2 * na * nb * (na * na - na * nb + nb * nb) / (nt * nt * nt)
+                         + 6.0 * d2 * (na * na * o.m2 + nb * nb * m2) / (nt * nt)
+                         + 4.0 * d * (na * o.m3 - nb * m3) / nt;
+        const double m3n = m3 + o.m3
+                         + d2 * d * na * nb * (na - nb) / (nt * nt)
+                         + 3.0 * d * (na * o.m2 - nb * m2) / nt;
+        m2 += o.m2 + d2 * na * nb / nt;
+        m3 = m3n;
+        m4 = m4n;
+        mean += d * nb / nt;
+        n += o.n;
+    }
+
+    double Moments::variance() const noexcept {
+        return n < 2 ? 0.0 : m2 / static_cast<double>(n - 1);
+    }
+
+    double Moments::std_error() const noexcept {
+        return n < 2 ? 0.0 : std::sqrt(variance() / static_cast<double>(n));
+    }
+
+    double Moments::skewness() const noexcept {
+        return m2 > 0.0 ? std::sqrt(static_cast<double>(n)) * m3 / std::pow(m2, 1.5) : 0.0;
+    }
+
+    double Moments::kurtosis() const noexcept {
+        return m2 > 0.0 ? static_cast<double>(n) * m4 / (m2 * m2) - 3.0 : 0.0;
+    }
+
+    std::uint64_t Moments::required_samples(double half_width, double z) const noexcept {
+        if (!(half_width > 0.0)) return std::numeric_limits<std::uint64_t>::max();
+        const double r = z * std::sqrt(variance()) / half_width;
+        const double need = std::ceil(r * r);
+        if (!(need < 1.8e19)) return std::numeric_limits<std::uint64_t>::max();
+        return std::max<std::uint64_t>(2, static_cast<std::uint64_t>(need));
+    }
+
+    // ---- MomentObserver ----
+
+    MomentObserver::MomentObserver(std::size_t every, Vec2 center)
+        : PositionObserver(every), center_(center)
+    {
+        assert(every >= 1 && "MomentObserver: every must be >= 1");
+    }
+
+    void MomentObserver::begin(std::size_t n_slots, std::size_t first_output, std::size_t n_outputs) {
+        run_first_ = first_output;
+        run_outputs_ = n_outputs;
+        local_.resize(std::max<std::size_t>(1, n_slots));
+        for (auto& l : local_) l.clear();
+    }
+
+    void MomentObserver::observe(std::size_t slot, std::size_t output,
+                                 const double* x, const double* y, std::size_t count) {
+        assert(slot < local_.size() && "MomentObserver::observe: slot out of range");
+        assert(output >= run_first_ && output - run_first_ < run_outputs_ &&
+               "MomentObserver::observe: output outside the announced range");
+        auto& l = local_[slot];
+        if (l.empty()) l.assign(run_outputs_ * kQuantities, Moments{});
+        Moments* m = l.data() + (output - run_first_) * kQuantities;
+        for (std::size_t j = 0; j < count; ++j) {
+            const double dx = x[j] - center_.x;
+            const double dy = y[j] - center_.y;
+            m[X].add(x[j]);
+            m[Y].add(y[j]);
+            m[R].add(std::hypot(dx, dy));
+            m[Theta].add(std::atan2(dy, dx));
+        }
+    }
+
+    void MomentObserver::end() {
+        n_outputs_ = std::max(n_outputs_, run_first_ + run_outputs_);
+        acc_.resize(n_outputs_ * kQuantities);
+        Moments* dst = acc_.data() + run_first_ * kQuantities;
+        for (auto& l : local_) {
+            for (std::size_t k = 0; k < l.size(); ++k) dst[k].merge(l[k]);
+            l.clear();
+        }
+    }
+
+    void MomentObserver::merge(const MomentObserver& other) {
+        if (other.every() != every() || other.center_.x != center_.x || other.center_.y != center_.y) {
+            throw std::invalid_argument("MomentObserver::merge: different every() or center");
+        }
+        n_outputs_ = std::max(n_outputs_, other.n_outputs_);
+        acc_.resize(n_outputs_ * kQuantities);
+        for (std::size_t k = 0; k < other.acc_.size(); ++k) acc_[k].merge(other.acc_[k]);
+    }
+
+    void MomentObserver::write_text(std::ostream& os) const {
+        static const char* const names[kQuantities] = {"x", "y", "r", "theta"};
+        for (std::size_t f = 0; f < n_outputs_; ++f) {
+            for (std::size_t q = 0; q < kQuantities; ++q) {
+                const Moments& m = acc_[f * kQuantities + q];
+                os << f * every() << ' ' << names[q] << ' ' << m.n << ' ' << m.mean << ' '
+                   << m.std_error() << ' ' << m.variance() << ' ' << m.skewness() << ' '
+                   << m.kurtosis() << '\n';
+            }
+        }
+    }
+
+    void MomentObserver::save_state(std::ostream& os) const {
+        detail::write_pod<std::uint64_t>(os, every());
+        detail::write_pod(os, center_);
+        detail::write_pod<std::uint64_t>(os, n_outputs_);
+        detail::write_vector(os, acc_);
+    }
+
+    void MomentObserver::load_state(std::istream& is) {
+        const auto every = detail::read_pod<std::uint64_t>(is);
+        const Vec2 center = detail::read_pod<Vec2>(is);
+        if (every != this->every() || center.x != center_.x || center.y != center_.y) {
+            throw std::runtime_error("MomentObserver::load_state: different every() or center");
+        }
+        const auto n_out = detail::read_pod<std::uint64_t>(is);
+        std::vector<Moments> acc;
+        detail::read_vector(is, acc);
+        if (acc.size() != n_out * kQuantities) {
+            throw std::runtime_error("MomentObserver::load_state: moment table has the wrong size");
+        }
+        n_outputs_ = static_cast<std::size_t>(n_out);
+        acc_ = std::move(acc);
+    }
+
+    void MomentObserver::save(std::ostream& os) const {
+        const auto precision = os.precision(std::numeric_limits<double>::max_digits10);
+        os << "DMMCMOM1 " << every() << ' ' << center_.x << ' ' << center_.y << ' ' << n_outputs_ << '\n';
+        for (const Moments& m : acc_) {
+            os << m.n << ' ' << m.mean << ' ' << m.m2 << ' ' << m.m3 << ' ' << m.m4 << '\n';
+        }
+        os.precision(precision);
+    }
+
+    MomentObserver MomentObserver::load(std::istream& is) {
+        std::string magic;
+        std::size_t every = 0, n_outputs = 0;
+        Vec2 center;
+        if (!(is >> magic >> every >> center.x >> center.y >> n_outputs) || magic != "DMMCMOM1" || every == 0) {
+            throw std::runtime_error("MomentObserver::load: bad header");
+        }
+        MomentObserver obs(every, center);
+        obs.acc_.resize(n_outputs * kQuantities);
+        for (Moments& m : obs.acc_) {
+            if (!(is >> m.n >> m.mean >> m.m2 >> m.m3 >> m.m4)) {
+                throw std::runtime_error("MomentObserver::load: truncated data");
+            }
+        }
+        obs.n_outputs_ = n_outputs;
+        return obs;
+    }
+
+} // namespace sim
@@ -0,0 +1,174 @@
+// cpp/src/parallel.cpp
+//
+// Implementation of the fork-join ThreadPool and work_stealing_for() declared in parallel.hpp.
+//
+// Protocol:
+//   - parallel_for() publishes (fn, n_items, chunk), bumps generation_ and wakes workers.
+//   - Each background worker runs its own range once per generation, then decrements pending_.
+//   - The calling thread runs range 0 itself, then waits for pending_ == 0.
+// Ranges are fixed by (n_items, size()), so the particle -> thread mapping is deterministic.
+//
+// work_stealing_for() spawns its threads per call: its tasks are whole simulations, so thread
+// start-up is negligible, and each deque has its own mutex (contention is one lock per task).
+
+#include "sim/parallel.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+namespace sim {
+
+    std::size_t resolve_thread_count(std::size_t requested, std::size_t n_items) noexcept {
+        std::size_t t = requested;
+        if (t == 0) {
+            t = static_cast<std::size_t>(std::thread::hardware_concurrency());
+            if (t == 0) t = 1; // hardware_concurrency() may be unknown
+        }
+        return std::max<std::size_t>(1, std::min(t, n_items));
+    }
+
+    ThreadPool::ThreadPool(std::size_t n_threads) {
+        const std::size_t n = std::max<std::size_t>(1, n_threads);
+        workers_.reserve(n - 1);
+        for (std::size_t tid = 1; tid < n; ++tid) {
+            workers_.emplace_back([this, tid] { worker_loop(tid); });
+        }
+    }
+
+    ThreadPool::~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mtx_);
+            stop_ = true;
+        }
+        cv_start_.notify_all();
+        for (auto& w : workers_) w.join();
+    }
+
+    void ThreadPool::run_range(std::size_t tid) noexcept {
+        const std::size_t lo = std::min(n_items_, tid * chunk_);
+        const std::size_t hi = std::min(n_items_, lo + chunk_);
+        if (lo >= hi) return;
+        try {
+            (*fn_)(lo, hi, tid);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(mtx_);
+            if (!error_) error_ = std::current_exception();
+        }
+    }
+
+    void ThreadPool::worker_loop(std::size_t tid) {
+        std::size_t seen = 0;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(mtx_);
+                cv_start_.wait(lock, [&] { return stop_ || generation_ != seen; });
+                if (stop_) return;
+                seen = generation_;
+            }
+
+            run_range(tid);
+
+            {
+                std::lock_guard<std::mutex> lock(mtx_);
+                if (--pending_ == 0) cv_done_.notify_one();
+            }
+        }
+    }
+
+    void ThreadPool::parallel_for(std::size_t n_items, const RangeFn& fn) {
+        if (n_items == 0) return;
+
+        // Single thread: run inline, no synchronization.
+        if (workers_.empty()) {
+            fn(0, n_items, 0);
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mtx_);
+            fn_      = &fn;
+            n_items_ = n_items;
+            chunk_   = (n_items + size() - 1) / size();
+            pending_ = workers_.size();
+            error_   = nullptr;
+            ++generation_;
+        }
+        cv_start_.notify_all();
+
+        // Calling thread takes range 0.
+        run_range(0);
+
+        std::exception_ptr err;
+        {
+            std::unique_lock<std::mutex> lock(mtx_);
+            cv_done_.wait(lock, [&] { return pending_ == 0; });
+            fn_ = nullptr;
+            err = error_;
+            error_ = nullptr;
+        }
+        if (err) std::rethrow_exception(err);
+    }
+
+    namespace {
+        struct StealQueue {
+            std::mutex              mtx;
+            std::deque<std::size_t> items;
+        };
+    } // namespace
+
+    void work_stealing_for(std::size_t n_items, std::size_t n_threads, const ItemFn& fn) {
+        if (n_items == 0) return;
+        const std::size_t n = resolve_thread_count(n_threads, n_items);
+        if (n == 1) {
+            for (std::size_t i = 0; i < n_items; ++i) fn(i, 0);
+            return;
+        }
+
+        std::vector<std::unique_ptr<StealQueue>> queues;
+        for (std::size_t t = 0; t < n; ++t) queues.push_back(std::make_unique<StealQueue>());
+        for (std::size_t i = 0; i < n_items; ++i) queues[i % n]->items.push_back(i);
+
+        std::atomic<bool> failed{false};
+        std::mutex err_mtx;
+        std::exception_ptr error;
+
+        // Own front first, then the back of the other queues, starting with the next thread.
+        const auto next_item = [&](std::size_t tid, std::size_t& item) {
+            for (std::size_t k = 0; k < n; ++k) {
+                StealQueue& q = *queues[(tid + k) % n];
+                std::lock_guard<std::mutex> lock(q.mtx);
+                if (q.items.empty()) continue;
+                if (k == 0) {
+                    item = q.items.front();
+                    q.items.pop_front();
+                } else {
+                    item = q.items.back();
+                    q.items.pop_back();
+                }
+                return true;
+            }
+            return false;
+        };
+        const auto work = [&](std::size_t tid) {
+            std::size_t item = 0;
+            while (!failed.load(std::memory_order_relaxed) && next_item(tid, item)) {
+                try {
+                    fn(item, tid);
+                } catch (...) {
+                    std::lock_guard<std::mutex> lock(err_mtx);
+                    if (!error) error = std::current_exception();
+                    failed.store(true, std::memory_order_relaxed);
+                }
+            }
+        };
+
+        std::vector<std::thread> threads;
+        threads.reserve(n - 1);
+        for (std::size_t tid = 1; tid < n; ++tid) threads.emplace_back(work, tid);
+        work(0);
+        for (auto& t : threads) t.join();
+        if (error) std::rethrow_exception(error);
+    }
+
+} // namespace sim
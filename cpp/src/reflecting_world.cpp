@@ -5,7 +5,7 @@
 /// Implementation outline (advance_with_reflections):
 /// 1) p ← x; v ← d.
 /// 2) While |v| > 0 and bounces < MAX_REFLECTIONS:
-///    • Scan all walls for earliest time-of-impact t ∈ (0,1]; ignore near-parallel (EPS_DIR)
+///    • Scan all walls (or the grid candidates, if indexed) for earliest time-of-impact t ∈ (0,1]; ignore near-parallel (EPS_DIR)
 ///      and out-of-segment hits (with small endpoint tolerance).
 ///    • If none: p += v; break.
 ///    • Move to contact: p += t·v; nudge inside by EPS_POS·n̂.
@@ -21,18 +21,33 @@
 ///  - Simultaneous hits resolved by wall id, then insertion order (reproducible with fixed seed).
 
 /// Complexity:
-///  - O(#walls × bounces) per call; no dynamic allocation. Add broad-phase only if profiling warrants.
+///  - O(#walls × bounces) per call without an index.
+///  - With build_index(): a uniform grid (CSR cell lists) limits each scan to walls in cells
+///    overlapped by the padded displacement. Candidates are deduplicated and tested in
+///    insertion order, so the earliest hit and tie-breaks match the full scan exactly.
+///  - With compile(): the full scan runs over SoA columns, 4/8 walls per SIMD instruction
+///    (wall_kernels.cpp), with the same arithmetic and tie-break as test_wall().
+///  - advance_with_clearance(): steps shorter than a cached distance-to-boundary bound skip
+///    the scan entirely; only steps near a wall pay for the scan plus a clearance() query
+///    (O(#walls), or the grid ring search of nearest_wall() when indexed).
+///
+/// Absorbing walls (advance_to_absorbing):
+///  - Same trace; when the earliest hit is a wall with absorb > 0 the loop stops after the
+///    reflection update and reports the contact. Both entry points share trace(), so the
+///    reflecting arithmetic is the same instruction sequence.
 
 /// Test coverage (see tests/):
 ///  - Normal/oblique hits, start-on-wall stability, corner/endpoint contacts,
 ///    multi-bounce in a box, grazing trajectories.
 
 
+#include "sim/strict_fp.hpp"     // first: no FMA contraction in this file
 #include "sim/reflecting_world.hpp"
 #include <cassert>
 #include <cmath>
 #include <limits>
 #include <algorithm>
+#include <cstdint>
 
 namespace sim {
 
@@ -61,6 +76,52 @@ namespace sim {
         if (n <= EPS_DIR) return Vec2{0.0, 0.0};
         return Vec2{v.x / n, v.y / n};
     }
+
+    /// Padding that covers the advancer's parameter tolerance EPS_POS on a segment of
+    /// length len, plus a tiny relative slack for cell-boundary roundoff.
+    static inline double overlap_pad(double len) {
+        return EPS_POS * (1.0 + len) + 1e-9 * len;
+    }
+
+    /// Conservative test: does segment a->b, thickened by 'pad', overlap the axis-aligned
+    /// box [bx0, bx1] x [by0, by1]? (Separating-axis test on x, y and the segment normal.)
+    static inline bool segment_overlaps_box(const Vec2& a, const Vec2& b, double pad,
+                                            double bx0, double by0, double bx1, double by1) {
+        if (std::max(a.x, b.x) + pad < bx0 || std::min(a.x, b.x) - pad > bx1) return false;
+        if (std::max(a.y, b.y) + pad < by0 || std::min(a.y, b.y) - pad > by1) return false;
+        const Vec2 e{0.5 * (b.x - a.x), 0.5 * (b.y - a.y)};
+        const Vec2 m{0.5 * (a.x + b.x), 0.5 * (a.y + b.y)};
+        const Vec2 c{0.5 * (bx0 + bx1), 0.5 * (by0 + by1)};
+        const Vec2 h{0.5 * (bx1 - bx0), 0.5 * (by1 - by0)};
+        const Vec2 n{-e.y, e.x};                        // unnormalized segment normal
+        const double dist = std::abs(n.x * (m.x - c.x) + n.y * (m.y - c.y));
+        return dist <= h.x * std::abs(n.x) + h.y * std::abs(n.y) + pad * norm(n);
+    }
+
+    /// Clamp a coordinate to a cell index in [0, count).
+    static inline int cell_index(double v, double origin, double inv_cell, int count) {
+        const double f = std::floor((v - origin) * inv_cell);
+        if (!(f >= 0.0)) return 0;                      // also catches NaN
+        if (f >= static_cast<double>(count)) return count - 1;
+        return static_cast<int>(f);
+    }
+
+    /// Visit every grid cell overlapped by the padded segment a->b.
+    template <class Fn>
+    static inline void for_each_cell(const WallGrid& g, const Vec2& a, const Vec2& b, double pad, Fn&& fn) {
+        const int ix0 = cell_index(std::min(a.x, b.x) - pad, g.x0, g.inv_cell, g.nx);
+        const int ix1 = cell_index(std::max(a.x, b.x) + pad, g.x0, g.inv_cell, g.nx);
+        const int iy0 = cell_index(std::min(a.y, b.y) - pad, g.y0, g.inv_cell, g.ny);
+        const int iy1 = cell_index(std::max(a.y, b.y) + pad, g.y0, g.inv_cell, g.ny);
+        for (int iy = iy0; iy <= iy1; ++iy) {
+            for (int ix = ix0; ix <= ix1; ++ix) {
+                const double bx0 = g.x0 + ix * g.cell, by0 = g.y0 + iy * g.cell;
+                if (segment_overlaps_box(a, b, pad, bx0, by0, bx0 + g.cell, by0 + g.cell)) {
+                    fn(static_cast<std::size_t>(iy) * static_cast<std::size_t>(g.nx) + static_cast<std::size_t>(ix));
+                }
+            }
+        }
+    }
     
     // ===============================
     // WallSegment builders
@@ -127,6 +188,8 @@ namespace sim {
                     "add_segment: provided normal is near zero");
             
             walls.push_back(WallSegment{ a, b, n_hat, id});
+            clear_index();      // geometry changed: derived data is stale
+            compiled.clear();
     }
 
     /**
@@ -139,6 +202,8 @@ namespace sim {
                                            bool inward,
                                            int id) {
         walls.push_back(WallSegment::fromSegmentAutoNormal(a, b, inward, id));
+        clear_index();          // geometry changed: derived data is stale
+        compiled.clear();
     }
 
     /**
@@ -201,10 +266,226 @@ namespace sim {
         add_segment(a, b, n, id);
     }
 
+    // ===============================
+    // Broad phase (uniform grid)
+    // ===============================
+
+    /**
+     * @brief Bin every wall into the grid cells its padded extent overlaps.
+     *
+     * Two passes (count, then fill) produce a CSR layout; walls are visited in insertion
+     * order, so every cell list is ascending by wall index.
+     */
+    void ReflectingWorld::build_index(double cell_size) {
+        constexpr int kMaxCellsPerAxis = 1024;
+        grid = WallGrid{};
+        if (walls.empty()) return;
+
+        // Bounds: union of padded wall extents.
+        double xmin =  std::numeric_limits<double>::infinity(), ymin = xmin;
+        double xmax = -std::numeric_limits<double>::infinity(), ymax = xmax;
+        for (const auto& w : walls) {
+            const double pad = overlap_pad(norm(w.p1 - w.p0));
+            xmin = std::min(xmin, std::min(w.p0.x, w.p1.x) - pad);
+            xmax = std::max(xmax, std::max(w.p0.x, w.p1.x) + pad);
+            ymin = std::min(ymin, std::min(w.p0.y, w.p1.y) - pad);
+            ymax = std::max(ymax, std::max(w.p0.y, w.p1.y) + pad);
+        }
+        const double W = xmax - xmin, H = ymax - ymin;
+
+        // Cell size: caller-provided, or about one wall per cell; never finer than the cap.
+        double cell = cell_size > 0.0 ? cell_size : std::sqrt(W * H / static_cast<double>(walls.size()));
+        cell = std::max(cell, std::max(W, H) / kMaxCellsPerAxis);
+
+        WallGrid g;
+        g.x0 = xmin;
+        g.y0 = ymin;
+        g.cell = cell;
+        g.inv_cell = 1.0 / cell;
+        g.nx = std::max(1, std::min(kMaxCellsPerAxis, static_cast<int>(std::ceil(W / cell))));
+        g.ny = std::max(1, std::min(kMaxCellsPerAxis, static_cast<int>(std::ceil(H / cell))));
+        for (const auto& w : walls) g.max_len = std::max(g.max_len, norm(w.p1 - w.p0));
+
+        const std::size_t n_cells = static_cast<std::size_t>(g.nx) * static_cast<std::size_t>(g.ny);
+        std::vector<std::uint32_t> offs(n_cells + 1, 0);
+        for (const auto& w : walls) {
+            const double pad = overlap_pad(norm(w.p1 - w.p0));
+            for_each_cell(g, w.p0, w.p1, pad, [&](std::size_t c) { ++offs[c + 1]; });
+        }
+        for (std::size_t c = 0; c < n_cells; ++c) offs[c + 1] += offs[c];
+
+        g.cell_start = offs;
+        g.cell_walls.resize(offs[n_cells]);
+        for (std::size_t i = 0; i < walls.size(); ++i) {
+            const auto& w = walls[i];
+            const double pad = overlap_pad(norm(w.p1 - w.p0));
+            for_each_cell(g, w.p0, w.p1, pad, [&](std::size_t c) {
+                g.cell_walls[offs[c]++] = static_cast<std::uint32_t>(i);
+            });
+        }
+        grid = std::move(g);
+    }
+
+    std::size_t ReflectingWorld::set_absorbing(int id, double probability) {
+        assert(probability >= 0.0 && probability <= 1.0 && "set_absorbing: probability must be in [0, 1]");
+        std::size_t changed = 0;
+        for (auto& w : walls) {
+            if (w.id == id) {
+                w.absorb = probability;
+                ++changed;
+            }
+        }
+        return changed;
+    }
+
+    bool ReflectingWorld::has_absorbing() const noexcept {
+        return std::any_of(walls.begin(), walls.end(), [](const WallSegment& w) { return w.absorb > 0.0; });
+    }
+
+    void ReflectingWorld::clear_index() noexcept {
+        grid = WallGrid{};
+    }
+
+    void ReflectingWorld::compile() {
+        compiled.clear();
+        for (const auto& w : walls) compiled.push_back(w.p0, w.p1, w.n_hat, w.id);
+    }
+
+    /// Closest point to @p p on wall @p w (projection clamped to the segment).
+    static inline Vec2 closest_on_wall(const WallSegment& w, const Vec2& p) noexcept {
+        const Vec2 s = w.p1 - w.p0;
+        const double len2 = s.dot(s);
+        const double u = len2 > 0.0 ? std::clamp((p - w.p0).dot(s) / len2, 0.0, 1.0) : 0.0;
+        return w.p0 + u * s;
+    }
+
+    /**
+     * @brief Visit walls in grid rings around @p p (r = 0, 1, ...) until @p done(r) holds after
+     *        ring r; a wall missing from every cell within ring r lies entirely outside the
+     *        (2r+1)^2 block around p's cell, so it is at least r cells away.
+     *
+     * Falls back to visiting every wall when the world has no index or @p p lies outside the
+     * grid. A wall in several cells may be visited more than once.
+     */
+    template <class Visit, class Done>
+    static void ring_search(const ReflectingWorld& world, const Vec2& p, Visit&& visit_wall, Done&& done) {
+        const WallGrid& g = world.grid;
+        const double fx = (p.x - g.x0) * g.inv_cell, fy = (p.y - g.y0) * g.inv_cell;
+        const bool inside = world.has_index() && fx >= 0.0 && fy >= 0.0 &&
+                            fx < static_cast<double>(g.nx) && fy < static_cast<double>(g.ny);
+        if (!inside) {
+            for (std::size_t i = 0; i < world.walls.size(); ++i) visit_wall(i);
+            return;
+        }
+
+        const int cx = static_cast<int>(fx), cy = static_cast<int>(fy);
+        const int r_max = std::max(std::max(cx, g.nx - 1 - cx), std::max(cy, g.ny - 1 - cy));
+        const auto visit = [&](int ix, int iy) {
+            if (ix < 0 || iy < 0 || ix >= g.nx || iy >= g.ny) return;
+            const std::size_t c = static_cast<std::size_t>(iy) * static_cast<std::size_t>(g.nx) + static_cast<std::size_t>(ix);
+            for (std::uint32_t k = g.cell_start[c]; k < g.cell_start[c + 1]; ++k) visit_wall(g.cell_walls[k]);
+        };
+        for (int r = 0; r <= r_max; ++r) {
+            if (r == 0) {
+                visit(cx, cy);
+            } else {
+                for (int ix = cx - r; ix <= cx + r; ++ix) {
+                    visit(ix, cy - r);
+                    visit(ix, cy + r);
+                }
+                for (int iy = cy - r + 1; iy <= cy + r - 1; ++iy) {
+                    visit(cx - r, iy);
+                    visit(cx + r, iy);
+                }
+            }
+            if (done(r)) break;
+        }
+    }
+
+    /**
+     * @brief Minimum over walls of the point-segment distance, minus tolerances.
+     *
+     * The advancer accepts hits up to EPS_POS * len past either endpoint, so the distance to
+     * the segment is reduced by that much; a further EPS_POS * (1 + dist) covers roundoff in
+     * the intersection parameters.
+     */
+    double ReflectingWorld::clearance(const Vec2& p) const noexcept {
+        double c = std::numeric_limits<double>::infinity();
+        const auto visit_wall = [&](std::size_t i) {
+            const WallSegment& w = walls[i];
+            const double dist = norm(p - closest_on_wall(w, p));
+            c = std::min(c, dist - EPS_POS * (1.0 + norm(w.p1 - w.p0) + dist));
+        };
+        // A wall beyond ring r is at least d = r cells away and contributes at least
+        // d (1 - EPS_POS) - EPS_POS (1 + max_len); stop once c is below that (with slack as below).
+        const auto done = [&](int r) {
+            const double d = (static_cast<double>(r) - 1e-9) * grid.cell;
+            return c < d * (1.0 - EPS_POS) - EPS_POS * (1.0 + grid.max_len);
+        };
+        ring_search(*this, p, visit_wall, done);
+        return std::max(c, 0.0);
+    }
+
+    /// Point-segment distance from p to wall i; replaces best if closer (ties: lower index).
+    static inline void nearest_on_wall(const WallSegment& w, std::size_t i, const Vec2& p, NearestWall& best) {
+        const Vec2 q = closest_on_wall(w, p);
+        const double dist = norm(p - q);
+        const int idx = static_cast<int>(i);
+        if (dist < best.distance || (dist == best.distance && idx < best.wall)) {
+            best.wall = idx;
+            best.distance = dist;
+            best.point = q;
+        }
+    }
+
+    NearestWall ReflectingWorld::nearest_wall(const Vec2& p) const noexcept {
+        NearestWall best;
+        // Strict, with slack for p's cell assignment: an equally distant wall further out
+        // could still win the index tie-break.
+        ring_search(*this, p, [&](std::size_t i) { nearest_on_wall(walls[i], i, p, best); },
+                    [&](int r) { return best.distance < (static_cast<double>(r) - 1e-9) * grid.cell; });
+        return best;
+    }
+
     // ===============================
     // Advance with specular reflections
     // ===============================
 
+    /**
+     * @brief Narrow phase: intersect the path p -> p + v with wall i and keep it if it is
+     *        the earliest hit so far (ties broken by wall id, then insertion index).
+     */
+    static inline void test_wall(const WallSegment& w, std::size_t i, const Vec2& p, const Vec2& v, WallHit& best) {
+        const Vec2 a = w.p0;
+        const Vec2 b = w.p1;
+        const Vec2 s{ b.x - a.x, b.y - a.y }; // segment direction
+
+        const double denom = cross2(v, s);
+        if (std::abs(denom) <= EPS_DIR) return; // reject parallel/near-parallel
+
+        // Solve intersection: p + t v = a + u s
+        const Vec2 ap{ a.x - p.x, a.y - p.y };
+        const double t = cross2(ap, s) / denom;
+
+        // Require hit strictly ahead (t > 0) and within this displacement (t <= 1).
+        if (t <= EPS_POS || t > 1.0 + EPS_POS) return;
+
+        const double u = cross2(ap, v) / denom;
+        // Require intersection point to lie on the finite segment (0 <= u <= 1)
+        if (u < -EPS_POS || u > 1.0 + EPS_POS) return;
+
+        // If this is the earliest hit so far, keep it.
+        // Ties (nearly equal t) are broken by wall id, then insertion index.
+        if (t < best.t - 1e-15 ||
+            (std::abs(t - best.t) <= 1e-15 &&
+            (w.id < best.id || (w.id == best.id && static_cast<int>(i) < best.idx)))) {
+            best.t   = t;
+            best.idx = static_cast<int>(i);
+            best.n   = w.n_hat;
+            best.id  = w.id;
+        }
+    }
+
     /**
      * @brief Advance a 2D point by a proposed displacement with specular reflections.
      * 
@@ -227,62 +508,64 @@ namespace sim {
      *     the function halts deterministically at the last computed point and
      *     discards any leftover displacement.
      */
-    void advance_with_reflections(Vec2& x, Vec2 d, const ReflectingWorld& world) {
+    template <bool kStopAtAbsorbing>
+    static void trace(Vec2& x, Vec2& d, const ReflectingWorld& world, WallContact* contact) {
         Vec2 p = x;   // current position
         Vec2 v = d;   // remaining displacement
+        double left = 1.0;  // fraction of the path length still to travel (absorbing mode only)
 
         // Early exit: no meaningful displacement
         if (std::abs(v.x) <= EPS_DIR && std::abs(v.y) <= EPS_DIR) {
             x = p;
+            if (kStopAtAbsorbing) d = Vec2{0.0, 0.0};
             return;
         }
 
+        // Broad-phase scratch (candidate wall indices); reused across calls on this thread.
+        thread_local std::vector<std::uint32_t> candidates;
+        const bool use_grid = world.has_index();
+        const bool use_compiled = world.is_compiled();
+
         int bounces = 0;
         while (bounces < MAX_REFLECTIONS) {
-            double best_t   = std::numeric_limits<double>::infinity(); // earliest hit along v
-            int    best_idx = -1;                                      // index of hit wall
-            int    hit_id   = -1;                                      // id of hit wall
-            Vec2   hit_n{0.0, 0.0};                                    // normal of hit wall
-
-            // -------------------------------------------------
-            // Scan all walls for the earliest valid intersection
-            // -------------------------------------------------
-            for (std::size_t i = 0; i < world.walls.size(); ++i) {
-                const WallSegment& w = world.walls[i];
-                const Vec2 a = w.p0;
-                const Vec2 b = w.p1;
-                const Vec2 s{ b.x - a.x, b.y - a.y }; // segment direction
-
-                const double denom = cross2(v, s);
-                if (std::abs(denom) <= EPS_DIR) continue; // reject parallel/near-parallel
-
-                // Solve intersection: p + t v = a + u s
-                const Vec2 ap{ a.x - p.x, a.y - p.y };
-                const double t = cross2(ap, s) / denom;
-                
-                // Require hit strictly ahead (t > 0) and within this displacement (t <= 1).
-                if (t <= EPS_POS || t > 1.0 + EPS_POS) continue;
-
-                const double u = cross2(ap, v) / denom;
-                // Require intersection point to lie on the finite segment (0 <= u <= 1)
-                if (u < -EPS_POS || u > 1.0 + EPS_POS) continue;
-
-                // If this is the earliest hit so far, keep it.
-                // Ties (nearly equal t) are broken by wall id, then insertion index.
-                if (t < best_t - 1e-15 ||
-                    (std::abs(t - best_t) <= 1e-15 && 
-                    (w.id < hit_id || (w.id == hit_id && static_cast<int>(i) < best_idx)))) {
-                    best_t  = t;
-                    best_idx = static_cast<int>(i);
-                    hit_n   = w.n_hat;
-                    hit_id  = w.id;
+            WallHit best;
+
+            if (use_grid) {
+                // ---------------------------------------------------------------
+                // Broad phase: walls listed in cells overlapped by the padded path,
+                // deduplicated and tested in insertion order (same as full scan).
+                // ---------------------------------------------------------------
+                const WallGrid& g = world.grid;
+                const Vec2 q{ p.x + v.x, p.y + v.y };
+                candidates.clear();
+                for_each_cell(g, p, q, overlap_pad(norm(v)), [&](std::size_t c) {
+                    candidates.insert(candidates.end(),
+                                      g.cell_walls.begin() + g.cell_start[c],
+                                      g.cell_walls.begin() + g.cell_start[c + 1]);
+                });
+                std::sort(candidates.begin(), candidates.end());
+                candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+                for (const std::uint32_t i : candidates) {
+                    test_wall(world.walls[i], i, p, v, best);
+                }
+            } else {
+                // -------------------------------------------------
+                // Scan all walls for the earliest valid intersection
+                // (SoA SIMD kernel if compiled; same selection either way)
+                // -------------------------------------------------
+                if (use_compiled) {
+                    scan_walls(world.compiled, p, v, best);
+                } else {
+                    for (std::size_t i = 0; i < world.walls.size(); ++i) {
+                        test_wall(world.walls[i], i, p, v, best);
+                    }
                 }
             }
             
             // ---------------------------------------------------
             // No wall hit: finish remaining displacement and exit
             // ---------------------------------------------------
-            if (best_idx < 0 || !std::isfinite(best_t)) {
+            if (best.idx < 0 || !std::isfinite(best.t)) {
                 p += v;
                 break;
             }
@@ -292,19 +575,36 @@ namespace sim {
             // then reflect remaining displacement.
             // ------------------------------------------------
             // Move p to exact contact point
-            p += Vec2{ v.x * best_t, v.y * best_t };
+            p += Vec2{ v.x * best.t, v.y * best.t };
 
             // Nudge slightly along normal to prevent "sticking"
-            p += Vec2{ hit_n.x * EPS_POS, hit_n.y * EPS_POS };
+            p += Vec2{ best.n.x * EPS_POS, best.n.y * EPS_POS };
 
-            // Remaining displacement after consuming fraction best_t
-            const Vec2 v_remain{ v.x * (1.0 - best_t), v.y * (1.0 - best_t) };
+            // Remaining displacement after consuming fraction best.t
+            const Vec2 v_remain{ v.x * (1.0 - best.t), v.y * (1.0 - best.t) };
             
             // Reflect remainder across wall normal (specular reflection)
-            v = reflect_across_unit_normal(v_remain, hit_n);
+            v = reflect_across_unit_normal(v_remain, best.n);
 
             ++bounces;
 
+            // Absorbing wall: report the contact and hand back the reflected state.
+            if (kStopAtAbsorbing) {
+                const WallSegment& w = world.walls[static_cast<std::size_t>(best.idx)];
+                const double at = 1.0 - left * (1.0 - best.t);
+                left *= 1.0 - best.t;
+                if (w.absorb > 0.0) {
+                    contact->wall = best.idx;
+                    contact->id = w.id;
+                    contact->absorb = w.absorb;
+                    contact->point = p - Vec2{ best.n.x * EPS_POS, best.n.y * EPS_POS };
+                    contact->fraction = at;
+                    x = p;
+                    d = v;
+                    return;
+                }
+            }
+
             // Early exit: nothing left to move
             if (std::abs(v.x) <= EPS_DIR && std::abs(v.y) <= EPS_DIR) {
                 break;
@@ -313,6 +613,54 @@ namespace sim {
 
         // Write back final position (whether natural end or safet stop)
         x = p;
+        if (kStopAtAbsorbing) d = Vec2{0.0, 0.0};
+    }
+
+    void advance_with_reflections(Vec2& x, Vec2 d, const ReflectingWorld& world) {
+        trace<false>(x, d, world, nullptr);
+    }
+
+    WallContact advance_to_absorbing(Vec2& x, Vec2& d, const ReflectingWorld& world, double* clearance) {
+        WallContact contact;
+        if (clearance) {
+            // Interior early-out, as in advance_with_clearance().
+            if (std::abs(d.x) <= EPS_DIR && std::abs(d.y) <= EPS_DIR) {
+                d = Vec2{0.0, 0.0};
+                return contact;
+            }
+            const double reach = norm(d) * (1.0 + EPS_POS) + EPS_POS;
+            if (reach < *clearance) {
+                x += d;
+                *clearance -= reach;
+                d = Vec2{0.0, 0.0};
+                return contact;
+            }
+        }
+        trace<true>(x, d, world, &contact);
+        if (clearance) *clearance = world.clearance(x);
+        return contact;
+    }
+
+    /**
+     * @brief Interior early-out around advance_with_reflections().
+     *
+     * The fast path is exactly the advancer's no-hit branch (p += v), and mirrors its
+     * negligible-displacement exit, so results are bit-identical.
+     */
+    void advance_with_clearance(Vec2& x, Vec2 d, const ReflectingWorld& world, double& clearance) {
+        // Same early exit as the advancer: negligible displacement leaves x untouched.
+        if (std::abs(d.x) <= EPS_DIR && std::abs(d.y) <= EPS_DIR) return;
+
+        // Reach covers the t <= 1 + EPS_POS acceptance and per-step roundoff in x + d.
+        const double reach = norm(d) * (1.0 + EPS_POS) + EPS_POS;
+        if (reach < clearance) {
+            x += d;
+            clearance -= reach;
+            return;
+        }
+
+        advance_with_reflections(x, d, world);
+        clearance = world.clearance(x);
     }
 
-} // namespace sim 
\ No newline at end of file
+} // namespace sim
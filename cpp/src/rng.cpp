@@ -2,26 +2,230 @@
 // Implementation of RNG class defined in rng.hpp.
 
 #include "sim/rng.hpp"
+#include "sim/ziggurat.hpp"
+#include "sim/checkpoint.hpp"
 #include <random>
 #include <cstdint>
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
 
 namespace sim {
 
+    namespace {
+        constexpr double kTwoPi = 6.283185307179586476925286766559;
+
+        /// Map two 32-bit words to a double in [0, 1) using 53 random bits.
+        inline double to_unit_double(std::uint32_t a, std::uint32_t b) noexcept {
+            return ((a >> 5) * 67108864.0 + (b >> 6)) * (1.0 / 9007199254740992.0);
+        }
+
+        /// Name of the std::mt19937 text layout saved by this build. The layout is library
+        /// specific (libstdc++: the raw array plus its position; libc++: 624 rotated words),
+        /// so MT19937 words only load under the library that wrote them.
+        constexpr const char* kMtLayout =
+#if defined(_LIBCPP_VERSION)
+            "libc++";
+#elif defined(__GLIBCXX__)
+            "libstdc++";
+#elif defined(_MSVC_STL_VERSION)
+            "msvc";
+#else
+            "unknown";
+#endif
+    } // namespace
+
     // Default constructor: seed from hardware entropy.
     // Uses seed_seq to expand the entropy into the full mt19937 state.
-    RNG::RNG() {
+    RNG::RNG() : mt_(std::make_unique<MtState>()) {
         std::random_device rd;
         std::seed_seq seq{rd(), rd(), rd(), rd(), rd(), rd(), rd(), rd()};
-        gen.seed(seq);
+        mt_->gen.seed(seq);
     }
 
     // Deterministic seeding constructor: reproducible streams.
     // Note: mt19937 expects a 32-bit seed.
-    RNG::RNG(std::uint32_t seed): gen(seed) {}
-    
+    RNG::RNG(std::uint32_t seed) : mt_(std::make_unique<MtState>()) {
+        mt_->gen.seed(seed);
+    }
+
+    // Engine-selecting constructor.
+    //  - MT19937: legacy per-stream seed = seed + stream (mod 2^32), matching Simulation's policy.
+    //  - Philox: key = 64-bit seed (high stream bits folded into key[1]); counter carries the
+    //    low 32 stream bits and the step index.
+    RNG::RNG(RngEngine engine, std::uint64_t seed, std::uint64_t stream, NormalMethod normal)
+        : engine_(engine), normal_(normal) {
+        if (engine_ == RngEngine::MT19937) {
+            mt_ = std::make_unique<MtState>();
+            mt_->gen.seed(static_cast<std::uint32_t>(seed + stream));
+            return;
+        }
+        key_ = Philox4x32::key_type{static_cast<std::uint32_t>(seed),
+                                    static_cast<std::uint32_t>(seed >> 32) ^ static_cast<std::uint32_t>(stream >> 32)};
+        stream_ = static_cast<std::uint32_t>(stream);
+    }
+
+    RNG::RNG(const RNG& other)
+        : engine_(other.engine_), normal_(other.normal_),
+          mt_(other.mt_ ? std::make_unique<MtState>(*other.mt_) : nullptr),
+          key_(other.key_), stream_(other.stream_), step_(other.step_), block_(other.block_),
+          buf_(other.buf_), buf_pos_(other.buf_pos_), has_spare_(other.has_spare_), spare_(other.spare_) {}
+
+    RNG& RNG::operator=(const RNG& other) {
+        if (this != &other) {
+            RNG tmp(other);
+            *this = std::move(tmp);
+        }
+        return *this;
+    }
+
+    // Next 32-bit word of the Philox stream; refills one 4-word block at a time.
+    std::uint32_t RNG::next_u32() {
+        if (buf_pos_ == 4) {
+            buf_ = Philox4x32::block(Philox4x32::counter_type{block_++, stream_,
+                                                              static_cast<std::uint32_t>(step_),
+                                                              static_cast<std::uint32_t>(step_ >> 32)},
+                                     key_);
+            buf_pos_ = 0;
+        }
+        return buf_[buf_pos_++];
+    }
+
+    // 64-bit word for the Ziggurat sampler (high word drawn first).
+    std::uint64_t RNG::next_u64() {
+        std::uint32_t hi, lo;
+        if (engine_ == RngEngine::MT19937) {
+            hi = static_cast<std::uint32_t>(mt_->gen());
+            lo = static_cast<std::uint32_t>(mt_->gen());
+        } else {
+            hi = next_u32();
+            lo = next_u32();
+        }
+        return (static_cast<std::uint64_t>(hi) << 32) | lo;
+    }
+
     // Draw one sample from the standard normal distribution N(0, 1).
-    double RNG::gauss() { 
-        return dist(gen);
+    //  - Ziggurat: table method on 64-bit words (either engine).
+    //  - Legacy MT19937: std::normal_distribution (implementation-defined, kept for old runs).
+    //  - Legacy Philox: Box-Muller on two 53-bit uniforms; the second variate is cached.
+    double RNG::gauss() {
+        if (normal_ == NormalMethod::Ziggurat) {
+            return ziggurat_normal([this] { return next_u64(); });
+        }
+        if (engine_ == RngEngine::MT19937) {
+            return mt_->dist(mt_->gen);
+        }
+        if (has_spare_) {
+            has_spare_ = false;
+            return spare_;
+        }
+        const double u1 = 1.0 - uniform();          // (0, 1]: log() stays finite
+        const double u2 = uniform();
+        const double r  = std::sqrt(-2.0 * std::log(u1));
+        const double th = kTwoPi * u2;
+        spare_     = r * std::sin(th);
+        has_spare_ = true;
+        return r * std::cos(th);
+    }
+
+    void RNG::fill_gauss(double* out, std::size_t n) {
+        if (normal_ == NormalMethod::Ziggurat) {
+            ziggurat_fill([this] { return next_u64(); }, out, n);
+            return;
+        }
+        for (std::size_t i = 0; i < n; ++i) out[i] = gauss();
+    }
+
+    double RNG::uniform() {
+        if (engine_ == RngEngine::MT19937) {
+            const std::uint32_t a = static_cast<std::uint32_t>(mt_->gen());
+            const std::uint32_t b = static_cast<std::uint32_t>(mt_->gen());
+            return to_unit_double(a, b);
+        }
+        const std::uint32_t a = next_u32();
+        const std::uint32_t b = next_u32();
+        return to_unit_double(a, b);
+    }
+
+    void RNG::seek_step(std::uint64_t step) noexcept {
+        if (engine_ != RngEngine::Philox4x32) return;
+        step_      = step;
+        block_     = 0;
+        buf_pos_   = 4;
+        has_spare_ = false;
+    }
+
+    void RNG::save(std::ostream& os) const {
+        detail::write_pod<std::uint32_t>(os, static_cast<std::uint32_t>(engine_));
+        detail::write_pod<std::uint32_t>(os, static_cast<std::uint32_t>(normal_));
+        // MT19937: the numbers of the engine's text form (624 state words, plus the position in
+        // libstdc++) as uint32s, tagged with the layout that produced them; the distribution's
+        // few numbers (spare variate) stay in text form.
+        std::vector<std::uint32_t> words;
+        std::string layout, dist;
+        if (mt_) {
+            layout = kMtLayout;
+            std::ostringstream text;
+            text << mt_->gen;
+            std::istringstream in(text.str());
+            for (unsigned long w = 0; in >> w;) words.push_back(static_cast<std::uint32_t>(w));
+            std::ostringstream d;
+            d << mt_->dist;
+            dist = d.str();
+        }
+        detail::write_string(os, layout);
+        detail::write_vector(os, words);
+        detail::write_string(os, dist);
+        detail::write_pod(os, key_);
+        detail::write_pod(os, stream_);
+        detail::write_pod(os, step_);
+        detail::write_pod(os, block_);
+        detail::write_pod(os, buf_);
+        detail::write_pod(os, buf_pos_);
+        detail::write_pod<std::uint8_t>(os, has_spare_ ? 1 : 0);
+        detail::write_pod(os, spare_);
+    }
+
+    void RNG::load(std::istream& is) {
+        const auto engine = detail::read_pod<std::uint32_t>(is);
+        const auto normal = detail::read_pod<std::uint32_t>(is);
+        if (engine > static_cast<std::uint32_t>(RngEngine::Philox4x32) ||
+            normal > static_cast<std::uint32_t>(NormalMethod::Ziggurat)) {
+            throw std::runtime_error("RNG::load: unknown engine or normal method");
+        }
+        engine_ = static_cast<RngEngine>(engine);
+        normal_ = static_cast<NormalMethod>(normal);
+        const std::string layout = detail::read_string(is);
+        std::vector<std::uint32_t> words;
+        detail::read_vector(is, words);
+        const std::string dist = detail::read_string(is);
+        if (engine_ == RngEngine::MT19937) {
+            if (layout != kMtLayout) {
+                throw std::runtime_error("RNG::load: MT19937 state written by " + layout +
+                                         ", this build reads " + kMtLayout);
+            }
+            if (words.size() < std::mt19937::state_size || words.size() > std::mt19937::state_size + 1) {
+                throw std::runtime_error("RNG::load: bad MT19937 state size");
+            }
+            std::ostringstream text;
+            for (std::uint32_t w : words) text << w << ' ';
+            auto state = std::make_unique<MtState>();
+            std::istringstream gen(text.str()), normal(dist);
+            if (!(gen >> state->gen) || !(normal >> state->dist)) throw std::runtime_error("RNG::load: bad MT19937 state");
+            mt_ = std::move(state);
+        } else {
+            mt_.reset();
+        }
+        key_       = detail::read_pod<Philox4x32::key_type>(is);
+        stream_    = detail::read_pod<std::uint32_t>(is);
+        step_      = detail::read_pod<std::uint64_t>(is);
+        block_     = detail::read_pod<std::uint32_t>(is);
+        buf_       = detail::read_pod<Philox4x32::counter_type>(is);
+        buf_pos_   = detail::read_pod<std::uint32_t>(is);
+        has_spare_ = detail::read_pod<std::uint8_t>(is) != 0;
+        spare_     = detail::read_pod<double>(is);
+        if (buf_pos_ > 4) throw std::runtime_error("RNG::load: bad Philox buffer position");
     }
 
-} // namespace sim
\ No newline at end of file
+} // namespace sim
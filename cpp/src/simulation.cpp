@@ -5,19 +5,38 @@
  * @brief Implementation of sim::Simulation (step generation, reflections, history).
  * 
  * @details
- * Responsibilities implemented here (public contract in simulation.hpp):
+ * The step loop itself lives in BasicSimulation (basic_simulation.hpp); this file seeds
+ * sim::RNG streams, compiles the runtime-dispatched core once, and implements the facade.
+ *
+ * Responsibilities (public contract in simulation.hpp):
  *   - Initialize per-particle RNGs
  *      - deterministic: seed = base_seed + particle_index
  *      - non-deterministic: hardware seeding
+ *      - Philox engine: key = base_seed, stream = particle_index, counter = step index
+ *      - normal_method selects the N(0,1) sampler (legacy or Ziggurat) for either engine
+ *   - Step policy: chosen once per run() from the step_type column; populations with
+ *     Brownian particles run grouped (BasicSimulation::run_grouped): Brownian groups of
+ *     equal params use BrownianStep, Specified ones CallbackStep / SpecifiedParamsStep
  *   - Per step:
  *      1. select the particle's step model (Brownian or Specified)
- *      2. generate a proposed displacement (uses RNG for Brownian)
- *      3. apply dx, then enforce geometry via advance_with_reflections(...)
+ *      2. generate a proposed displacement (uses RNG for Brownian); Brownian
+ *         displacements are computed in sub-batches via brownian_fill(), with
+ *         hoisted coefficients when all particles share one BrownianParams
+ *      3. apply dx, then enforce geometry via advance_with_reflections(...), or via
+ *         advance_with_clearance(...) when use_clearance (interior steps skip the scan)
  *      4. record history when (recorded_history && step_index % store_every == 0)
+ *   - History: in memory (history()) or streamed to a HistorySink in frame blocks that a
+ *     background writer drains while the next block is computed (history_sink.hpp)
+ *   - Threading: particles are split into contiguous ranges (one per thread, see
+ *     parallel.hpp); each range runs the full step loop independently
+ *   - Loop order: step-major walks all particles of a range per step; particle-major
+ *     runs tiles of tile_size particles through all steps (better cache reuse)
  * 
  * Invariants & policies
- *   - Sizes match:
- *      pos_.size() == step_type.size() == brownian_params_.size() == rngs_.size()
+ *   - Sizes match: every ParticleStore column has n_particles entries
+ *     (x, y, step_type, dt, D, mu_x, mu_y, spec, rng)
+ *   - SoA layout: kernels read/write the x[]/y[] and parameter columns directly;
+ *     positions() exposes them without copying
  *   - Reproducibility: same config + seeds -> identical histories
  *   - History memory ~ O(n_particles * n_steps / store_every); reserve when possible
  * 
@@ -33,239 +52,146 @@
  */
 
 #include "sim/simulation.hpp"
+#include <algorithm>
 #include <cassert>
+#include <random>
 
 namespace sim {
-    
-    Simulation::Simulation(const ReflectingWorld& world, const SimulationConfig& cfg)
-        : world_(&world), cfg_(cfg)
-    {
-        const std::size_t n = cfg_.n_particles;
-
-        // Basic config sanity (debug-only)
-        assert(cfg_.store_every >= 1 && "SimulationConfig::store_every must be >= 1");
-
-        // ---- Initialize particle state ----
-
-        // Positions: start at the origin unless the caller overrides via set_positions(s).
-        pos_.assign(n, Vec2{0.0, 0.0});
-
-        // Step types: default all to Brownian; callers may override per particle.
-        step_type_.assign(n, StepType::Brownian);
-
-        // Per-particle parameters: start from config defaults (Brownian) and
-        // a default-constructed specified-step params object.
-        brownian_params_.assign(n, cfg_.brownian);
-        spec_params_.assign(n, SpecifiedStepParams{});
 
-        // ---- RNG setup ----
+    void seed_rngs(std::vector<RNG>& rngs, std::size_t n, const SimulationConfig& cfg) {
         // One RNG per particle:
-        //  - Deterministic: per-particle seed = base_seed + particle_index (mod 2^32).
-        //  - Non-deterministic: hardware/entropy-based seeding via RNG default ctor.
-        rngs_.clear();
-        rngs_.reserve(n);
-        if (cfg_.deterministic) {
+        //  - Philox (counter-based): key = base_seed (or one entropy draw if not deterministic),
+        //    stream = particle_index; each step re-seeks the stream to the step index.
+        //  - MT19937, deterministic: per-particle seed = base_seed + particle_index (mod 2^32).
+        //  - particle_index = cfg.first_particle + i (0-based offset for batched runs).
+        //  - MT19937, non-deterministic: hardware/entropy-based seeding via RNG default ctor
+        //    (legacy sampler), or one entropy draw used as base seed (Ziggurat sampler).
+        rngs.clear();
+        rngs.reserve(n);
+        const bool legacy_mt = cfg.rng_engine == RngEngine::MT19937 &&
+                               cfg.normal_method == NormalMethod::Legacy;
+        if (legacy_mt && cfg.deterministic) {
             for (std::size_t i = 0; i < n; ++i) {
                 // Note: cast clarifies the intended 32-bit wraparound semantics if RNG uses uint32_t seeds.
-                const unsigned int seed = static_cast<unsigned int>(cfg_.base_seed + static_cast<unsigned int>(i));
-                rngs_.emplace_back(seed);
+                const unsigned int seed = static_cast<unsigned int>(cfg.base_seed + static_cast<unsigned int>(cfg.first_particle + i));
+                rngs.emplace_back(seed);
+            }
+        } else if (legacy_mt) {
+            for (std::size_t i = 0; i < n; ++i) {
+                rngs.emplace_back(); // hardware-seeded
             }
         } else {
+            std::uint64_t key = cfg.base_seed;
+            if (!cfg.deterministic) {
+                std::random_device rd;
+                key = (static_cast<std::uint64_t>(rd()) << 32) | rd();
+            }
             for (std::size_t i = 0; i < n; ++i) {
-                rngs_.emplace_back(); // hardware-seeded
+                rngs.emplace_back(cfg.rng_engine, key, static_cast<std::uint64_t>(cfg.first_particle + i), cfg.normal_method);
             }
         }
+    }
 
-        // ---- History containers ----
-        if (cfg_.record_history) {
-            hist_.assign(n, {});
+    template class BasicSimulation<MixedStep, ReflectingWorld, RNG>;
 
-            // Reserve to avoid frequent reallocations:
-            // frames = 1 (initial) + ceil(n_steps / store_every)
-            const std::size_t frames = 1 + (cfg_.n_steps + cfg_.store_every - 1) / cfg_.store_every;
-            for (auto& h : hist_) h.reserve(frames);
+    // ===============================
+    // Simulation facade
+    // ===============================
 
-            // Record initial positions (time index 0) unconditionally.
-            for (std::size_t i = 0; i < n; ++i) {
-                hist_[i].push_back(pos_[i]);
-            }
-        }
+    Simulation::Simulation(const ReflectingWorld& world, const SimulationConfig& cfg)
+        : core_(world, cfg) {}
 
-        #ifndef NDEBUG
-            // Invariants: all per-particle arrays must have the same size.
-            const bool sizes_ok = 
-                pos_.size() == step_type_.size() &&
-                pos_.size() == brownian_params_.size() &&
-                pos_.size() == rngs_.size() &&
-                (!cfg_.record_history || hist_.size() == pos_.size());
-            assert(sizes_ok && "Per-particle containers must be the same length.");
-        #endif
-    }
+    void Simulation::set_step_type_all(StepType type) { core_.set_step_type_all(type); }
 
-    void Simulation::set_step_type_all(StepType type) {
-        // Assign the same step model to every particle. O(n_particles).
-        for (auto& t : step_type_) {
-            t = type;
-        }
-    }
+    void Simulation::set_step_type(std::size_t i, StepType type) { core_.set_step_type(i, type); }
 
-    void Simulation::set_step_type(std::size_t i, StepType type) {
-        assert(i < step_type_.size() && "set_step_type: particle index out of range");
-        step_type_[i] = type;
-    }
+    void Simulation::set_brownian_params(std::size_t i, const BrownianParams& p) { core_.set_brownian_params(i, p); }
 
-    void Simulation::set_brownian_params(std::size_t i, const BrownianParams& p) {
-        assert(i < brownian_params_.size() && "set_brownian_params: particle index out of range");
-        brownian_params_[i] = p;
-    }
+    void Simulation::set_specified_params(std::size_t i, const SpecifiedStepParams& p) { core_.set_specified_params(i, p); }
 
-    void Simulation::set_specified_params(std::size_t i, const SpecifiedStepParams& p) {
-        assert(i < spec_params_.size() && "set_specified_params: particle index out of range");
-        spec_params_[i] = p;
-    }
-
-    void Simulation::set_specified_params_all(const SpecifiedStepParams& p) {
-        // Broadcast the same specified-step params to all particles. O(n_particles)
-        for (auto& sp : spec_params_) {
-            sp = p;
-        }
-    }
+    void Simulation::set_specified_params_all(const SpecifiedStepParams& p) { core_.set_specified_params_all(p); }
 
     void Simulation::set_specified_callback(SpecifiedCallback cb) {
         // Passing an empty std::function clears the callback; specified-step particles
         // will then rely on SpecifiedStepParams / generator defaults.
-        specified_cb_ = std::move(cb);
+        core_.step_policy().callback = std::move(cb);
     }
 
-    void Simulation::set_positions(const std::vector<Vec2>& positions) {
-        assert(positions.size() == pos_.size() && "set_positions: size mismatch with n_particles");
-        pos_ = positions;
+    void Simulation::set_positions(const std::vector<Vec2>& positions) { core_.set_positions(positions); }
 
-        // If recording, reset history to start from these positions (time index 0).
-        if (cfg_.record_history) {
-            const std::size_t n = pos_.size();
-            hist_.assign(n, {});
+    void Simulation::set_position(std::size_t i, const Vec2& p) { core_.set_position(i, p); }
 
-            // Reserve: 1 initial frame + ceil(n_steps / store_every)
-            const std::size_t frames = 1 + (cfg_.n_steps + cfg_.store_every - 1) / cfg_.store_every;
-            for (auto& h : hist_) h.reserve(frames);
+    void Simulation::set_history_sink(HistorySink* sink, std::size_t first_frame) {
+        core_.set_history_sink(sink, first_frame);
+    }
 
-            for (std::size_t i = 0; i < pos_.size(); ++i) {
-                hist_[i].push_back(pos_[i]);
-            }
-        }
+    void Simulation::add_observer(PositionObserver* observer) { core_.add_observer(observer); }
+    void Simulation::clear_observers() noexcept { core_.clear_observers(); }
 
-        #ifndef NDEBUG
-            // Invariants: when recording, history vectors exist and sizes match.
-            if (cfg_.record_history) {
-                assert(hist_.size() == pos_.size() && "set_positions: history size must match n_particles");
-            }
+    void Simulation::run() { advance(Core::kRunEnd); }
+
+    void Simulation::run_until(std::size_t step) { advance(step); }
 
-        #endif
+    void Simulation::run_steps(std::size_t k) {
+        if (core_.particles().size() == 0 || core_.config().n_steps == 0) return;
+        while (k > 0) {
+            const std::size_t take = std::min(k, core_.config().n_steps - core_.run_position());
+            advance(core_.run_position() + take);
+            k -= take;
+        }
     }
 
-    void Simulation::set_position(std::size_t i, const Vec2& p) {
-        assert(i < pos_.size() && "set_position: particle index out of range");
-        pos_[i] = p;
+    void Simulation::advance(std::size_t until) {
+        // Pick the step policies once: homogeneous groups skip the per-particle switch.
+        const auto& types = core_.particles().step_type;
+        const bool all_specified = std::all_of(types.begin(), types.end(),
+                                               [](StepType t) { return t == StepType::Specified; });
+        const SpecifiedCallback& cb = core_.step_policy().callback;
 
-        if (cfg_.record_history) {
-            // Ensure history exists; this keeps the "frame 0 = initial positions" contract.
-            if (hist_.empty()) {
-                const std::size_t n = pos_.size();
-                hist_.assign(n, {});
-                const std::size_t frames = 1 + (cfg_.n_steps + cfg_.store_every - 1) / cfg_.store_every;
-                for (auto& h : hist_) h.reserve(frames);
+        if (all_specified) {
+            if (cb) {
+                core_.run_with(CallbackStep<const SpecifiedCallback&>{cb}, until);
             } else {
-    #ifndef NDEBUG
-                // If any particle already has >1 frames, likely started stepping-change frame 0
-                // would desync the timeline. Encourage using set_positions() or a dedicated reset().
-                for (const auto& h : hist_) {
-                    assert(h.size() <= 1 && "set_position: called after stepping; use set_positions() or reset()");
-                }
-    #endif
-                assert(hist_.size() == pos_.size() && "set_position: history size must match n_particles");
-            }   
-
-        // Keep consistent: ensure/overwrite the initial frame for particle i.
-        if (hist_[i].empty()) {
-            hist_[i].push_back(p);
-        } else {
-            hist_[i][0] = p;
+                core_.run_with(SpecifiedParamsStep{}, until);
             }
+        } else if (cb) {
+            core_.run_grouped(BrownianStep{}, CallbackStep<const SpecifiedCallback&>{cb}, until);
+        } else {
+            core_.run_grouped(BrownianStep{}, SpecifiedParamsStep{}, until);
         }
     }
 
-    void Simulation::run() {
-        const std::size_t n = pos_.size();
-        if (n == 0 || cfg_.n_steps == 0) return;
-
-        assert(world_ != nullptr && "run: world_ must be set");
-    #ifndef NDEBUG
-        // Sanity: per-particle containers must align; history stride must be valid.
-        assert(step_type_.size()       == n && "run: step_type_ size mismatch");
-        assert(brownian_params_.size() == n && "run: brownian_params_ size mismatch");
-        assert(rngs_.size()            == n && "run: rngs_ size mismatch");
-        assert(cfg_.store_every >= 1        && "run: store_every must be >=1");
-    #endif
-
-        // History setup (policy): frame 0 = initial positions.
-        if (cfg_.record_history && hist_.size() != n) {
-            hist_.assign(n, {});
-            const std::size_t frames = 1 + (cfg_.n_steps + cfg_.store_every - 1) / cfg_.store_every;
-            for (auto& h : hist_) h.reserve(frames);
-            for (std::size_t i = 0; i < n; ++i) hist_[i].push_back(pos_[i]); // frame 0
-        }
-
-        const bool record = cfg_.record_history;
-        const std::size_t stride = cfg_.store_every; // record every 'stride' steps
+    PositionsView Simulation::positions() const noexcept {
+        // Current particle positions (size == config().n_particles); zero-copy over x[]/y[].
+        return core_.positions();
+    }
 
-        // ---- Main integration loop ---
-        for (std::size_t k = 0; k < cfg_.n_steps; ++k) {
-            // HOT PATH: per-particle step selection + reflection enforcement.
-            for (std::size_t i = 0; i < n; ++i) {
-                Vec2 d{0.0, 0.0};
+    const ParticleStore& Simulation::particles() const noexcept {
+        return core_.particles();
+    }
 
-                // Step model dispatch: Brownian uses RNG with BrownianParams;
-                // Specified uses a callback if provided, else SpecifiedStepParams;
-                switch (step_type_[i]) {
-                    case StepType::Brownian:
-                        d = brownian_step(brownian_params_[i], rngs_[i]);
-                        break;
-                    case StepType::Specified:
-                        d = specified_cb_
-                            ? specified_cb_(i, k, pos_[i], rngs_[i])
-                            : specified_step(spec_params_[i], k, pos_[i], rngs_[i]);
-                        break;
-                    default: 
-                        assert(false && "run: unknown StepType");
-                        break;
-                }
+    std::size_t Simulation::n_absorbed() const noexcept {
+        return core_.n_absorbed();
+    }
 
-                // Geometry policy: reflect proposed displacement inside world.
-                advance_with_reflections(pos_[i], d, *world_);
-            }
+    void Simulation::save_checkpoint(const std::string& path) const { core_.save_checkpoint(path); }
+    void Simulation::load_checkpoint(const std::string& path) { core_.load_checkpoint(path); }
 
-            // History policy: append positions every 'stride' steps (no forced final frame).
-            if (record && ((k+1) % stride == 0)) {
-                for (std::size_t i = 0; i < n; i++) {
-                    hist_[i].push_back(pos_[i]);
-                }
-            }
-        }
+    std::size_t Simulation::streamed_frames() const noexcept {
+        return core_.streamed_frames();
     }
 
-    const std::vector<Vec2>& Simulation::positions() const noexcept {
-        // Current particle positions (size == config().n_particles).
-        return pos_;
+    std::size_t Simulation::run_position() const noexcept {
+        return core_.run_position();
     }
 
     const std::vector<std::vector<Vec2>>& Simulation::history() const noexcept {
         // Trajectories (may be empty if record_history == false).
-        return hist_;
+        return core_.history();
     }
 
     const SimulationConfig& Simulation::config() const noexcept {
         // Effective configuration copied at construction.
-        return cfg_;
+        return core_.config();
     }
-} // namespace sim
\ No newline at end of file
+} // namespace sim
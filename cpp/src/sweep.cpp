@@ -0,0 +1,317 @@
+// cpp/src/sweep.cpp
+//
+// params_list.txt rows as in-process simulation tasks (see sweep.hpp).
+
+#include "sim/sweep.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#include "sim/analytic_worlds.hpp"
+#include "sim/basic_simulation.hpp"
+#include "sim/parallel.hpp"
+
+namespace sim {
+
+    namespace {
+        constexpr double kPi = 3.141592653589793238462643383279502884;
+
+        // Particles [first, first + count) of a row: the streams they draw in the whole row.
+        struct Part {
+            const SweepParams* row;
+            std::size_t        first;
+            std::size_t        count;
+        };
+
+        const char* geometry_name(SweepGeometry g) {
+            return g == SweepGeometry::Quarter ? "quarter" : "eighth";
+        }
+
+        // Grid side L (see sweep.hpp); rows without a positive grid are rejected.
+        double grid_extent(const SweepParams& p) {
+            const double extent = std::max(p.x0, p.y0) + 6.0 * std::sqrt(2.0 * p.d * p.tf);
+            if (!(extent > 0.0) || !std::isfinite(extent)) {
+                throw std::runtime_error("sweep: empty histogram grid, max(x0, y0) + 6 sqrt(2 d tf) = " +
+                                         std::to_string(extent) + " (need > 0) for tf " + p.text[0] +
+                                         " d " + p.text[1] + " x0 " + p.text[2] + " y0 " + p.text[3]);
+            }
+            return extent;
+        }
+
+        // The start must lie in the domain: the closed-form worlds would fold it onto its mirror
+        // image on the first step, and results would land under the unfolded point's directory.
+        void check_start(const SweepParams& p, SweepGeometry geometry) {
+            const bool inside = geometry == SweepGeometry::Quarter ? p.x0 >= 0.0 && p.y0 >= 0.0
+                                                                   : p.y0 >= 0.0 && p.y0 <= p.x0;
+            if (!inside) {
+                std::string row;
+                for (const std::string& field : p.text) row += (row.empty() ? "" : " ") + field;
+                throw std::runtime_error(std::string("sweep: start (x0, y0) outside the ") + geometry_name(geometry) +
+                                         (geometry == SweepGeometry::Quarter ? " plane (need x0, y0 >= 0)"
+                                                                             : " wedge (need 0 <= y0 <= x0)") +
+                                         " in row: " + row);
+            }
+        }
+
+        SweepResult empty_result(const SweepParams& p) {
+            const double extent = grid_extent(p);
+            return SweepResult{HistogramObserver::grid(0.0, extent, p.nbins, 0.0, extent, p.nbins, p.nsteps),
+                               MomentObserver(p.nsteps), extent};
+        }
+
+        // Parts as consecutive particle ranges of one BasicSimulation with a closed-form world.
+        template <class World>
+        void simulate(const World& world, const std::vector<Part>& parts, const SweepOptions& opt,
+                      std::vector<SweepResult>& out) {
+            std::size_t total = 0;
+            for (const Part& part : parts) total += part.count;
+
+            SimulationConfig cfg;
+            cfg.n_particles = total;
+            cfg.n_steps = parts.front().row->nsteps;
+            cfg.record_history = false;
+            cfg.n_threads = opt.n_threads;
+            cfg.base_seed = opt.base_seed;
+            cfg.rng_engine = opt.rng_engine;
+
+            BasicSimulation<BrownianStep, World, RNG> s(world, cfg);
+            std::vector<Vec2> start;
+            start.reserve(total);
+            for (const Part& part : parts) {
+                const SweepParams& p = *part.row;
+                BrownianParams bp;
+                bp.dt = p.tf / static_cast<double>(p.nsteps);
+                bp.D = p.d;
+                const std::size_t first = start.size();
+                for (std::size_t i = 0; i < part.count; ++i) s.set_brownian_params(first + i, bp);
+                if (first != part.first) s.assign_streams(first, part.count, part.first);
+                start.resize(first + part.count, Vec2{p.x0, p.y0});
+            }
+            s.set_positions(start);
+            s.run_grouped(BrownianStep{}, BrownianStep{});
+
+            // Demultiplex: each part's observers see only its own range (output 0 = start, 1 = tf).
+            const auto& st = s.particles();
+            std::size_t first = 0;
+            for (std::size_t j = 0; j < parts.size(); ++j) {
+                const std::size_t n = parts[j].count;
+                const std::vector<double> x0(n, parts[j].row->x0), y0(n, parts[j].row->y0);
+                for (PositionObserver* o : {static_cast<PositionObserver*>(&out[j].histogram),
+                                            static_cast<PositionObserver*>(&out[j].moments)}) {
+                    o->begin(1, 0, 2);
+                    o->observe(0, 0, x0.data(), y0.data(), n);
+                    o->observe(0, 1, st.x.data() + first, st.y.data() + first, n);
+                    o->end();
+                }
+                first += n;
+            }
+        }
+
+        std::vector<SweepResult> simulate_parts(const std::vector<Part>& parts, const SweepOptions& opt) {
+            std::vector<SweepResult> out;
+            out.reserve(parts.size());
+            for (const Part& part : parts) out.push_back(empty_result(*part.row));
+            if (opt.geometry == SweepGeometry::Quarter) {
+                const double inf = std::numeric_limits<double>::infinity();
+                simulate(BoxWorld{0.0, inf, 0.0, inf}, parts, opt, out);
+            } else {
+                simulate(WedgeWorld{kPi / 4.0}, parts, opt, out);
+            }
+            return out;
+        }
+
+    } // namespace
+
+    SweepParams parse_sweep_row(const std::string& line) {
+        SweepParams p;
+        std::istringstream in(line);
+        for (std::string& field : p.text) {
+            if (!(in >> field)) throw std::runtime_error("sweep: expected 7 fields (tf d x0 y0 nsteps nreals nbins): " + line);
+        }
+        std::string extra;
+        if (in >> extra) throw std::runtime_error("sweep: more than 7 fields: " + line);
+
+        const auto real = [&](std::size_t k) {
+            std::size_t used = 0;
+            double v = 0.0;
+            try { v = std::stod(p.text[k], &used); } catch (const std::exception&) { used = 0; }
+            if (used != p.text[k].size() || !std::isfinite(v)) {
+                throw std::runtime_error("sweep: bad number '" + p.text[k] + "' in: " + line);
+            }
+            return v;
+        };
+        const auto count = [&](std::size_t k) {
+            const double v = real(k);
+            if (v < 1.0 || v != std::floor(v)) {
+                throw std::runtime_error("sweep: expected a positive integer, got '" + p.text[k] + "' in: " + line);
+            }
+            return static_cast<std::size_t>(v);
+        };
+        p.tf = real(0);
+        p.d = real(1);
+        p.x0 = real(2);
+        p.y0 = real(3);
+        p.nsteps = count(4);
+        p.nreals = count(5);
+        p.nbins = count(6);
+        if (p.tf <= 0.0 || p.d < 0.0) throw std::runtime_error("sweep: need tf > 0 and d >= 0: " + line);
+        (void)grid_extent(p);
+        return p;
+    }
+
+    std::vector<SweepParams> read_params_list(std::istream& is) {
+        std::vector<SweepParams> rows;
+        std::string line;
+        while (std::getline(is, line)) {
+            const auto first = line.find_first_not_of(" \t\r");
+            if (first == std::string::npos || line[first] == '#') continue;
+            rows.push_back(parse_sweep_row(line));
+        }
+        return rows;
+    }
+
+    std::vector<SweepParams> read_params_list(const std::string& path) {
+        std::ifstream in(path);
+        if (!in) throw std::runtime_error("sweep: cannot open " + path);
+        return read_params_list(in);
+    }
+
+    std::string sweep_output_dir(const SweepParams& p, SweepGeometry geometry, const std::string& root) {
+        const auto& t = p.text;
+        return root + (geometry == SweepGeometry::Quarter ? "/Quarter_plane/" : "/Eighth_Wedge/") +
+               t[5] + "_realizations/" + t[4] + "_time_steps/Initial_pos_X0_" + t[2] + "_Y0_" + t[3] +
+               "/t_" + t[0] + "/d_" + t[1];
+    }
+
+    std::vector<std::vector<std::size_t>> plan_sweep_packs(const std::vector<SweepParams>& rows,
+                                                           std::size_t max_particles) {
+        std::vector<std::vector<std::size_t>> packs;
+        std::vector<std::size_t> open;     // per pack: realizations so far (open while it has room)
+        for (std::size_t r = 0; r < rows.size(); ++r) {
+            std::size_t k = 0;
+            if (max_particles > 0) {
+                while (k < packs.size() && (rows[packs[k].front()].nsteps != rows[r].nsteps ||
+                                            open[k] + rows[r].nreals > max_particles)) ++k;
+            } else {
+                k = packs.size();
+            }
+            if (k == packs.size()) {
+                packs.emplace_back();
+                open.push_back(0);
+            }
+            packs[k].push_back(r);
+            open[k] += rows[r].nreals;
+        }
+        return packs;
+    }
+
+    std::vector<SweepResult> run_sweep_pack(const std::vector<SweepParams>& rows, const SweepOptions& opt) {
+        if (rows.empty()) return {};
+        std::vector<Part> parts;
+        for (const SweepParams& p : rows) {
+            if (p.nsteps != rows.front().nsteps) throw std::invalid_argument("run_sweep_pack: rows must share nsteps");
+            check_start(p, opt.geometry);
+            parts.push_back(Part{&p, 0, p.nreals});
+        }
+        return simulate_parts(parts, opt);
+    }
+
+    SweepResult run_sweep_row(const SweepParams& p, const SweepOptions& opt) {
+        return std::move(run_sweep_pack({p}, opt).front());
+    }
+
+    std::vector<SweepChunk> plan_sweep_chunks(const std::vector<SweepParams>& rows, std::size_t chunk_particles) {
+        std::vector<SweepChunk> chunks;
+        for (std::size_t r = 0; r < rows.size(); ++r) {
+            const std::size_t n = rows[r].nreals;
+            const std::size_t size = chunk_particles > 0 ? chunk_particles : n;
+            for (std::size_t first = 0; first < n; first += size) {
+                chunks.push_back(SweepChunk{r, first, std::min(size, n - first)});
+            }
+        }
+        return chunks;
+    }
+
+    void run_sweep_local(const std::vector<SweepParams>& rows, const SweepOptions& opt, const SweepRowDone& done) {
+        for (const SweepParams& p : rows) check_start(p, opt.geometry);     // before any row runs
+        const std::vector<SweepChunk> chunks = plan_sweep_chunks(rows, opt.chunk_particles);
+        std::vector<std::size_t> first_chunk(rows.size(), 0);
+        std::vector<std::atomic<std::size_t>> pending(rows.size());
+        for (std::size_t c = chunks.size(); c-- > 0;) first_chunk[chunks[c].row] = c;
+        for (const SweepChunk& ch : chunks) pending[ch.row].fetch_add(1, std::memory_order_relaxed);
+
+        SweepOptions single = opt;
+        single.n_threads = 1;      // parallelism comes from running chunks side by side
+        std::vector<std::unique_ptr<SweepResult>> partial(chunks.size());
+        work_stealing_for(chunks.size(), opt.n_threads, [&](std::size_t c, std::size_t) {
+            const SweepChunk& ch = chunks[c];
+            partial[c] = std::make_unique<SweepResult>(
+                std::move(simulate_parts({Part{&rows[ch.row], ch.first, ch.count}}, single).front()));
+            if (pending[ch.row].fetch_sub(1, std::memory_order_acq_rel) != 1) return;
+
+            // Last chunk of the row: merge all of them in chunk order, whichever thread ran them.
+            const std::size_t first = first_chunk[ch.row];
+            SweepResult merged = std::move(*partial[first]);
+            partial[first].reset();
+            for (std::size_t k = first + 1; k < chunks.size() && chunks[k].row == ch.row; ++k) {
+                merged.histogram.merge(partial[k]->histogram);
+                merged.moments.merge(partial[k]->moments);
+                partial[k].reset();
+            }
+            done(ch.row, merged);
+        });
+    }
+
+    void write_sweep_results(std::ostream& os, const SweepParams& p, SweepGeometry geometry, const SweepResult& r) {
+        const HistogramObserver& h = r.histogram;
+        const std::size_t f = h.n_outputs() - 1;     // positions at tf
+        const double bin_area = (r.extent / static_cast<double>(p.nbins)) * (r.extent / static_cast<double>(p.nbins));
+        const double norm = 1.0 / (static_cast<double>(p.nreals) * bin_area);
+
+        const auto precision = os.precision(std::numeric_limits<double>::max_digits10);
+        os << "# geometry " << geometry_name(geometry) << '\n'
+           << "# tf " << p.text[0] << " d " << p.text[1] << " x0 " << p.text[2] << " y0 " << p.text[3]
+           << " nsteps " << p.text[4] << " nreals " << p.text[5] << " nbins " << p.text[6] << '\n'
+           << "# grid [0, " << r.extent << ")^2 outside " << h.outside(f) << '\n';
+        const std::size_t mf = r.moments.n_outputs() - 1;
+        for (auto q : {MomentObserver::X, MomentObserver::Y, MomentObserver::R}) {
+            static const char* const names[] = {"x", "y", "r"};
+            const Moments& m = r.moments.moments(mf, q);
+            os << "# mean_" << names[q] << ' ' << m.mean << " std_error " << m.std_error() << '\n';
+        }
+        os << "# x y count density\n";
+        for (std::size_t b = 0; b < h.n_bins(); ++b) {
+            os << h.center_u(b % h.nx()) << ' ' << h.center_v(b / h.nx()) << ' ' << h.count(f, b) << ' '
+               << static_cast<double>(h.count(f, b)) * norm << '\n';
+        }
+        os.precision(precision);
+    }
+
+    std::string save_sweep_results(const SweepParams& p, const SweepOptions& opt, const SweepResult& r) {
+        const std::string dir = sweep_output_dir(p, opt.geometry, opt.out_root);
+        std::error_code ec;
+        std::filesystem::create_directories(dir, ec);
+        if (ec) throw std::runtime_error("sweep: cannot create " + dir + ": " + ec.message());
+
+        const std::string path = dir + "/results.txt";
+        std::ofstream out(path, std::ios::trunc);
+        if (!out) throw std::runtime_error("sweep: cannot open " + path);
+        write_sweep_results(out, p, opt.geometry, r);
+        out.flush();
+        if (!out) throw std::runtime_error("sweep: write failed for " + path);
+        return path;
+    }
+
+    std::string run_sweep_task(const SweepParams& p, const SweepOptions& opt) {
+        return save_sweep_results(p, opt, run_sweep_row(p, opt));
+    }
+
+} // namespace sim
@@ -0,0 +1,110 @@
+// cpp/src/walk_on_spheres.cpp
+//
+// Walk-on-spheres estimator (see walk_on_spheres.hpp).
+
+#include "sim/walk_on_spheres.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+#include "sim/basic_simulation.hpp"
+
+namespace sim {
+
+    void WosEstimate::merge(const WosEstimate& other) {
+        value.merge(other.value);
+        steps.merge(other.steps);
+        if (exits.size() < other.exits.size()) exits.resize(other.exits.size(), 0);
+        for (std::size_t w = 0; w < other.exits.size(); ++w) exits[w] += other.exits[w];
+        n_unfinished += other.n_unfinished;
+    }
+
+    WalkOnSpheres::WalkOnSpheres(const ReflectingWorld& world, const WosConfig& cfg)
+        : world_(&world), cfg_(cfg)
+    {
+        assert(cfg_.n_walks >= 1 && "WosConfig::n_walks must be >= 1");
+        assert(cfg_.epsilon > 0.0 && "WosConfig::epsilon must be > 0");
+    }
+
+    WosEstimate WalkOnSpheres::run_chunk(const Vec2& x0, const BoundaryValue& g,
+                                         std::size_t first, std::size_t count) const {
+        // Same streams as particles [first, first + count) of a Simulation (seed_rngs()).
+        SimulationConfig scfg;
+        scfg.base_seed = cfg_.base_seed;
+        scfg.deterministic = cfg_.deterministic;
+        scfg.first_particle = first;
+        scfg.rng_engine = cfg_.rng_engine;
+        std::vector<RNG> rngs;
+        seed_rngs(rngs, count, scfg);
+
+        const ReflectingWorld& world = *world_;
+        constexpr double kTwoPi = 6.283185307179586476925286766559;
+        WosEstimate est;
+        est.exits.assign(world.walls.size(), 0);
+        for (std::size_t j = 0; j < count; ++j) {
+            RNG& rng = rngs[j];
+            Vec2 x = x0;
+            bool finished = false;
+            std::size_t k = 0;
+            for (; k < cfg_.max_steps; ++k) {
+                const NearestWall nw = world.nearest_wall(x);
+                if (nw.wall < 0 || !std::isfinite(nw.distance)) break;     // nothing to exit through
+                if (nw.distance <= cfg_.epsilon) {
+                    const std::size_t w = static_cast<std::size_t>(nw.wall);
+                    est.value.add(g(nw.point, world.walls[w].id));
+                    ++est.exits[w];
+                    finished = true;
+                    break;
+                }
+                // Jump to a uniform point on the largest empty circle (jump k = counter step k).
+                rng.seek_step(k);
+                const double theta = kTwoPi * rng.uniform();
+                x += Vec2{nw.distance * std::cos(theta), nw.distance * std::sin(theta)};
+            }
+            if (finished) {
+                est.steps.add(static_cast<double>(k));
+            } else {
+                ++est.n_unfinished;
+            }
+        }
+        return est;
+    }
+
+    WosEstimate WalkOnSpheres::estimate(const Vec2& x0, const BoundaryValue& g, std::size_t query) {
+        const std::size_t n = cfg_.n_walks;
+        const std::size_t base = cfg_.first_walk + query * n;
+        const std::size_t n_chunks = (n + kWosChunk - 1) / kWosChunk;
+        std::vector<WosEstimate> parts(n_chunks);
+        const auto run = [&](std::size_t a, std::size_t b) {
+            for (std::size_t c = a; c < b; ++c) {
+                const std::size_t lo = c * kWosChunk;
+                parts[c] = run_chunk(x0, g, base + lo, std::min(n - lo, kWosChunk));
+            }
+        };
+
+        // Chunks are independent; the thread count only decides who computes which.
+        const std::size_t n_threads = resolve_thread_count(cfg_.n_threads, n_chunks);
+        if (n_threads <= 1) {
+            run(0, n_chunks);
+        } else {
+            if (!pool_ || pool_->size() != n_threads) {
+                pool_ = std::make_unique<ThreadPool>(n_threads);
+            }
+            pool_->parallel_for(n_chunks, [&](std::size_t a, std::size_t b, std::size_t) { run(a, b); });
+        }
+
+        WosEstimate est;
+        est.exits.assign(world_->walls.size(), 0);
+        for (const WosEstimate& p : parts) est.merge(p);
+        return est;
+    }
+
+    std::vector<WosEstimate> WalkOnSpheres::estimate(const std::vector<Vec2>& points, const BoundaryValue& g) {
+        std::vector<WosEstimate> out;
+        out.reserve(points.size());
+        for (std::size_t q = 0; q < points.size(); ++q) out.push_back(estimate(points[q], g, q));
+        return out;
+    }
+
+} // namespace sim
@@ -0,0 +1,159 @@
+// cpp/src/wall_kernels.cpp
+//
+// Compiled wall columns and batched intersection kernels (see wall_kernels.hpp).
+//
+// Per wall (same operation order as advance_with_reflections):
+//   denom = v.x*s.y - v.y*s.x                 reject |denom| <= EPS_DIR
+//   ap    = p0 - p
+//   t     = (ap.x*s.y - ap.y*s.x) / denom     reject t <= EPS_POS or t > 1 + EPS_POS
+//   u     = (ap.x*v.y - ap.y*v.x) / denom     reject u < -EPS_POS or u > 1 + EPS_POS
+// The SIMD paths compute these for a block of walls, turn the tests into a lane mask and
+// hand surviving lanes to the scalar tie-break in ascending index order. Explicit mul/sub
+// intrinsics (no FMA) keep t bitwise equal to the scalar path.
+
+#include "sim/strict_fp.hpp"     // first: no FMA contraction in this file
+#include "sim/wall_kernels.hpp"
+#include "sim/reflecting_world.hpp"
+
+#include <cmath>
+
+#if defined(__AVX512F__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace sim {
+
+    namespace {
+        /// Keep wall i if it beats the current best (earlier t; ties by id, then index).
+        inline void consider(const CompiledWalls& w, std::size_t i, double t, WallHit& best) noexcept {
+            const int id = w.id[i];
+            if (t < best.t - 1e-15 ||
+                (std::abs(t - best.t) <= 1e-15 &&
+                (id < best.id || (id == best.id && static_cast<int>(i) < best.idx)))) {
+                best.t   = t;
+                best.idx = static_cast<int>(i);
+                best.id  = id;
+                best.n   = Vec2{w.nx[i], w.ny[i]};
+            }
+        }
+    } // namespace
+
+    void CompiledWalls::clear() noexcept {
+        p0x.clear(); p0y.clear();
+        sx.clear();  sy.clear();
+        nx.clear();  ny.clear();
+        id.clear();
+        n = 0;
+    }
+
+    void CompiledWalls::push_back(const Vec2& p0, const Vec2& p1, const Vec2& n_hat, int wall_id) {
+        // Drop padding, append, re-pad to a multiple of kLanes with degenerate walls.
+        const auto set = [&](Column& c, double value) { c.resize(n); c.push_back(value); };
+        set(p0x, p0.x);
+        set(p0y, p0.y);
+        set(sx,  p1.x - p0.x);
+        set(sy,  p1.y - p0.y);
+        set(nx,  n_hat.x);
+        set(ny,  n_hat.y);
+        id.resize(n);
+        id.push_back(wall_id);
+        ++n;
+
+        const std::size_t padded = (n + kLanes - 1) / kLanes * kLanes;
+        for (Column* c : {&p0x, &p0y, &sx, &sy, &nx, &ny}) c->resize(padded, 0.0);
+        id.resize(padded, 0);
+    }
+
+    void scan_walls_scalar(const CompiledWalls& w, const Vec2& p, const Vec2& v, WallHit& best) noexcept {
+        for (std::size_t i = 0; i < w.n; ++i) {
+            const double sx = w.sx[i], sy = w.sy[i];
+            const double denom = v.x * sy - v.y * sx;
+            if (std::abs(denom) <= EPS_DIR) continue;
+
+            const double apx = w.p0x[i] - p.x, apy = w.p0y[i] - p.y;
+            const double t = (apx * sy - apy * sx) / denom;
+            if (t <= EPS_POS || t > 1.0 + EPS_POS) continue;
+
+            const double u = (apx * v.y - apy * v.x) / denom;
+            if (u < -EPS_POS || u > 1.0 + EPS_POS) continue;
+
+            consider(w, i, t, best);
+        }
+    }
+
+    void scan_walls(const CompiledWalls& w, const Vec2& p, const Vec2& v, WallHit& best) noexcept {
+#if defined(__AVX512F__)
+        const __m512d vx = _mm512_set1_pd(v.x), vy = _mm512_set1_pd(v.y);
+        const __m512d px = _mm512_set1_pd(p.x), py = _mm512_set1_pd(p.y);
+        const __m512d eps_dir = _mm512_set1_pd(EPS_DIR);
+        const __m512d lo = _mm512_set1_pd(EPS_POS), hi = _mm512_set1_pd(1.0 + EPS_POS);
+        const __m512d ulo = _mm512_set1_pd(-EPS_POS);
+        const __m512d abs_mask = _mm512_castsi512_pd(_mm512_set1_epi64(0x7fffffffffffffffLL));
+        alignas(64) double ts[8];
+        for (std::size_t j = 0; j < w.n; j += 8) {
+            const __m512d sx = _mm512_load_pd(w.sx.data() + j), sy = _mm512_load_pd(w.sy.data() + j);
+            const __m512d denom = _mm512_sub_pd(_mm512_mul_pd(vx, sy), _mm512_mul_pd(vy, sx));
+            __mmask8 m = _mm512_cmp_pd_mask(_mm512_and_pd(denom, abs_mask), eps_dir, _CMP_GT_OQ);
+            if (!m) continue;
+
+            const __m512d apx = _mm512_sub_pd(_mm512_load_pd(w.p0x.data() + j), px);
+            const __m512d apy = _mm512_sub_pd(_mm512_load_pd(w.p0y.data() + j), py);
+            const __m512d t = _mm512_div_pd(_mm512_sub_pd(_mm512_mul_pd(apx, sy), _mm512_mul_pd(apy, sx)), denom);
+            const __m512d u = _mm512_div_pd(_mm512_sub_pd(_mm512_mul_pd(apx, vy), _mm512_mul_pd(apy, vx)), denom);
+            m = _mm512_mask_cmp_pd_mask(m, t, lo, _CMP_GT_OQ);
+            m = _mm512_mask_cmp_pd_mask(m, t, hi, _CMP_LE_OQ);
+            m = _mm512_mask_cmp_pd_mask(m, u, ulo, _CMP_GE_OQ);
+            m = _mm512_mask_cmp_pd_mask(m, u, hi, _CMP_LE_OQ);
+            if (!m) continue;
+
+            _mm512_store_pd(ts, t);
+            for (unsigned k = 0; k < 8; ++k) {
+                if (m & (1u << k)) consider(w, j + k, ts[k], best);
+            }
+        }
+#elif defined(__AVX2__)
+        const __m256d vx = _mm256_set1_pd(v.x), vy = _mm256_set1_pd(v.y);
+        const __m256d px = _mm256_set1_pd(p.x), py = _mm256_set1_pd(p.y);
+        const __m256d eps_dir = _mm256_set1_pd(EPS_DIR);
+        const __m256d lo = _mm256_set1_pd(EPS_POS), hi = _mm256_set1_pd(1.0 + EPS_POS);
+        const __m256d ulo = _mm256_set1_pd(-EPS_POS);
+        const __m256d abs_mask = _mm256_castsi256_pd(_mm256_set1_epi64x(0x7fffffffffffffffLL));
+        alignas(32) double ts[4];
+        for (std::size_t j = 0; j < w.n; j += 4) {
+            const __m256d sx = _mm256_load_pd(w.sx.data() + j), sy = _mm256_load_pd(w.sy.data() + j);
+            const __m256d denom = _mm256_sub_pd(_mm256_mul_pd(vx, sy), _mm256_mul_pd(vy, sx));
+            __m256d ok = _mm256_cmp_pd(_mm256_and_pd(denom, abs_mask), eps_dir, _CMP_GT_OQ);
+            if (!_mm256_movemask_pd(ok)) continue;
+
+            const __m256d apx = _mm256_sub_pd(_mm256_load_pd(w.p0x.data() + j), px);
+            const __m256d apy = _mm256_sub_pd(_mm256_load_pd(w.p0y.data() + j), py);
+            const __m256d t = _mm256_div_pd(_mm256_sub_pd(_mm256_mul_pd(apx, sy), _mm256_mul_pd(apy, sx)), denom);
+            const __m256d u = _mm256_div_pd(_mm256_sub_pd(_mm256_mul_pd(apx, vy), _mm256_mul_pd(apy, vx)), denom);
+            ok = _mm256_and_pd(ok, _mm256_cmp_pd(t, lo, _CMP_GT_OQ));
+            ok = _mm256_and_pd(ok, _mm256_cmp_pd(t, hi, _CMP_LE_OQ));
+            ok = _mm256_and_pd(ok, _mm256_cmp_pd(u, ulo, _CMP_GE_OQ));
+            ok = _mm256_and_pd(ok, _mm256_cmp_pd(u, hi, _CMP_LE_OQ));
+            const int m = _mm256_movemask_pd(ok);
+            if (!m) continue;
+
+            _mm256_store_pd(ts, t);
+            for (unsigned k = 0; k < 4; ++k) {
+                if (m & (1 << k)) consider(w, j + k, ts[k], best);
+            }
+        }
+#else
+        scan_walls_scalar(w, p, v, best);
+#endif
+    }
+
+    const char* scan_walls_isa() noexcept {
+#if defined(__AVX512F__)
+        return "avx512";
+#elif defined(__AVX2__)
+        return "avx2";
+#else
+        return "scalar";
+#endif
+    }
+
+} // namespace sim
@@ -38,10 +38,7 @@ error() { echo "[ERROR] $*" >&2; exit 1; }
 # Read a space-separated string into a bash array variable
 set_array_from_string() {
   local var="$1"; shift
-  local str="$*"
-  # shellcheck disable=SC2206
-  local arr=($str)
-  eval "$var=(${arr[*]/#/'\"'} )"
+  read -r -a "$var" <<< "$*"
 }
 
 # ----------------------------
@@ -93,7 +90,7 @@ for tf in "${TF_vals[@]}"; do
         for nreals in "${NREALS_vals[@]}"; do
           for nbins in "${NBINS_vals[@]}"; do
             echo "$tf $d $x0 $y0 $nsteps $nreals $nbins" >> "$OUTFILE"
-            ((count++))
+            count=$((count + 1))   # ((count++)) returns 1 for 0 and trips set -e
           done
         done
       done
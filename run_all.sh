@@ -5,9 +5,10 @@
 #   1) Generate parameter list
 #   2) Submit MC array (quarter|eighth)
 #   3) Submit visualization array with afterok dependency
+#   (--local: run steps 2 and 3 on this machine instead, without SLURM)
 #
 # Usage:
-#   ./run_all.sh quarter|eighth [--dry-run] [--preview N]
+#   ./run_all.sh quarter|eighth [--dry-run] [--preview N] [--local]
 # -------------------------------------------------------------
 
 # -------------------------------------------------------------
@@ -26,6 +27,9 @@
 # Flags
 # - --dry-run   : print sbatch commands only (no submissions, no side effects)
 # - --preview N : print the first N lines of params_list.txt for sanity-checking
+# - --local     : run every row with the mc_sweep driver's local work-stealing scheduler
+#                 (all cores; MC_SWEEP overrides the driver path, MC_SWEEP_ARGS adds options
+#                 such as "--chunk 20000"), then the visualization script for each row
 #
 # Exit behavior
 # - Exits non-zero if required files are missing, if params_list.txt is empty,
@@ -38,7 +42,7 @@
 
 set -euo pipefail
 
-usage() { echo "Usage: $0 quarter|eighth [--dry-run] [--preview N]"; exit 1; }
+usage() { echo "Usage: $0 quarter|eighth [--dry-run] [--preview N] [--local]"; exit 1; }
 
 # --- Geometry (required) ---
 [[ $# -ge 1 ]] || usage
@@ -48,10 +52,12 @@ case "$GEOMETRY" in quarter|eighth) ;; -h|--help) usage ;; *) echo "[ERROR] geom
 # --- Optional flags ---
 DRY_RUN=0
 PREVIEW=0
+LOCAL=0
 while [[ $# -gt 0 ]]; do
   case "$1" in
     --dry-run) DRY_RUN=1; shift ;;
     --preview) PREVIEW="${2:-5}"; shift 2 ;;
+    --local) LOCAL=1; shift ;;
     -h|--help) usage ;;
     *) echo "[ERROR] Unknown option: $1"; usage ;;
   esac
@@ -91,6 +97,37 @@ fi
 
 mkdir -p "${ROOT_DIR}/logs"
 
+# --- Local run (no SLURM) ---
+# The driver schedules particle chunks of all rows across the cores itself; visualization then
+# runs row by row with the same entry point as the SLURM visualization script.
+if [[ "$LOCAL" -eq 1 ]]; then
+  MC_SWEEP="${MC_SWEEP:-${ROOT_DIR}/build/cpp/mc_sweep}"
+  VIS_PY="${ROOT_DIR}/src/python/visualize_${GEOMETRY}.py"
+  # shellcheck disable=SC2086  # MC_SWEEP_ARGS is split into options on purpose
+  MC_CMD=("$MC_SWEEP" "$GEOMETRY" --params "$PARAMS_FILE" --out-root "$ROOT_DIR" --local ${MC_SWEEP_ARGS:-})
+  if [[ "$DRY_RUN" -eq 1 ]]; then
+    echo "DRY-RUN: ${MC_CMD[*]}"
+    echo "DRY-RUN: python3 \"$VIS_PY\" --tf ... --nbins ...  (one call per row)"
+    echo "[INFO] Dry-run complete."
+    exit 0
+  fi
+  [[ -x "$MC_SWEEP" ]] || { echo "[ERROR] Missing $MC_SWEEP (build the C++ targets first)"; exit 1; }
+  echo "[INFO] Running MC ${GEOMETRY} sweep locally..."
+  "${MC_CMD[@]}" 2>&1 | tee "${ROOT_DIR}/logs/mc_${GEOMETRY}_local.log"
+  if [[ -f "$VIS_PY" ]]; then
+    echo "[INFO] Running visualization locally..."
+    while read -r tf d x0 y0 nsteps nreals nbins; do
+      [[ -n "${nbins:-}" ]] || continue
+      python3 "$VIS_PY" --tf "$tf" --d "$d" --x0 "$x0" --y0 "$y0" \
+        --nsteps "$nsteps" --nreals "$nreals" --nbins "$nbins"
+    done < "$PARAMS_FILE"
+  else
+    echo "[WARN] $VIS_PY not found; skipping visualization."
+  fi
+  echo "[INFO] Local workflow finished for $GEOMETRY."
+  exit 0
+fi
+
 # --- Check SLURM templates ---
 [[ -f "$MC_SLURM"  ]] || { echo "[ERROR] Not found: $MC_SLURM"; exit 1; }
 [[ -f "$VIS_SLURM" ]] || { echo "[ERROR] Not found: $VIS_SLURM"; exit 1; }
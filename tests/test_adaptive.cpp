@@ -0,0 +1,96 @@
+// tests/test_adaptive.cpp
+#include <gtest/gtest.h>
+#include <cmath>
+#include <vector>
+#include "sim/adaptive.hpp"
+#include "sim/simulation.hpp"
+#include "sim/reflecting_world.hpp"
+#include "test_fixtures.hpp"
+
+using sim::AdaptiveConfig;
+using sim::MomentObserver;
+using sim::ReflectingWorld;
+using sim::Simulation;
+using sim::SimulationConfig;
+using sim::StopTarget;
+using sim::Vec2;
+
+namespace {
+
+SimulationConfig makeConfig() {
+    SimulationConfig cfg;
+    cfg.n_steps = 50;
+    cfg.base_seed = 4242u;
+    cfg.brownian.dt = 1e-3;
+    cfg.brownian.D = 0.5;
+    return cfg;
+}
+
+void CenterStart(Simulation& s, std::size_t /*first_particle*/) {
+    s.set_positions(std::vector<Vec2>(s.config().n_particles, Vec2{0.5, 0.5}));
+}
+
+} // namespace
+
+// 1. A batch with first_particle = b reproduces particles [b, b + n) of one larger run.
+TEST(AdaptiveTest, FirstParticleOffsetsSeeding) {
+    auto w = makeUnitBox();
+    for (auto engine : {sim::RngEngine::MT19937, sim::RngEngine::Philox4x32}) {
+        SimulationConfig cfg = makeConfig();
+        cfg.rng_engine = engine;
+        cfg.n_particles = 30;
+        Simulation whole(w, cfg);
+        CenterStart(whole, 0);
+        whole.run();
+
+        cfg.n_particles = 12;
+        cfg.first_particle = 18;
+        Simulation part(w, cfg);
+        CenterStart(part, 18);
+        part.run();
+        for (std::size_t i = 0; i < 12; ++i) {
+            EXPECT_EQ(part.positions()[i].x, whole.positions()[18 + i].x);
+            EXPECT_EQ(part.positions()[i].y, whole.positions()[18 + i].y);
+        }
+    }
+}
+
+// 2. Stops once the target is met, reproducibly; a cap ends unconverged runs.
+TEST(AdaptiveTest, StopsAtTargetReproducibly) {
+    auto w = makeUnitBox();
+    const SimulationConfig cfg = makeConfig();
+    AdaptiveConfig acfg;
+    acfg.batch_size = 64;
+    acfg.max_batches = 200;
+    StopTarget t;
+    t.quantity = MomentObserver::R;
+    t.abs_error = 2e-3;
+    acfg.targets.push_back(t);
+
+    MomentObserver a(cfg.n_steps, Vec2{0.5, 0.5});
+    const auto ra = sim::run_adaptive(w, cfg, acfg, a, CenterStart);
+    ASSERT_EQ(ra.reason, sim::StopReason::Converged);
+    EXPECT_GE(ra.n_batches, acfg.min_batches);
+    EXPECT_LT(ra.n_batches, acfg.max_batches);
+    EXPECT_EQ(ra.n_particles, ra.n_batches * acfg.batch_size);
+    const auto& m = a.moments(1, MomentObserver::R);
+    EXPECT_EQ(m.n, ra.n_particles);
+    EXPECT_LE(m.std_error(), t.abs_error);
+
+    // The precision estimate (z = 1: a standard error, not a CI) agrees with where the run stopped.
+    EXPECT_LE(m.required_samples(t.abs_error, 1.0), ra.n_particles);
+    EXPECT_GT(m.required_samples(t.abs_error, 1.0), ra.n_particles / 2);
+
+    MomentObserver b(cfg.n_steps, Vec2{0.5, 0.5});
+    const auto rb = sim::run_adaptive(w, cfg, acfg, b, CenterStart);
+    EXPECT_EQ(rb.n_batches, ra.n_batches);
+    EXPECT_EQ(b.moments(1, MomentObserver::R).mean, m.mean);
+    EXPECT_EQ(b.moments(1, MomentObserver::R).m2, m.m2);
+
+    acfg.targets[0].abs_error = 1e-9;
+    acfg.max_batches = 3;
+    MomentObserver c(cfg.n_steps, Vec2{0.5, 0.5});
+    const auto rc = sim::run_adaptive(w, cfg, acfg, c, CenterStart);
+    EXPECT_EQ(rc.reason, sim::StopReason::MaxBatches);
+    EXPECT_EQ(rc.n_batches, 3u);
+}
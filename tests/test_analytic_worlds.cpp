@@ -0,0 +1,120 @@
+// tests/test_analytic_worlds.cpp
+#include "sim/analytic_worlds.hpp"
+#include "sim/reflecting_world.hpp"
+#include <gtest/gtest.h>
+#include <cmath>
+#include <limits>
+#include <random>
+
+using namespace sim;
+
+namespace {
+
+constexpr double kPi = 3.141592653589793;
+constexpr double kInf = std::numeric_limits<double>::infinity();
+
+// Closed form vs generic engine: from the same start, each step agrees to a few EPS_POS
+// (the generic engine nudges EPS_POS off the wall per bounce).
+template <class World, class Sample>
+void ExpectMatchesGeneric(const World& analytic, const ReflectingWorld& generic,
+                          Vec2 start, double step, Sample&& inside, unsigned seed) {
+    std::mt19937 gen(seed);
+    std::normal_distribution<double> N(0.0, step);
+    Vec2 p = start;
+    for (int s = 0; s < 5000; ++s) {
+        const Vec2 d{N(gen), N(gen)};
+        Vec2 a = p, b = p;
+        advance_with_reflections(a, d, analytic);
+        advance_with_reflections(b, d, generic);
+        ASSERT_NEAR(a.x, b.x, 1e-9) << "step " << s;
+        ASSERT_NEAR(a.y, b.y, 1e-9) << "step " << s;
+        ASSERT_TRUE(inside(a)) << "step " << s;
+        p = a;
+    }
+}
+
+} // namespace
+
+// --------------------------------------------------
+// Test suite for BoxWorld / HalfPlaneWorld / WedgeWorld
+// ---------------------------------------------------
+
+// 1. Interior steps are applied exactly (no wall crossed).
+TEST(AnalyticWorldsTest, InteriorStepIsExact) {
+    Vec2 a{0.3, 0.4}, b{0.3, 0.4}, c{0.3, 0.4};
+    const Vec2 d{0.1, -0.05};
+    advance_with_reflections(a, d, BoxWorld{0.0, 1.0, 0.0, 1.0});
+    advance_with_reflections(b, d, HalfPlaneWorld{});
+    advance_with_reflections(c, d, WedgeWorld{kPi / 4.0});
+    for (const Vec2& p : {a, b, c}) {
+        EXPECT_EQ(p.x, 0.3 + 0.1);
+        EXPECT_EQ(p.y, 0.4 - 0.05);
+    }
+}
+
+// 2. Box: single and multiple bounces; infinite bounds behave as one-sided walls.
+TEST(AnalyticWorldsTest, BoxFoldsCoordinates) {
+    Vec2 p{0.5, 0.5};
+    advance_with_reflections(p, {0.7, 0.0}, BoxWorld{0.0, 1.0, 0.0, 1.0});
+    EXPECT_NEAR(p.x, 0.8, 1e-15);
+    p = {0.5, 0.5};
+    advance_with_reflections(p, {-2.7, 0.0}, BoxWorld{0.0, 1.0, 0.0, 1.0});  // 3 bounces
+    EXPECT_NEAR(p.x, 0.2, 1e-15);
+
+    p = {0.5, 0.5};
+    advance_with_reflections(p, {100.0, -1.5}, BoxWorld{0.0, kInf, 0.0, kInf});
+    EXPECT_EQ(p.x, 100.5);
+    EXPECT_EQ(p.y, 1.0);
+
+    ReflectingWorld generic;
+    generic.add_inward_box(0.0, 1.0, 0.0, 2.0, 0);
+    ExpectMatchesGeneric(BoxWorld{0.0, 1.0, 0.0, 2.0}, generic, {0.5, 1.0}, 0.4,
+        [](const Vec2& q) { return q.x >= 0.0 && q.x <= 1.0 && q.y >= 0.0 && q.y <= 2.0; }, 1);
+}
+
+// 3. Half-plane: mirror across an oblique line, agreement with the long-strip approximation.
+TEST(AnalyticWorldsTest, HalfPlaneMirrors) {
+    const HalfPlaneWorld hp = HalfPlaneWorld::from_normal({1.0, 1.0}, 2.0);  // x + y >= 2
+    EXPECT_NEAR(hp.c, std::sqrt(2.0), 1e-15);
+    Vec2 p{2.0, 2.0};
+    advance_with_reflections(p, {-2.0, -1.0}, hp);                   // endpoint (0, 1): 1/sqrt2 below
+    EXPECT_NEAR(p.x, 1.0, 1e-15);
+    EXPECT_NEAR(p.y, 2.0, 1e-15);
+
+    // Strip span kept moderate: with span 1e6 the generic engine's roundoff in t (~1e-11)
+    // exceeds the EPS_POS nudge and it can re-hit the same wall; the closed form cannot.
+    ReflectingWorld generic;
+    generic.add_half_plane_strip(hp.n_hat, hp.c, 1e3, 200);
+    ExpectMatchesGeneric(hp, generic, {3.0, 0.0}, 0.5,
+        [&](const Vec2& q) { return hp.n_hat.dot(q) >= hp.c - 1e-12; }, 2);
+}
+
+// 4. Quarter- and eighth-plane wedges agree with their segment equivalents.
+TEST(AnalyticWorldsTest, WedgeMatchesGenericSegments) {
+    for (const double angle : {kPi / 2.0, kPi / 4.0, 0.3, kPi}) {
+        SCOPED_TRACE(testing::Message() << "angle=" << angle);
+        const double R = 1e3;
+        ReflectingWorld generic;
+        generic.add_segment({0.0, 0.0}, {R, 0.0}, {0.0, 1.0}, 0);
+        generic.add_segment({0.0, 0.0}, {R * std::cos(angle), R * std::sin(angle)},
+                            {std::sin(angle), -std::cos(angle)}, 1);
+        if (angle == kPi) {
+            generic = ReflectingWorld{};
+            generic.add_half_plane_strip({0.0, 1.0}, 0.0, 2.0 * R, 0);
+        }
+
+        const Vec2 start{0.8 * std::cos(0.5 * angle), 0.8 * std::sin(0.5 * angle)};
+        ExpectMatchesGeneric(WedgeWorld{angle}, generic, start, 0.2,
+            [&](const Vec2& q) {
+                const double th = std::atan2(q.y, q.x);
+                return th >= -1e-12 && th <= angle + 1e-12;
+            }, 3);
+    }
+
+    // Quarter plane: the wedge and the one-sided box are the same domain.
+    Vec2 a{0.2, 0.1}, b{0.2, 0.1};
+    advance_with_reflections(a, {-0.5, -0.4}, WedgeWorld{kPi / 2.0});
+    advance_with_reflections(b, {-0.5, -0.4}, BoxWorld{0.0, kInf, 0.0, kInf});
+    EXPECT_NEAR(a.x, b.x, 1e-15);
+    EXPECT_NEAR(a.y, b.y, 1e-15);
+}
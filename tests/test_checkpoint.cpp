@@ -0,0 +1,246 @@
+// tests/test_checkpoint.cpp
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "sim/simulation.hpp"
+#include "sim/philox_rng.hpp"
+#include "sim/history_sink.hpp"
+#include "sim/observers.hpp"
+#include "test_fixtures.hpp"
+
+using sim::RNG;
+using sim::Simulation;
+using sim::SimulationConfig;
+using sim::ReflectingWorld;
+using sim::Vec2;
+using sim::StepType;
+
+namespace {
+
+std::string TempPath(const char* name) { return ::testing::TempDir() + name; }
+
+std::string ReadFile(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+// Unit box whose right wall (id 1) absorbs.
+ReflectingWorld makeAbsorbingBox() {
+    ReflectingWorld w = makeUnitBox();
+    w.set_absorbing(1);
+    return w;
+}
+
+SimulationConfig makeConfig() {
+    SimulationConfig cfg;
+    cfg.n_particles = 53;
+    cfg.n_steps = 40;
+    cfg.store_every = 3;
+    cfg.record_history = true;
+    cfg.n_threads = 2;
+    cfg.base_seed = 77u;
+    cfg.brownian.dt = 0.01;
+    cfg.brownian.D = 0.6;
+    return cfg;
+}
+
+// Brownian particles plus every third one on a noisy drift; throws at step 23 when armed.
+struct Job {
+    bool armed = false;
+    sim::HistogramObserver hist = sim::HistogramObserver::grid(0.0, 1.0, 5, 0.0, 1.0, 5, 4);
+    sim::MomentObserver moments{5, Vec2{0.5, 0.5}};
+    Simulation sim;
+
+    Job(const ReflectingWorld& w, const SimulationConfig& cfg) : sim(w, cfg) {
+        sim.set_positions(std::vector<Vec2>(cfg.n_particles, Vec2{0.6, 0.4}));
+        sim.set_specified_callback([this](std::size_t, std::size_t k, const Vec2&, RNG& rng) {
+            if (armed && k == 23) throw std::runtime_error("killed");
+            return Vec2{0.01 + 0.04 * rng.gauss(), 0.04 * rng.gauss()};
+        });
+        for (std::size_t i = 0; i < cfg.n_particles; i += 3) sim.set_step_type(i, StepType::Specified);
+        sim.add_observer(&hist);
+        sim.add_observer(&moments);
+    }
+};
+
+void ExpectSameJob(const Job& a, const Job& b) {
+    const auto& sa = a.sim.particles();
+    const auto& sb = b.sim.particles();
+    EXPECT_EQ(sa.x, sb.x);
+    EXPECT_EQ(sa.y, sb.y);
+    EXPECT_EQ(sa.alive, sb.alive);
+    EXPECT_EQ(sa.exit_step, sb.exit_step);
+    EXPECT_EQ(sa.exit_wall, sb.exit_wall);
+    ASSERT_EQ(a.sim.history().size(), b.sim.history().size());
+    for (std::size_t i = 0; i < a.sim.history().size(); ++i) {
+        const auto& ha = a.sim.history()[i];
+        const auto& hb = b.sim.history()[i];
+        ASSERT_EQ(ha.size(), hb.size());
+        for (std::size_t f = 0; f < ha.size(); ++f) {
+            EXPECT_EQ(ha[f].x, hb[f].x);
+            EXPECT_EQ(ha[f].y, hb[f].y);
+        }
+    }
+    ASSERT_EQ(a.hist.n_outputs(), b.hist.n_outputs());
+    for (std::size_t f = 0; f < a.hist.n_outputs(); ++f) {
+        for (std::size_t k = 0; k <= a.hist.n_bins(); ++k) EXPECT_EQ(a.hist.count(f, k), b.hist.count(f, k));
+    }
+    ASSERT_EQ(a.moments.n_outputs(), b.moments.n_outputs());
+    for (std::size_t f = 0; f < a.moments.n_outputs(); ++f) {
+        for (auto q : {sim::MomentObserver::X, sim::MomentObserver::R, sim::MomentObserver::Theta}) {
+            EXPECT_EQ(a.moments.moments(f, q).n, b.moments.moments(f, q).n);
+            EXPECT_EQ(a.moments.moments(f, q).mean, b.moments.moments(f, q).mean);
+            EXPECT_EQ(a.moments.moments(f, q).m2, b.moments.moments(f, q).m2);
+        }
+    }
+}
+
+} // namespace
+
+// 1. Saved RNG states continue the same sequence, including a cached normal.
+TEST(CheckpointTest, RngStatesRoundTrip) {
+    for (auto engine : {sim::RngEngine::MT19937, sim::RngEngine::Philox4x32}) {
+        for (auto normal : {sim::NormalMethod::Legacy, sim::NormalMethod::Ziggurat}) {
+            RNG a(engine, 1234, 5, normal);
+            for (int k = 0; k < 7; ++k) (void)a.gauss();     // odd count: a spare may be pending
+            (void)a.uniform();
+            std::stringstream ss;
+            a.save(ss);
+            if (engine == sim::RngEngine::MT19937) {
+                EXPECT_LT(ss.str().size(), 2700u);      // 624 state words, not text
+
+                // Words from another standard library's layout are rejected, not misread.
+                std::string foreign = ss.str();
+                foreign[2 * sizeof(std::uint32_t) + sizeof(std::uint64_t)] = '?';
+                std::stringstream other(foreign);
+                RNG c(sim::RngEngine::MT19937, 1);
+                EXPECT_THROW(c.load(other), std::runtime_error);
+            }
+            RNG b(sim::RngEngine::MT19937, 1);
+            b.load(ss);
+            EXPECT_EQ(b.engine(), engine);
+            EXPECT_EQ(b.normal_method(), normal);
+            for (int k = 0; k < 50; ++k) {
+                ASSERT_EQ(a.gauss(), b.gauss());
+                ASSERT_EQ(a.uniform(), b.uniform());
+            }
+        }
+    }
+
+    sim::PhiloxRng p(99, 3);
+    p.seek_step(4);
+    (void)p.gauss();
+    std::stringstream ss;
+    p.save(ss);
+    sim::PhiloxRng q;
+    q.load(ss);
+    for (int k = 0; k < 20; ++k) ASSERT_EQ(p.gauss(), q.gauss());
+
+    std::stringstream truncated(ss.str().substr(0, 10));
+    EXPECT_THROW(q.load(truncated), std::runtime_error);
+}
+
+// 2. A run killed after its last checkpoint resumes to the uninterrupted result.
+TEST(CheckpointTest, InterruptedRunResumesBitIdentical) {
+    const auto w = makeAbsorbingBox();
+    const std::string path = TempPath("checkpoint_resume.ckp");
+    SimulationConfig cfg = makeConfig();
+
+    Job ref(w, cfg);
+    for (int r = 0; r < 3; ++r) ref.sim.run();
+    ASSERT_GT(ref.sim.n_absorbed(), 0u);
+
+    cfg.checkpoint_every = 7;
+    cfg.checkpoint_path = path;
+    {
+        Job killed(w, cfg);
+        killed.sim.run();
+        killed.armed = true;
+        EXPECT_THROW(killed.sim.run(), std::runtime_error);     // last checkpoint: step 21 of run 2
+    }
+    Job resumed(w, cfg);
+    resumed.sim.load_checkpoint(path);
+    resumed.sim.run();      // finishes run 2
+    resumed.sim.run();
+    ExpectSameJob(ref, resumed);
+
+    // Saving between runs and loading into a fresh job also continues exactly.
+    Job copy(w, cfg);
+    resumed.sim.save_checkpoint(path);
+    copy.sim.load_checkpoint(path);
+    resumed.sim.run();
+    copy.sim.run();
+    ExpectSameJob(resumed, copy);
+    std::filesystem::remove(path);
+}
+
+// 3. A streamed history continues in the same file; the result is byte-identical.
+TEST(CheckpointTest, StreamedHistoryResumes) {
+    const auto w = makeAbsorbingBox();
+    const std::string ckp = TempPath("checkpoint_stream.ckp");
+    const std::string ref_path = TempPath("checkpoint_stream_ref.bin");
+    const std::string path = TempPath("checkpoint_stream.bin");
+    SimulationConfig cfg = makeConfig();
+    cfg.history_buffer_bytes = 4 * 1024;     // several buffers per run
+
+    {
+        sim::BinaryHistoryFileSink sink(ref_path);
+        Job ref(w, cfg);
+        ref.sim.set_history_sink(&sink);
+        ref.sim.run();
+        ref.sim.run();
+    }
+
+    cfg.checkpoint_every = 10;
+    cfg.checkpoint_path = ckp;
+    {
+        sim::BinaryHistoryFileSink sink(path);
+        Job killed(w, cfg);
+        killed.sim.set_history_sink(&sink);
+        killed.sim.run();
+        killed.armed = true;
+        EXPECT_THROW(killed.sim.run(), std::runtime_error);
+    }
+    Job resumed(w, cfg);
+    resumed.sim.load_checkpoint(ckp);
+    EXPECT_EQ(resumed.sim.streamed_frames(), 1 + cfg.n_steps / cfg.store_every + 20 / cfg.store_every);
+    {
+        sim::BinaryHistoryFileSink sink(path, resumed.sim.streamed_frames());
+        resumed.sim.set_history_sink(&sink, resumed.sim.streamed_frames());
+        resumed.sim.run();
+    }
+    EXPECT_EQ(ReadFile(path), ReadFile(ref_path));
+    EXPECT_THROW(sim::BinaryHistoryFileSink(path, 1000), std::runtime_error);
+    for (const auto& p : {ckp, ref_path, path}) std::filesystem::remove(p);
+}
+
+// 4. Checkpoints from another configuration or truncated files are rejected.
+TEST(CheckpointTest, RejectsMismatchedOrTruncatedFiles) {
+    const auto w = makeAbsorbingBox();
+    const std::string path = TempPath("checkpoint_bad.ckp");
+    SimulationConfig cfg = makeConfig();
+    Job job(w, cfg);
+    job.sim.run();
+    job.sim.save_checkpoint(path);
+
+    SimulationConfig other = cfg;
+    other.n_steps = 41;
+    Job different(w, other);
+    EXPECT_THROW(different.sim.load_checkpoint(path), std::runtime_error);
+
+    Simulation no_observers(w, cfg);
+    EXPECT_THROW(no_observers.load_checkpoint(path), std::runtime_error);
+
+    const std::string bytes = ReadFile(path);
+    std::ofstream(path, std::ios::binary | std::ios::trunc).write(bytes.data(), static_cast<std::streamsize>(bytes.size() / 2));
+    Job truncated(w, cfg);
+    EXPECT_THROW(truncated.sim.load_checkpoint(path), std::runtime_error);
+    EXPECT_THROW(truncated.sim.load_checkpoint(TempPath("checkpoint_missing.ckp")), std::runtime_error);
+    std::filesystem::remove(path);
+}
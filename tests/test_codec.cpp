@@ -0,0 +1,125 @@
+// tests/test_codec.cpp
+#include <gtest/gtest.h>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <vector>
+#include "sim/codec.hpp"
+#include "sim/simulation.hpp"
+#include "sim/reflecting_world.hpp"
+
+using sim::SeriesEncoder;
+using sim::Vec2;
+
+namespace {
+
+std::vector<double> RandomWalk(std::size_t n, double step, unsigned seed) {
+    std::mt19937_64 gen(seed);
+    std::normal_distribution<double> N(0.0, step);
+    std::vector<double> v(n);
+    double x = 0.37;
+    for (auto& e : v) e = (x += N(gen));
+    return v;
+}
+
+std::vector<double> RoundTrip(const std::vector<double>& v, double tol, std::size_t* bytes = nullptr) {
+    SeriesEncoder enc(tol);
+    for (double e : v) enc.push(e);
+    if (bytes) *bytes = enc.bytes().size();
+    std::vector<double> out(v.size());
+    sim::decode_series(enc.bytes().data(), enc.bytes().size(), v.size(), tol, out.data());
+    return out;
+}
+
+std::uint64_t Bits(double v) {
+    std::uint64_t b;
+    std::memcpy(&b, &v, sizeof(b));
+    return b;
+}
+
+} // namespace
+
+// 1. Bit streams round-trip arbitrary widths, MSB first.
+TEST(CodecTest, BitStreamRoundTrip) {
+    std::mt19937_64 gen(5);
+    sim::BitWriter w;
+    std::vector<std::pair<std::uint64_t, unsigned>> items;
+    for (int k = 0; k < 2000; ++k) {
+        const unsigned n = static_cast<unsigned>(gen() % 65);
+        const std::uint64_t v = n == 64 ? gen() : (gen() & ((std::uint64_t{1} << n) - 1));
+        items.emplace_back(v, n);
+        w.put(v, n);
+    }
+    sim::BitReader r(w.bytes().data(), w.bytes().size());
+    for (const auto& it : items) ASSERT_EQ(r.get(it.second), it.first);
+
+    sim::BitWriter b;
+    b.put(0b101, 3);
+    ASSERT_EQ(b.bytes().size(), 1u);
+    EXPECT_EQ(b.bytes()[0], 0b10100000);
+}
+
+// 2. Lossless mode is bit-exact, including special values, and smaller on diffusive data.
+TEST(CodecTest, LosslessIsBitExact) {
+    const double inf = std::numeric_limits<double>::infinity();
+    std::vector<double> v = {0.0, -0.0, 1.0, 1.0, inf, -inf, std::numeric_limits<double>::quiet_NaN(),
+                             std::numeric_limits<double>::denorm_min(), 1e308, -1e-308, 0.5, 0.5};
+    const std::vector<double> walk = RandomWalk(5000, 1e-2, 1);
+    v.insert(v.end(), walk.begin(), walk.end());
+
+    std::size_t bytes = 0;
+    const std::vector<double> out = RoundTrip(v, 0.0, &bytes);
+    for (std::size_t k = 0; k < v.size(); ++k) ASSERT_EQ(Bits(out[k]), Bits(v[k])) << "value " << k;
+
+    std::size_t walk_bytes = 0;
+    RoundTrip(walk, 0.0, &walk_bytes);
+    EXPECT_LT(walk_bytes, walk.size() * sizeof(double));
+}
+
+// 3. Lossy mode stays within the tolerance and reaches the 3-8x range.
+TEST(CodecTest, LossyWithinTolerance) {
+    const std::vector<double> walk = RandomWalk(20000, 1e-2, 2);
+    for (const double tol : {1e-6, 1e-4}) {
+        std::size_t bytes = 0;
+        const std::vector<double> out = RoundTrip(walk, tol, &bytes);
+        for (std::size_t k = 0; k < walk.size(); ++k) {
+            ASSERT_LE(std::abs(out[k] - walk[k]), tol * (1.0 + 1e-9)) << "value " << k;
+        }
+        EXPECT_GE(static_cast<double>(walk.size() * sizeof(double)) / static_cast<double>(bytes), 3.0)
+            << "tol " << tol;
+    }
+}
+
+// 4. The compressed history sink reproduces history() exactly (lossless).
+TEST(CodecTest, CompressedHistoryMatchesHistory) {
+    sim::ReflectingWorld w;
+    w.add_inward_box(0.0, 1.0, 0.0, 1.0, 0);
+    sim::SimulationConfig cfg;
+    cfg.n_particles = 17;
+    cfg.n_steps = 300;
+    cfg.store_every = 2;
+    cfg.brownian.dt = 1e-4;
+    cfg.brownian.D = 1.0;
+
+    sim::Simulation ref(w, cfg);
+    ref.set_positions(std::vector<Vec2>(cfg.n_particles, Vec2{0.5, 0.5}));
+    ref.run();
+
+    sim::CompressedHistory compressed;
+    sim::Simulation s(w, cfg);
+    s.set_positions(std::vector<Vec2>(cfg.n_particles, Vec2{0.5, 0.5}));
+    s.set_history_sink(&compressed);
+    s.run();
+
+    ASSERT_EQ(compressed.n_frames(), ref.history()[0].size());
+    const auto hist = compressed.to_vectors();
+    for (std::size_t i = 0; i < cfg.n_particles; ++i) {
+        for (std::size_t f = 0; f < hist[i].size(); ++f) {
+            ASSERT_EQ(hist[i][f].x, ref.history()[i][f].x);
+            ASSERT_EQ(hist[i][f].y, ref.history()[i][f].y);
+        }
+    }
+    EXPECT_LT(compressed.bytes(), cfg.n_particles * compressed.n_frames() * sizeof(Vec2));
+}
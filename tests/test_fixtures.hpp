@@ -0,0 +1,23 @@
+#pragma once
+// Shared fixtures for the simulation test suites.
+#include <cstddef>
+#include <vector>
+#include "sim/reflecting_world.hpp"
+#include "sim/simulation.hpp"
+
+// Unit box (0,0)-(1,1) with inward normals; wall id = 0.
+inline sim::ReflectingWorld makeUnitBox() {
+    sim::ReflectingWorld w;
+    w.add_inward_box(0.0, 1.0, 0.0, 1.0, /*wall_id=*/0);
+    return w;
+}
+
+// Mixed population: Specified particles make run() go through the grouped (reordered) path.
+// The specified step depends on the particle index, so a mix-up in the reordering shows.
+inline void makeMixed(sim::Simulation& s, std::size_t n) {
+    s.set_positions(std::vector<sim::Vec2>(n, sim::Vec2{0.5, 0.5}));
+    for (std::size_t i = 0; i < n; i += 4) s.set_step_type(i, sim::StepType::Specified);
+    s.set_specified_callback([](std::size_t i, std::size_t, const sim::Vec2&, sim::RNG& rng) {
+        return sim::Vec2{0.001 * static_cast<double>(i % 3), 0.02 * rng.gauss()};
+    });
+}
@@ -0,0 +1,164 @@
+// tests/test_history_sink.cpp
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "sim/history_sink.hpp"
+#include "sim/simulation.hpp"
+#include "sim/reflecting_world.hpp"
+#include "test_fixtures.hpp"
+
+using sim::HistoryFrames;
+using sim::ReflectingWorld;
+using sim::Simulation;
+using sim::SimulationConfig;
+using sim::StepType;
+using sim::Vec2;
+
+namespace {
+
+SimulationConfig makeConfig() {
+    SimulationConfig cfg;
+    cfg.n_particles = 37;
+    cfg.n_steps = 200;          // not a multiple of store_every: trailing steps record nothing
+    cfg.store_every = 7;
+    cfg.base_seed = 99u;
+    cfg.brownian.dt = 1e-3;
+    cfg.brownian.D = 0.5;
+    return cfg;
+}
+
+// Collects streamed blocks into per-particle polylines (same shape as history()).
+struct Collector {
+    std::vector<std::vector<Vec2>> hist;
+    std::size_t next_frame{0};
+    std::size_t blocks{0};
+
+    void operator()(const HistoryFrames& b) {
+        ASSERT_EQ(b.first_frame, next_frame);   // frames arrive in order, without gaps
+        if (hist.empty()) hist.resize(b.n_particles);
+        for (std::size_t f = 0; f < b.n_frames; ++f) {
+            for (std::size_t i = 0; i < b.n_particles; ++i) hist[i].push_back(b.at(f, i));
+        }
+        next_frame += b.n_frames;
+        ++blocks;
+    }
+};
+
+void ExpectSameHistory(const std::vector<std::vector<Vec2>>& a, const std::vector<std::vector<Vec2>>& b) {
+    ASSERT_EQ(a.size(), b.size());
+    for (std::size_t i = 0; i < a.size(); ++i) {
+        ASSERT_EQ(a[i].size(), b[i].size()) << "particle " << i;
+        for (std::size_t f = 0; f < a[i].size(); ++f) {
+            EXPECT_EQ(a[i][f].x, b[i][f].x);
+            EXPECT_EQ(a[i][f].y, b[i][f].y);
+        }
+    }
+}
+
+} // namespace
+
+// 1. Streaming with small buffers, threads and particle-major tiles reproduces history().
+TEST(HistorySink, StreamMatchesInMemoryHistory) {
+    auto w = makeUnitBox();
+    SimulationConfig cfg = makeConfig();
+    Simulation ref(w, cfg);
+    makeMixed(ref, cfg.n_particles);
+    ref.run();
+    ref.run();      // second run appends to the same timeline
+
+    cfg.n_threads = 3;
+    cfg.loop_order = sim::LoopOrder::ParticleMajor;
+    cfg.tile_size = 5;
+    cfg.history_buffer_bytes = 4 * 2 * sizeof(double) * cfg.n_particles;   // 2 frames per buffer
+    Collector c;
+    sim::CallbackHistorySink sink([&](const HistoryFrames& b) { c(b); });
+    Simulation streamed(w, cfg);
+    makeMixed(streamed, cfg.n_particles);
+    streamed.set_history_sink(&sink);
+    EXPECT_TRUE(streamed.history().empty());
+    streamed.run();
+    streamed.run();
+
+    EXPECT_TRUE(streamed.history().empty());
+    EXPECT_GT(c.blocks, 10u);
+    ExpectSameHistory(ref.history(), c.hist);
+    for (std::size_t i = 0; i < cfg.n_particles; ++i) {
+        EXPECT_EQ(ref.positions()[i].x, streamed.positions()[i].x);
+        EXPECT_EQ(ref.positions()[i].y, streamed.positions()[i].y);
+    }
+}
+
+// 2. The binary file sink writes the documented header + frame-major layout.
+TEST(HistorySink, BinaryFileLayout) {
+    auto w = makeUnitBox();
+    SimulationConfig cfg = makeConfig();
+    Simulation ref(w, cfg);
+    makeMixed(ref, cfg.n_particles);
+    ref.run();
+
+    const std::string path = ::testing::TempDir() + "history_sink_test.bin";
+    {
+        sim::BinaryHistoryFileSink sink(path);
+        Simulation s(w, cfg);
+        makeMixed(s, cfg.n_particles);
+        s.set_history_sink(&sink);
+        s.run();
+    }
+
+    std::ifstream in(path, std::ios::binary);
+    ASSERT_TRUE(in.good());
+    char magic[8];
+    std::uint64_t shape[2];
+    in.read(magic, sizeof(magic));
+    in.read(reinterpret_cast<char*>(shape), sizeof(shape));
+    EXPECT_EQ(std::memcmp(magic, "DMMCHST1", 8), 0);
+    EXPECT_EQ(shape[0], cfg.n_particles);
+    EXPECT_EQ(shape[1], cfg.store_every);
+
+    const std::size_t n = cfg.n_particles;
+    std::vector<std::vector<Vec2>> hist(n);
+    std::vector<double> xs(n), ys(n);
+    while (in.read(reinterpret_cast<char*>(xs.data()), static_cast<std::streamsize>(n * sizeof(double))) &&
+           in.read(reinterpret_cast<char*>(ys.data()), static_cast<std::streamsize>(n * sizeof(double)))) {
+        for (std::size_t i = 0; i < n; ++i) hist[i].push_back(Vec2{xs[i], ys[i]});
+    }
+    ExpectSameHistory(ref.history(), hist);
+    std::remove(path.c_str());
+}
+
+// 3. A failing sink surfaces on the calling thread.
+TEST(HistorySink, SinkErrorIsRethrownFromRun) {
+    auto w = makeUnitBox();
+    SimulationConfig cfg = makeConfig();
+    cfg.history_buffer_bytes = 0;   // one frame per buffer
+    sim::CallbackHistorySink sink([](const HistoryFrames& b) {
+        if (b.first_frame == 3) throw std::runtime_error("disk full");
+    });
+    Simulation s(w, cfg);
+    s.set_history_sink(&sink);
+    EXPECT_THROW(s.run(), std::runtime_error);
+}
+
+// 4. Buffers are sized to what the run records, not to the full history_buffer_bytes.
+TEST(HistorySink, BuffersAreSizedToTheRun) {
+    const std::size_t big = 64u << 20;
+    EXPECT_EQ(sim::history_frames_per_buffer(big, 37), big / (2 * 2 * sizeof(double) * 37));
+    EXPECT_EQ(sim::history_frames_per_buffer(big, 37, 30), 30u);
+    EXPECT_EQ(sim::history_frames_per_buffer(0, 37, 30), 1u);
+    EXPECT_EQ(sim::history_frames_per_buffer(big, 37, 0), 1u);
+
+    auto w = makeUnitBox();
+    SimulationConfig cfg = makeConfig();
+    cfg.history_buffer_bytes = big;
+    std::vector<std::size_t> blocks;
+    sim::CallbackHistorySink sink([&](const HistoryFrames& b) { blocks.push_back(b.n_frames); });
+    Simulation s(w, cfg);
+    s.set_history_sink(&sink);
+    s.run();
+    EXPECT_EQ(blocks, std::vector<std::size_t>{1 + cfg.n_steps / cfg.store_every});   // one exact block
+}
@@ -0,0 +1,190 @@
+// tests/test_io.cpp
+#include <gtest/gtest.h>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "sim/io.hpp"
+#include "sim/simulation.hpp"
+#include "sim/reflecting_world.hpp"
+#include "test_fixtures.hpp"
+
+using sim::ReflectingWorld;
+using sim::Simulation;
+using sim::SimulationConfig;
+using sim::TrajectoryLayout;
+using sim::TrajectoryReader;
+using sim::TrajectoryWriter;
+using sim::Vec2;
+
+namespace {
+
+SimulationConfig makeConfig() {
+    SimulationConfig cfg;
+    cfg.n_particles = 23;
+    cfg.n_steps = 60;
+    cfg.store_every = 4;        // 15 frames per run
+    cfg.base_seed = 7u;
+    cfg.brownian.dt = 1e-3;
+    cfg.brownian.D = 0.25;
+    cfg.brownian.mu_x = 0.5;
+    return cfg;
+}
+
+std::string TempPath(const char* name) { return ::testing::TempDir() + name; }
+
+// Two runs in memory (reference) and two runs streamed to a trajectory file.
+std::vector<std::vector<Vec2>> RunBoth(const SimulationConfig& cfg, const std::string& path,
+                                       TrajectoryLayout layout, std::size_t frames_per_chunk) {
+    auto w = makeUnitBox();
+    Simulation ref(w, cfg);
+    ref.set_positions(std::vector<Vec2>(cfg.n_particles, Vec2{0.5, 0.5}));
+    ref.run();
+    ref.run();
+
+    TrajectoryWriter out(path, sim::make_trajectory_header(cfg, sim::geometry_hash(w), layout, frames_per_chunk));
+    Simulation s(w, cfg);
+    s.set_positions(std::vector<Vec2>(cfg.n_particles, Vec2{0.5, 0.5}));
+    s.set_history_sink(&out);
+    s.run();
+    s.run();
+    return ref.history();
+}
+
+} // namespace
+
+// 1. Frame-major: header, zero-copy frames and per-particle access match history().
+TEST(TrajectoryIo, FrameMajorRoundTrip) {
+    const SimulationConfig cfg = makeConfig();
+    const std::string path = TempPath("traj_frame_major.bin");
+    const auto hist = RunBoth(cfg, path, TrajectoryLayout::FrameMajor, 0);
+
+    TrajectoryReader r(path);
+    EXPECT_EQ(r.layout(), TrajectoryLayout::FrameMajor);
+    EXPECT_EQ(r.n_particles(), cfg.n_particles);
+    ASSERT_EQ(r.n_frames(), hist[0].size());
+    EXPECT_EQ(r.header().store_every, cfg.store_every);
+    EXPECT_EQ(r.header().base_seed, cfg.base_seed);
+    EXPECT_EQ(r.header().mu_x, cfg.brownian.mu_x);
+    EXPECT_EQ(r.header().world_hash, sim::geometry_hash(makeUnitBox()));
+
+    for (std::size_t f = 0; f < r.n_frames(); ++f) {
+        const sim::PositionsView frame = r.frame(f);
+        ASSERT_EQ(frame.size(), cfg.n_particles);
+        for (std::size_t i = 0; i < cfg.n_particles; ++i) {
+            EXPECT_EQ(frame[i].x, hist[i][f].x);
+            EXPECT_EQ(frame[i].y, hist[i][f].y);
+        }
+    }
+    const std::vector<Vec2> p = r.particle(5);
+    ASSERT_EQ(p.size(), hist[5].size());
+    for (std::size_t f = 0; f < p.size(); ++f) EXPECT_EQ(p[f].y, hist[5][f].y);
+    EXPECT_THROW(r.particle_chunk(0, 0), std::logic_error);
+    std::remove(path.c_str());
+}
+
+// 2. Particle-major: chunks (last one partial, rewritten across runs) match history().
+TEST(TrajectoryIo, ParticleMajorChunks) {
+    const SimulationConfig cfg = makeConfig();
+    const std::string path = TempPath("traj_particle_major.bin");
+    const auto hist = RunBoth(cfg, path, TrajectoryLayout::ParticleMajor, 7);
+
+    TrajectoryReader r(path);
+    ASSERT_EQ(r.n_frames(), hist[0].size());     // 31 frames = 4 chunks of 7 + 3
+    EXPECT_EQ(r.n_chunks(), 5u);
+    EXPECT_EQ(r.particle_chunk(3, 4).size(), 3u);
+    for (std::size_t i = 0; i < cfg.n_particles; ++i) {
+        const std::vector<Vec2> p = r.particle(i);
+        ASSERT_EQ(p.size(), hist[i].size());
+        for (std::size_t f = 0; f < p.size(); ++f) {
+            EXPECT_EQ(p[f].x, hist[i][f].x);
+            EXPECT_EQ(p[f].y, hist[i][f].y);
+            EXPECT_EQ(r.at(f, i).x, hist[i][f].x);
+        }
+    }
+    EXPECT_THROW(r.frame(0), std::logic_error);
+
+    // Readers are movable; views of the moved-to reader stay valid.
+    TrajectoryReader moved(std::move(r));
+    EXPECT_EQ(moved.at(30, 22).y, hist[22][30].y);
+    std::remove(path.c_str());
+}
+
+// 3. Missing, foreign and truncated files are rejected at open.
+TEST(TrajectoryIo, RejectsMalformedFiles) {
+    EXPECT_THROW(TrajectoryReader(TempPath("traj_does_not_exist.bin")), std::runtime_error);
+
+    const std::string path = TempPath("traj_bad.bin");
+    {
+        std::ofstream f(path, std::ios::binary);
+        f << "not a trajectory";
+    }
+    EXPECT_THROW(TrajectoryReader{path}, std::runtime_error);
+
+    {
+        sim::TrajectoryHeader h;
+        h.n_particles = 10;
+        h.n_frames = 3;     // claims 480 bytes of frames that are not there
+        std::ofstream f(path, std::ios::binary | std::ios::trunc);
+        f.write(reinterpret_cast<const char*>(&h), sizeof(h));
+    }
+    EXPECT_THROW(TrajectoryReader{path}, std::runtime_error);
+    std::remove(path.c_str());
+}
+
+// 4. The geometry hash tells worlds apart and is stable for equal geometry.
+TEST(TrajectoryIo, GeometryHash) {
+    ReflectingWorld a = makeUnitBox(), b = makeUnitBox(), c;
+    c.add_inward_box(0.0, 2.0, 0.0, 1.0, 0);
+    EXPECT_EQ(sim::geometry_hash(a), sim::geometry_hash(b));
+    EXPECT_NE(sim::geometry_hash(a), sim::geometry_hash(c));
+    EXPECT_NE(sim::geometry_hash(sim::WedgeWorld{0.5}), sim::geometry_hash(sim::WedgeWorld{0.6}));
+    EXPECT_NE(sim::geometry_hash(sim::BoxWorld{}), sim::geometry_hash(sim::WedgeWorld{}));
+}
+
+// 5. Compressed layout: lossless is bit-exact, lossy within tolerance; both across two runs.
+TEST(TrajectoryIo, CompressedLayout) {
+    const SimulationConfig cfg = makeConfig();
+    for (const double tol : {0.0, 1e-7}) {
+        SCOPED_TRACE(testing::Message() << "tol=" << tol);
+        const std::string path = TempPath("traj_compressed.bin");
+        auto w = makeUnitBox();
+        Simulation ref(w, cfg);
+        ref.set_positions(std::vector<Vec2>(cfg.n_particles, Vec2{0.5, 0.5}));
+        ref.run();
+        ref.run();
+        {
+            TrajectoryWriter out(path, sim::make_trajectory_header(cfg, 0, TrajectoryLayout::Compressed, 7, tol));
+            Simulation s(w, cfg);
+            s.set_positions(std::vector<Vec2>(cfg.n_particles, Vec2{0.5, 0.5}));
+            s.set_history_sink(&out);
+            s.run();
+            s.run();
+        }
+
+        TrajectoryReader r(path);
+        EXPECT_EQ(r.layout(), TrajectoryLayout::Compressed);
+        EXPECT_EQ(r.header().tolerance, tol);
+        ASSERT_EQ(r.n_frames(), ref.history()[0].size());
+        EXPECT_THROW(r.frame(0), std::logic_error);
+        EXPECT_THROW(r.particle_chunk(0, 0), std::logic_error);
+        for (std::size_t i = 0; i < cfg.n_particles; ++i) {
+            const std::vector<Vec2> p = r.particle(i);
+            ASSERT_EQ(p.size(), ref.history()[i].size());
+            for (std::size_t f = 0; f < p.size(); ++f) {
+                const Vec2 e = ref.history()[i][f];
+                if (tol == 0.0) {
+                    ASSERT_EQ(p[f].x, e.x);
+                    ASSERT_EQ(p[f].y, e.y);
+                } else {
+                    ASSERT_LE(std::abs(p[f].x - e.x), tol * (1.0 + 1e-9));
+                    ASSERT_LE(std::abs(p[f].y - e.y), tol * (1.0 + 1e-9));
+                }
+            }
+        }
+        EXPECT_EQ(r.at(30, 4).x, r.particle(4)[30].x);
+        std::remove(path.c_str());
+    }
+}
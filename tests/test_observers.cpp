@@ -0,0 +1,239 @@
+// tests/test_observers.cpp
+#include <gtest/gtest.h>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "sim/observers.hpp"
+#include "sim/simulation.hpp"
+#include "sim/reflecting_world.hpp"
+#include "test_fixtures.hpp"
+
+using sim::HistogramObserver;
+using sim::MomentObserver;
+using sim::Moments;
+using sim::ReflectingWorld;
+using sim::Simulation;
+using sim::SimulationConfig;
+using sim::StepType;
+using sim::Vec2;
+
+namespace {
+
+SimulationConfig makeConfig() {
+    SimulationConfig cfg;
+    cfg.n_particles = 301;
+    cfg.n_steps = 200;
+    cfg.store_every = 5;
+    cfg.base_seed = 17u;
+    cfg.brownian.dt = 1e-3;
+    cfg.brownian.D = 1.0;
+    return cfg;
+}
+
+// Post-hoc binning of a recorded history with the observer's own bin rule.
+std::vector<std::uint64_t> BinHistory(const std::vector<std::vector<Vec2>>& hist, std::size_t frame,
+                                      const HistogramObserver& ref) {
+    HistogramObserver h = ref;
+    h.clear();
+    h.begin(1, 0, 1);
+    std::vector<double> x, y;
+    for (const auto& p : hist) {
+        x.push_back(p[frame].x);
+        y.push_back(p[frame].y);
+    }
+    h.observe(0, 0, x.data(), y.data(), x.size());
+    h.end();
+    std::vector<std::uint64_t> c;
+    for (std::size_t b = 0; b <= h.n_bins(); ++b) c.push_back(h.count(0, b));
+    return c;
+}
+
+} // namespace
+
+// 1. Threaded, tiled, grouped on-the-fly histograms equal binning the serial recorded history,
+//    across two runs, without recording history.
+TEST(ObserverTest, HistogramsMatchPostHocBinning) {
+    auto w = makeUnitBox();
+    SimulationConfig cfg = makeConfig();
+    Simulation ref(w, cfg);
+    makeMixed(ref, cfg.n_particles);
+    ref.run();
+    ref.run();
+
+    cfg.record_history = false;
+    cfg.n_threads = 4;
+    cfg.loop_order = sim::LoopOrder::ParticleMajor;
+    cfg.tile_size = 8;
+    auto radial  = HistogramObserver::radial(Vec2{0.5, 0.5}, 0.6, 12, cfg.store_every);
+    auto angular = HistogramObserver::angular(Vec2{0.5, 0.5}, -M_PI, M_PI, 16, 2 * cfg.store_every);
+    auto grid    = HistogramObserver::grid(0.0, 1.0, 5, 0.0, 1.0, 4, cfg.store_every);
+    Simulation s(w, cfg);
+    makeMixed(s, cfg.n_particles);
+    s.add_observer(&radial);
+    s.add_observer(&angular);
+    s.add_observer(&grid);
+    s.run();
+    s.run();
+    EXPECT_TRUE(s.history().empty());
+
+    const std::size_t frames = ref.history()[0].size();
+    ASSERT_EQ(radial.n_outputs(), frames);
+    ASSERT_EQ(grid.n_outputs(), frames);
+    ASSERT_EQ(angular.n_outputs(), 1 + 2 * (cfg.n_steps / (2 * cfg.store_every)));
+    for (std::size_t f = 0; f < frames; ++f) {
+        EXPECT_EQ(radial.total(f), cfg.n_particles);
+        const auto r = BinHistory(ref.history(), f, radial);
+        const auto g = BinHistory(ref.history(), f, grid);
+        for (std::size_t b = 0; b <= radial.n_bins(); ++b) EXPECT_EQ(radial.count(f, b), r[b]) << f;
+        for (std::size_t b = 0; b <= grid.n_bins(); ++b) EXPECT_EQ(grid.count(f, b), g[b]) << f;
+    }
+    // Angular output f (every 10 steps) is history frame 2f (store_every = 5), in both runs.
+    for (std::size_t f = 0; f < angular.n_outputs(); ++f) {
+        const auto a = BinHistory(ref.history(), 2 * f, angular);
+        for (std::size_t b = 0; b <= angular.n_bins(); ++b) EXPECT_EQ(angular.count(f, b), a[b]) << f;
+    }
+    EXPECT_EQ(radial.count(0, 0), cfg.n_particles);     // everyone starts at the centre
+}
+
+// 2. Bin edges are half-open, out-of-range and NaN positions land in outside().
+TEST(ObserverTest, BinEdgesAndOutside) {
+    auto g = HistogramObserver::grid(0.0, 1.0, 2, 0.0, 2.0, 2, 1);
+    const double x[] = {0.0, 0.5, 0.999, 1.0, -1e-12, 0.2, NAN};
+    const double y[] = {0.0, 1.0, 1.999, 0.5,  0.5,   2.0, 0.5};
+    g.begin(2, 0, 1);
+    g.observe(1, 0, x, y, 7);
+    g.end();
+    EXPECT_EQ(g.count(0, 0), 1u);   // (0, 0)
+    EXPECT_EQ(g.count(0, 1), 0u);
+    EXPECT_EQ(g.count(0, 2), 0u);
+    EXPECT_EQ(g.count(0, 3), 2u);   // (0.5, 1) and (0.999, 1.999)
+    EXPECT_EQ(g.outside(0), 4u);    // x = 1, x < 0, y = 2, NaN
+    EXPECT_EQ(g.total(0), 7u);
+
+    auto a = HistogramObserver::angular(Vec2{0.0, 0.0}, 0.0, M_PI / 2, 2, 1);
+    const double ax[] = {1.0, 1.0, 0.0, -1.0};
+    const double ay[] = {0.0, 2.0, 1.0,  0.0};
+    a.begin(1, 0, 1);
+    a.observe(0, 0, ax, ay, 4);
+    a.end();
+    EXPECT_EQ(a.count(0, 0), 1u);   // theta = 0
+    EXPECT_EQ(a.count(0, 1), 1u);   // theta = atan(2)
+    EXPECT_EQ(a.outside(0), 2u);    // theta = pi/2 (upper edge) and pi
+}
+
+// 3. Text output: one line per (output, bin) with step, bin centre, count and fraction.
+TEST(ObserverTest, WriteText) {
+    auto r = HistogramObserver::radial(Vec2{0.0, 0.0}, 2.0, 2, 10);
+    const double x[] = {0.5, 1.5, 1.2, 3.0};
+    const double y[] = {0.0, 0.0, 0.0, 0.0};
+    r.begin(1, 0, 2);
+    r.observe(0, 1, x, y, 4);
+    r.end();
+    std::ostringstream os;
+    r.write_text(os);
+    EXPECT_EQ(os.str(), "0 0.5 0 0\n0 1.5 0 0\n10 0.5 1 0.25\n10 1.5 2 0.5\n");
+}
+
+// 4. Streaming moments match two-pass formulas; merging any split equals adding sequentially.
+TEST(ObserverTest, MomentsMatchTwoPassAndMerge) {
+    std::mt19937_64 gen(3);
+    std::gamma_distribution<double> G(2.0, 1.5);    // skewed, so m3 / m4 are non-trivial
+    std::vector<double> v(10001);
+    for (auto& e : v) e = 1e3 + G(gen);             // offset: sum-of-powers formulas would cancel
+
+    double mean = 0.0;
+    for (double e : v) mean += e;
+    mean /= static_cast<double>(v.size());
+    double c2 = 0.0, c3 = 0.0, c4 = 0.0;
+    for (double e : v) {
+        const double d = e - mean;
+        c2 += d * d;
+        c3 += d * d * d;
+        c4 += d * d * d * d;
+    }
+
+    Moments all;
+    for (double e : v) all.add(e);
+    EXPECT_EQ(all.n, v.size());
+    EXPECT_NEAR(all.mean, mean, 1e-12 * mean);
+    EXPECT_NEAR(all.m2, c2, 1e-9 * c2);
+    EXPECT_NEAR(all.m3, c3, 1e-8 * std::abs(c3));
+    EXPECT_NEAR(all.m4, c4, 1e-9 * c4);
+    EXPECT_NEAR(all.std_error(), std::sqrt(c2 / 10000.0 / 10001.0), 1e-9);
+
+    for (std::size_t cut : {std::size_t{1}, std::size_t{37}, std::size_t{5000}, std::size_t{10000}}) {
+        Moments a, b;
+        for (std::size_t k = 0; k < cut; ++k) a.add(v[k]);
+        for (std::size_t k = cut; k < v.size(); ++k) b.add(v[k]);
+        a.merge(b);
+        EXPECT_EQ(a.n, all.n);
+        EXPECT_NEAR(a.mean, all.mean, 1e-12 * all.mean) << cut;
+        EXPECT_NEAR(a.m2, all.m2, 1e-10 * all.m2) << cut;
+        EXPECT_NEAR(a.m3, all.m3, 1e-8 * std::abs(all.m3)) << cut;
+        EXPECT_NEAR(a.m4, all.m4, 1e-10 * all.m4) << cut;
+    }
+
+    // Precision-driven sample size: reaching the current half-width needs about n samples.
+    const std::uint64_t need = all.required_samples(all.ci_half_width());
+    EXPECT_NEAR(static_cast<double>(need), static_cast<double>(all.n), 2.0);
+}
+
+// 5. Threaded moment observer agrees with the recorded history; save/load/merge combines
+//    independent runs like one larger run.
+TEST(ObserverTest, MomentObserverMatchesHistoryAndMergesAcrossRuns) {
+    auto w = makeUnitBox();
+    SimulationConfig cfg = makeConfig();
+    Simulation ref(w, cfg);
+    makeMixed(ref, cfg.n_particles);
+    ref.run();
+
+    cfg.record_history = false;
+    cfg.n_threads = 3;
+    MomentObserver mom(cfg.store_every, Vec2{0.5, 0.5});
+    Simulation s(w, cfg);
+    makeMixed(s, cfg.n_particles);
+    s.add_observer(&mom);
+    s.run();
+
+    ASSERT_EQ(mom.n_outputs(), ref.history()[0].size());
+    for (std::size_t f = 0; f < mom.n_outputs(); ++f) {
+        Moments x, r;
+        for (const auto& p : ref.history()) {
+            x.add(p[f].x);
+            r.add(std::hypot(p[f].x - 0.5, p[f].y - 0.5));
+        }
+        EXPECT_EQ(mom.moments(f, MomentObserver::X).n, cfg.n_particles);
+        EXPECT_NEAR(mom.moments(f, MomentObserver::X).mean, x.mean, 1e-13);
+        EXPECT_NEAR(mom.moments(f, MomentObserver::X).m2, x.m2, 1e-12);
+        EXPECT_NEAR(mom.moments(f, MomentObserver::R).mean, r.mean, 1e-13);
+        EXPECT_NEAR(mom.moments(f, MomentObserver::R).std_error(), r.std_error(), 1e-13);
+    }
+
+    // A second "process" with other seeds; its saved state merges into the first.
+    cfg.base_seed = 1000u;
+    MomentObserver other(cfg.store_every, Vec2{0.5, 0.5});
+    Simulation s2(w, cfg);
+    makeMixed(s2, cfg.n_particles);
+    s2.add_observer(&other);
+    s2.run();
+
+    std::stringstream file;
+    other.save(file);
+    MomentObserver loaded = MomentObserver::load(file);
+    const std::size_t f = mom.n_outputs() - 1;
+    Moments expect = mom.moments(f, MomentObserver::Y);
+    expect.merge(other.moments(f, MomentObserver::Y));
+    EXPECT_EQ(loaded.moments(f, MomentObserver::Y).m4, other.moments(f, MomentObserver::Y).m4);   // exact round trip
+    mom.merge(loaded);
+    EXPECT_EQ(mom.moments(f, MomentObserver::Y).n, 2 * cfg.n_particles);
+    EXPECT_EQ(mom.moments(f, MomentObserver::Y).mean, expect.mean);
+    EXPECT_EQ(mom.moments(f, MomentObserver::Y).m2, expect.m2);
+
+    std::stringstream bad("DMMCMOM1 5 0.5 0.5 3\n1 2 3\n");
+    EXPECT_THROW(MomentObserver::load(bad), std::runtime_error);
+    EXPECT_THROW(mom.merge(MomentObserver(7, Vec2{0.5, 0.5})), std::invalid_argument);
+}
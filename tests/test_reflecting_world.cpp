@@ -1,6 +1,8 @@
 // tests/test_reflecting_world.cpp
 #include "sim/reflecting_world.hpp"
 #include <gtest/gtest.h>
+#include <cmath>
+#include <random>
 
 using namespace sim;
 
@@ -95,4 +97,146 @@ TEST(ReflectingWorldTest, GrazingTrajectoryIsStable) {
     EXPECT_NEAR(pos.x, 10.0, 1e-9);
     // Still above the floor
     EXPECT_GT(pos.y, 0.0);
-}
\ No newline at end of file
+}
+// 8. Broad phase: indexed and brute-force scans give bit-identical paths and clearances.
+TEST(ReflectingWorldTest, GridIndexMatchesBruteForce) {
+    // Inward-facing 400-gon approximating the unit circle, plus an interior strut.
+    ReflectingWorld brute;
+    const int n = 400;
+    const double two_pi = 6.283185307179586;
+    for (int k = 0; k < n; ++k) {
+        const double a0 = two_pi * k / n, a1 = two_pi * (k + 1) / n;
+        brute.add_segment_auto({std::cos(a0), std::sin(a0)}, {std::cos(a1), std::sin(a1)}, false, k);
+    }
+    brute.add_segment({-0.3, 0.0}, {0.3, 0.0}, {0, 1}, 1000);
+
+    ReflectingWorld indexed = brute;
+    indexed.build_index();
+    ASSERT_TRUE(indexed.has_index());
+    ReflectingWorld fine = brute;       // much finer than the walls: many cells per wall
+    fine.build_index(0.002);
+    EXPECT_FALSE(brute.has_index());
+
+    std::mt19937 gen(7);
+    std::uniform_real_distribution<double> ang(0.0, two_pi);
+    std::uniform_real_distribution<double> len(0.0, 1.0);
+    Vec2 a{0.1, 0.2}, b{0.1, 0.2}, c{0.1, 0.2};
+    for (int s = 0; s < 5000; ++s) {
+        // Mostly short steps, with occasional multi-bounce long ones.
+        const double L = (s % 50 == 0) ? 3.0 * len(gen) : 0.05 * len(gen);
+        const double th = ang(gen);
+        const Vec2 d{L * std::cos(th), L * std::sin(th)};
+        advance_with_reflections(a, d, brute);
+        advance_with_reflections(b, d, indexed);
+        advance_with_reflections(c, d, fine);
+        ASSERT_EQ(a.x, b.x) << "step " << s;
+        ASSERT_EQ(a.y, b.y) << "step " << s;
+        ASSERT_EQ(a.x, c.x) << "step " << s;
+        ASSERT_EQ(a.y, c.y) << "step " << s;
+        if (s % 10 == 0) {
+            // The ring search returns the full-scan clearance.
+            ASSERT_EQ(indexed.clearance(a), brute.clearance(a)) << "step " << s;
+            ASSERT_EQ(fine.clearance(a), brute.clearance(a)) << "step " << s;
+        }
+    }
+}
+
+// 9. Builders invalidate a previously built index.
+TEST(ReflectingWorldTest, AddingWallsDropsIndex) {
+    ReflectingWorld world;
+    world.add_inward_box(0.0, 1.0, 0.0, 1.0, 0);
+    world.build_index();
+    EXPECT_TRUE(world.has_index());
+    world.add_segment({0.5, 0.0}, {0.5, 1.0}, {1, 0}, 10);
+    EXPECT_FALSE(world.has_index());
+
+    // The new wall must be seen by the (unindexed) advancer.
+    Vec2 pos{0.75, 0.5};
+    advance_with_reflections(pos, {-0.5, 0.0}, world);
+    EXPECT_GT(pos.x, 0.5);
+}
+
+// 10. Clearance is a conservative distance and the cached early-out matches the full advancer.
+TEST(ReflectingWorldTest, ClearanceEarlyOutMatchesAdvancer) {
+    ReflectingWorld empty;
+    EXPECT_TRUE(std::isinf(empty.clearance({0.0, 0.0})));
+
+    ReflectingWorld box;
+    box.add_inward_box(0.0, 1.0, 0.0, 2.0, 0);
+    EXPECT_NEAR(box.clearance({0.25, 1.0}), 0.25, 1e-9);
+    EXPECT_LE(box.clearance({0.25, 1.0}), 0.25);
+    EXPECT_NEAR(box.clearance({0.5, 1.9}), 0.1, 1e-9);
+    EXPECT_EQ(box.clearance({0.0, 0.5}), 0.0);
+
+    std::mt19937 gen(5);
+    std::normal_distribution<double> N(0.0, 0.03);
+    Vec2 a{0.5, 1.0}, b{0.5, 1.0};
+    double c = 0.0;
+    int fast = 0;
+    for (int s = 0; s < 20000; ++s) {
+        const Vec2 d = (s % 100 == 0) ? Vec2{3.0 * N(gen), 3.0 * N(gen)} * 30.0
+                                      : Vec2{N(gen), N(gen)};
+        const double before = c;
+        advance_with_reflections(a, d, box);
+        advance_with_clearance(b, d, box, c);
+        ASSERT_EQ(a.x, b.x) << "step " << s;
+        ASSERT_EQ(a.y, b.y) << "step " << s;
+        ASSERT_LE(c, box.clearance(b) + 1e-12) << "step " << s;
+        fast += (c < before);
+    }
+    EXPECT_GT(fast, 10000);   // most steps stay in the interior
+}
+
+// 11. Absorbing walls: the advancer stops at the first absorbing hit and reports it.
+TEST(ReflectingWorldTest, AdvanceToAbsorbingReportsContact) {
+    ReflectingWorld box;
+    box.add_inward_box(0.0, 1.0, 0.0, 1.0, 0);
+    EXPECT_FALSE(box.has_absorbing());
+    EXPECT_EQ(box.set_absorbing(1), 1u);     // right wall
+    EXPECT_TRUE(box.has_absorbing());
+
+    // Straight into the absorbing wall: contact halfway, reflected remainder handed back.
+    Vec2 x{0.5, 0.5}, d{1.0, 0.0};
+    WallContact c = advance_to_absorbing(x, d, box);
+    EXPECT_EQ(c.wall, 1);
+    EXPECT_EQ(c.id, 1);
+    EXPECT_EQ(c.absorb, 1.0);
+    EXPECT_NEAR(c.point.x, 1.0, 1e-12);
+    EXPECT_NEAR(c.point.y, 0.5, 1e-12);
+    EXPECT_NEAR(c.fraction, 0.5, 1e-12);
+    EXPECT_LT(x.x, 1.0);
+    EXPECT_NEAR(d.x, -0.5, 1e-12);
+
+    // Reflect off the left wall first: the fraction covers the whole path so far.
+    x = Vec2{0.5, 0.5};
+    d = Vec2{-1.8, 0.0};
+    c = advance_to_absorbing(x, d, box);
+    EXPECT_EQ(c.id, 1);
+    EXPECT_NEAR(c.fraction, 1.5 / 1.8, 1e-12);
+
+    // Missing it: same as the reflecting advancer, d consumed.
+    x = Vec2{0.5, 0.5};
+    d = Vec2{-0.8, 0.1};
+    Vec2 ref{0.5, 0.5};
+    advance_with_reflections(ref, d, box);
+    c = advance_to_absorbing(x, d, box);
+    EXPECT_EQ(c.wall, -1);
+    EXPECT_EQ(x.x, ref.x);
+    EXPECT_EQ(x.y, ref.y);
+    EXPECT_EQ(d.x, 0.0);
+
+    // Probability 0 turns the wall back into a reflector.
+    box.set_absorbing(1, 0.0);
+    EXPECT_FALSE(box.has_absorbing());
+    std::mt19937 gen(9);
+    std::normal_distribution<double> N(0.0, 0.2);
+    Vec2 a{0.5, 0.5}, b{0.5, 0.5};
+    double clear = 0.0;
+    for (int s = 0; s < 2000; ++s) {
+        Vec2 step{N(gen), N(gen)};
+        advance_with_reflections(a, step, box);
+        ASSERT_EQ(advance_to_absorbing(b, step, box, &clear).wall, -1);
+        ASSERT_EQ(a.x, b.x) << "step " << s;
+        ASSERT_EQ(a.y, b.y) << "step " << s;
+    }
+}
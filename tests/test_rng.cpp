@@ -1,6 +1,12 @@
 // test_rng.cpp
 #include "sim/rng.hpp"
+#include "sim/ziggurat.hpp"
+#include "sim/philox_rng.hpp"
 #include <gtest/gtest.h>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
 
 // 1. Check for reproducibility
 TEST(RNGTest, Reproducibility) {
@@ -25,4 +31,156 @@ TEST(RNGTest, DistributionSanity) {
 
     EXPECT_NEAR(mean, 0.0, 0.05);
     EXPECT_NEAR(var, 1.0, 0.05);
-}
\ No newline at end of file
+}
+// 3. Philox4x32-10 known-answer vectors (Random123 kat_vectors).
+TEST(PhiloxTest, KnownAnswerVectors) {
+    using P = sim::Philox4x32;
+    EXPECT_EQ(P::block({0u, 0u, 0u, 0u}, {0u, 0u}),
+              (P::counter_type{0x6627e8d5u, 0xe169c58du, 0xbc57ac4cu, 0x9b00dbd8u}));
+    EXPECT_EQ(P::block({0xffffffffu, 0xffffffffu, 0xffffffffu, 0xffffffffu}, {0xffffffffu, 0xffffffffu}),
+              (P::counter_type{0x408f276du, 0x41c83b0eu, 0xa20bc7c6u, 0x6d5451fdu}));
+    EXPECT_EQ(P::block({0x243f6a88u, 0x85a308d3u, 0x13198a2eu, 0x03707344u}, {0xa4093822u, 0x299f31d0u}),
+              (P::counter_type{0xd16cfe09u, 0x94fdccebu, 0x5001e420u, 0x24126ea1u}));
+}
+
+// 4. Counter-based streams: any step can be regenerated without replaying earlier ones.
+TEST(PhiloxTest, SeekStepRegeneratesWithoutReplay) {
+    sim::RNG sequential(sim::RngEngine::Philox4x32, 42u, 7u);
+    double step5[3] = {0.0, 0.0, 0.0};
+    for (std::uint64_t k = 0; k <= 5; ++k) {
+        sequential.seek_step(k);
+        for (double& v : step5) v = sequential.gauss();
+    }
+
+    sim::RNG direct(sim::RngEngine::Philox4x32, 42u, 7u);
+    direct.seek_step(5);
+    for (double v : step5) EXPECT_EQ(direct.gauss(), v);
+}
+
+// 5. Different streams (particles) and seeds give different numbers.
+TEST(PhiloxTest, StreamsAndSeedsAreIndependent) {
+    sim::RNG a(sim::RngEngine::Philox4x32, 1u, 0u);
+    sim::RNG b(sim::RngEngine::Philox4x32, 1u, 1u);
+    sim::RNG c(sim::RngEngine::Philox4x32, 2u, 0u);
+    const double va = a.gauss(), vb = b.gauss(), vc = c.gauss();
+    EXPECT_NE(va, vb);
+    EXPECT_NE(va, vc);
+}
+
+// 6. Philox normals have the right first two moments.
+TEST(PhiloxTest, DistributionSanity) {
+    sim::RNG rng(sim::RngEngine::Philox4x32, 123u);
+    double sum = 0.0, sumsq = 0.0;
+    const int N = 100000;
+    for (int i = 0; i < N; ++i) {
+        double x = rng.gauss();
+        sum += x;
+        sumsq += x * x;
+    }
+    double mean = sum / N;
+    double var = sumsq / N - mean * mean;
+
+    EXPECT_NEAR(mean, 0.0, 0.05);
+    EXPECT_NEAR(var, 1.0, 0.05);
+}
+
+// 7. Copies continue the same stream (both engines).
+TEST(RNGTest, CopyContinuesStream) {
+    for (auto engine : {sim::RngEngine::MT19937, sim::RngEngine::Philox4x32}) {
+        sim::RNG a(engine, 9u);
+        (void)a.gauss();
+        sim::RNG b = a;
+        for (int i = 0; i < 10; ++i) EXPECT_EQ(a.gauss(), b.gauss());
+    }
+}
+
+// 8. Ziggurat: bulk fill is bitwise identical to sequential draws (both engines).
+TEST(ZigguratTest, FillGaussMatchesSequentialDraws) {
+    for (auto engine : {sim::RngEngine::MT19937, sim::RngEngine::Philox4x32}) {
+        sim::RNG seq(engine, 77u, 3u, sim::NormalMethod::Ziggurat);
+        sim::RNG bulk(engine, 77u, 3u, sim::NormalMethod::Ziggurat);
+
+        std::vector<double> got(1000);
+        bulk.fill_gauss(got.data(), 600);          // chunk boundary inside the request
+        bulk.fill_gauss(got.data() + 600, 400);
+        for (std::size_t i = 0; i < got.size(); ++i) {
+            ASSERT_EQ(seq.gauss(), got[i]) << "i=" << i;
+        }
+        // Streams stay aligned after the bulk calls.
+        EXPECT_EQ(seq.gauss(), bulk.gauss());
+    }
+}
+
+// 9. Ziggurat: moments and tail mass of N(0,1).
+TEST(ZigguratTest, DistributionSanity) {
+    sim::RNG rng(sim::RngEngine::Philox4x32, 2025u, 0u, sim::NormalMethod::Ziggurat);
+    const std::size_t N = 400000;
+    std::vector<double> xs(N);
+    rng.fill_gauss(xs.data(), N);
+
+    double sum = 0.0, sumsq = 0.0, sum4 = 0.0;
+    std::size_t beyond2 = 0, beyond_r = 0;
+    for (double x : xs) {
+        sum += x; sumsq += x * x; sum4 += x * x * x * x;
+        if (std::abs(x) > 2.0) ++beyond2;
+        if (std::abs(x) > sim::ziggurat_tables().x[1]) ++beyond_r;
+    }
+    const double mean = sum / N;
+    const double var = sumsq / N - mean * mean;
+    EXPECT_NEAR(mean, 0.0, 0.01);
+    EXPECT_NEAR(var, 1.0, 0.01);
+    EXPECT_NEAR(sum4 / N, 3.0, 0.05);                          // kurtosis of N(0,1)
+    EXPECT_NEAR(static_cast<double>(beyond2) / N, 0.0455, 0.002); // P(|X| > 2)
+    EXPECT_GT(beyond_r, 0u);                                    // tail branch exercised
+}
+
+// 10. PhiloxRng (compile-time policy) reproduces RNG(Philox4x32, Ziggurat) exactly.
+TEST(PhiloxRngTest, MatchesRuntimeSelectedRng) {
+    const std::uint64_t seed = 0x1234567890abcdefULL, stream = (7ULL << 32) | 5u;
+    sim::RNG ref(sim::RngEngine::Philox4x32, seed, stream, sim::NormalMethod::Ziggurat);
+    sim::PhiloxRng fixed(seed, stream);
+    for (std::uint64_t step : {0u, 1u, 9u, 3u}) {
+        ref.seek_step(step);
+        fixed.seek_step(step);
+        for (int i = 0; i < 300; ++i) ASSERT_EQ(ref.gauss(), fixed.gauss()) << "step " << step;
+        ASSERT_EQ(ref.uniform(), fixed.uniform());
+        std::vector<double> a(100), b(100);
+        ref.fill_gauss(a.data(), a.size());
+        fixed.fill_gauss(b.data(), b.size());
+        ASSERT_EQ(a, b);
+    }
+}
+
+// 11. Ziggurat: the checked-in tables match the recurrence that defines them.
+TEST(ZigguratTest, TablesMatchRecurrence) {
+    const sim::ZigguratTables& t = sim::ziggurat_tables();
+    const auto f = [](double x) { return std::exp(-0.5 * x * x); };
+    const double R = 3.6541528853610088;
+    const double V = R * f(R) + std::sqrt(0.5 * 3.141592653589793) * std::erfc(R / std::sqrt(2.0));
+    EXPECT_EQ(t.x[1], R);
+    EXPECT_NEAR(t.x[0], V / f(R), 1e-12);
+    for (int i = 1; i < 255; ++i) {
+        EXPECT_NEAR(t.x[i + 1], std::sqrt(-2.0 * std::log(V / t.x[i] + f(t.x[i]))), 1e-12) << "i=" << i;
+    }
+    EXPECT_EQ(t.x[256], 0.0);
+    for (int i = 0; i <= 256; ++i) EXPECT_NEAR(t.f[i], f(t.x[i]), 1e-15) << "i=" << i;
+}
+
+// 12. Ziggurat known answer: the first 300 draws for a fixed (key, stream), which include a
+//     tail sample (draw 169), are the same bits on every platform.
+TEST(ZigguratTest, KnownAnswerDraws) {
+    sim::RNG rng(sim::RngEngine::Philox4x32, 2025u, 8u, sim::NormalMethod::Ziggurat);
+    EXPECT_EQ(rng.gauss(),  0x1.1614ff3d481a1p-1);
+    EXPECT_EQ(rng.gauss(), -0x1.c23e5bb81a421p-1);
+    EXPECT_EQ(rng.gauss(),  0x1.ecc698b16cd37p-1);
+
+    sim::RNG again(sim::RngEngine::Philox4x32, 2025u, 8u, sim::NormalMethod::Ziggurat);
+    std::uint64_t h = 0xcbf29ce484222325ULL;                  // FNV-1a over the bit patterns
+    for (int i = 0; i < 300; ++i) {
+        const double x = again.gauss();
+        std::uint64_t bits;
+        std::memcpy(&bits, &x, sizeof bits);
+        h = (h ^ bits) * 0x100000001b3ULL;
+    }
+    EXPECT_EQ(h, 0xec880d80ca61cd16ULL);
+}
@@ -1,8 +1,15 @@
 // tests/test_simulation.cpp
 #include <gtest/gtest.h>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <vector>
 #include "sim/simulation.hpp"
+#include "sim/basic_simulation.hpp"
+#include "sim/philox_rng.hpp"
 #include "sim/reflecting_world.hpp"
 #include "sim/vec2.hpp"
+#include "test_fixtures.hpp"
 
 using sim::Simulation;
 using sim::SimulationConfig;
@@ -23,11 +30,34 @@ ReflectingWorld makeEmptyWorld() {
     return w;
 }
 
-ReflectingWorld makeUnitBox() {
-    ReflectingWorld w;
-    // box from (0,0) to (1,1), inward normals; wall id = 0
-    w.add_inward_box(0.0, 1.0, 0.0, 1.0, /*wall_id=*/0);
-    return w;
+// Exact (bitwise) comparison of final positions and recorded history.
+void ExpectBitIdentical(const Simulation& a, const Simulation& b) {
+    ASSERT_EQ(a.positions().size(), b.positions().size());
+    for (std::size_t i = 0; i < a.positions().size(); ++i) {
+        EXPECT_EQ(a.positions()[i].x, b.positions()[i].x);
+        EXPECT_EQ(a.positions()[i].y, b.positions()[i].y);
+    }
+    ASSERT_EQ(a.history().size(), b.history().size());
+    for (std::size_t i = 0; i < a.history().size(); ++i) {
+        ASSERT_EQ(a.history()[i].size(), b.history()[i].size());
+        for (std::size_t f = 0; f < a.history()[i].size(); ++f) {
+            EXPECT_EQ(a.history()[i][f].x, b.history()[i][f].x);
+            EXPECT_EQ(a.history()[i][f].y, b.history()[i][f].y);
+        }
+    }
+}
+
+// Brownian particles started at the centre of the unit box.
+SimulationConfig makeBoxBrownianConfig() {
+    SimulationConfig cfg;
+    cfg.n_particles = 37;          // deliberately not a multiple of tile/thread counts
+    cfg.n_steps = 200;
+    cfg.record_history = true;
+    cfg.store_every = 7;
+    cfg.base_seed = 2024u;
+    cfg.brownian.dt = 0.01;
+    cfg.brownian.D = 0.5;
+    return cfg;
 }
 
 } // namespace
@@ -183,3 +213,514 @@ TEST(SimulationRepro, DeterministicSeedsMatch) {
         }
     }
 }
+
+// ------------------- Parallel execution -------------------
+
+TEST(SimulationParallel, ThreadedRunIsBitIdenticalToSerial) {
+    auto w = makeUnitBox();
+    SimulationConfig cfg = makeBoxBrownianConfig();
+    SimulationConfig cfg_mt = cfg;
+    cfg_mt.n_threads = 4;
+
+    Simulation serial(w, cfg);
+    Simulation threaded(w, cfg_mt);
+    std::vector<Vec2> init(cfg.n_particles, Vec2{0.5, 0.5});
+    serial.set_positions(init);
+    threaded.set_positions(init);
+
+    serial.run();
+    threaded.run();
+
+    ExpectBitIdentical(serial, threaded);
+}
+
+TEST(SimulationParallel, CallbackExceptionPropagatesToCaller) {
+    auto w = makeEmptyWorld();
+    SimulationConfig cfg;
+    cfg.n_particles = 8;
+    cfg.n_steps = 3;
+    cfg.n_threads = 4;
+
+    Simulation sim(w, cfg);
+    sim.set_step_type_all(StepType::Specified);
+    sim.set_specified_callback([](std::size_t i, std::size_t, const Vec2&, sim::RNG&) -> Vec2 {
+        if (i == 6) throw std::runtime_error("boom");
+        return Vec2{1.0, 0.0};
+    });
+    EXPECT_THROW(sim.run(), std::runtime_error);
+}
+
+// ------------------- Loop order -------------------
+
+TEST(SimulationLoopOrder, ParticleMajorMatchesStepMajor) {
+    auto w = makeUnitBox();
+    const SimulationConfig cfg = makeBoxBrownianConfig();
+    std::vector<Vec2> init(cfg.n_particles, Vec2{0.5, 0.5});
+
+    Simulation ref(w, cfg);
+    ref.set_positions(init);
+    ref.run();
+
+    for (std::size_t tile : {1u, 5u, 64u}) {
+        for (std::size_t threads : {1u, 3u}) {
+            SimulationConfig c = cfg;
+            c.loop_order = sim::LoopOrder::ParticleMajor;
+            c.tile_size = tile;
+            c.n_threads = threads;
+
+            Simulation pm(w, c);
+            pm.set_positions(init);
+            pm.run();
+            SCOPED_TRACE(testing::Message() << "tile=" << tile << " threads=" << threads);
+            ExpectBitIdentical(ref, pm);
+        }
+    }
+}
+
+// ------------------- Clearance early-out -------------------
+
+TEST(SimulationClearance, EarlyOutMatchesFullScan) {
+    // Quarter plane x >= 0, y >= 0 (as in the quarter-plane workloads), plus the unit box.
+    ReflectingWorld quarter;
+    quarter.add_half_plane_strip({1.0, 0.0}, 0.0, 1e6, 200);
+    quarter.add_half_plane_strip({0.0, 1.0}, 0.0, 1e6, 201);
+    ReflectingWorld box = makeUnitBox();
+
+    for (const ReflectingWorld* w : {&quarter, &box}) {
+        SimulationConfig cfg = makeBoxBrownianConfig();
+        std::vector<Vec2> init(cfg.n_particles, Vec2{0.1, 0.1});
+        cfg.use_clearance = false;
+        Simulation ref(*w, cfg);
+        ref.set_positions(init);
+        ref.run();
+
+        cfg.use_clearance = true;
+        Simulation fast(*w, cfg);
+        fast.set_positions(init);
+        fast.run();
+        ExpectBitIdentical(ref, fast);
+    }
+}
+
+// ------------------- SoA particle store -------------------
+
+TEST(SimulationStore, PositionsViewIsZeroCopyAndConvertible) {
+    auto w = makeEmptyWorld();
+    SimulationConfig cfg;
+    cfg.n_particles = 3;
+
+    Simulation sim(w, cfg);
+    std::vector<Vec2> init = { {1,2}, {3,4}, {5,6} };
+    sim.set_positions(init);
+
+    const sim::PositionsView view = sim.positions();
+    ASSERT_EQ(view.size(), 3u);
+    EXPECT_EQ(view.x(), sim.particles().x.data());   // no copy: points into the store
+    EXPECT_EQ(view.y(), sim.particles().y.data());
+
+    std::size_t i = 0;
+    for (Vec2 p : view) {
+        EXPECT_DOUBLE_EQ(p.x, init[i].x);
+        EXPECT_DOUBLE_EQ(p.y, init[i].y);
+        ++i;
+    }
+    EXPECT_EQ(i, 3u);
+
+    // Iterators outlive the temporary view returned by positions().
+    auto it = sim.positions().begin();
+    const auto last = sim.positions().end();
+    EXPECT_EQ(last - it, 3);
+    EXPECT_DOUBLE_EQ((*it).y, 2.0);
+    EXPECT_DOUBLE_EQ(it[2].x, 5.0);
+
+    const std::vector<Vec2> copy = sim.positions();  // conversion path
+    ASSERT_EQ(copy.size(), 3u);
+    EXPECT_DOUBLE_EQ(copy[2].x, 5.0);
+    EXPECT_DOUBLE_EQ(copy[2].y, 6.0);
+}
+
+TEST(SimulationStore, BrownianParamsRoundTripThroughColumns) {
+    auto w = makeEmptyWorld();
+    SimulationConfig cfg;
+    cfg.n_particles = 2;
+
+    Simulation sim(w, cfg);
+    sim::BrownianParams p;
+    p.dt = 0.25; p.D = 3.0; p.mu_x = -1.0; p.mu_y = 2.0;
+    sim.set_brownian_params(1, p);
+
+    const sim::BrownianParams q = sim.particles().brownian(1);
+    EXPECT_DOUBLE_EQ(q.dt, 0.25);
+    EXPECT_DOUBLE_EQ(q.D, 3.0);
+    EXPECT_DOUBLE_EQ(q.mu_x, -1.0);
+    EXPECT_DOUBLE_EQ(q.mu_y, 2.0);
+    EXPECT_DOUBLE_EQ(sim.particles().D[0], cfg.brownian.D); // untouched particle keeps defaults
+}
+
+// ------------------- Counter-based RNG -------------------
+
+TEST(SimulationRng, PhiloxRunsAreReproducibleAndScheduleIndependent) {
+    auto w = makeUnitBox();
+    SimulationConfig cfg = makeBoxBrownianConfig();
+    cfg.rng_engine = sim::RngEngine::Philox4x32;
+    std::vector<Vec2> init(cfg.n_particles, Vec2{0.5, 0.5});
+
+    Simulation a(w, cfg);
+    a.set_positions(init);
+    a.run();
+
+    SimulationConfig c2 = cfg;
+    c2.loop_order = sim::LoopOrder::ParticleMajor;
+    c2.n_threads = 3;
+    Simulation b(w, c2);
+    b.set_positions(init);
+    b.run();
+    ExpectBitIdentical(a, b);
+
+    // Different engine -> different trajectories for the same base_seed.
+    Simulation mt(w, makeBoxBrownianConfig());
+    mt.set_positions(init);
+    mt.run();
+    EXPECT_NE(a.positions()[0].x, mt.positions()[0].x);
+}
+
+// ------------------- Policy-templated core -------------------
+
+TEST(BasicSimulation, PhiloxPolicyMatchesRuntimeFacade) {
+    auto w = makeUnitBox();
+    SimulationConfig cfg = makeBoxBrownianConfig();
+    cfg.rng_engine = sim::RngEngine::Philox4x32;
+    cfg.normal_method = sim::NormalMethod::Ziggurat;
+    std::vector<Vec2> init(cfg.n_particles, Vec2{0.5, 0.5});
+
+    Simulation ref(w, cfg);
+    ref.set_positions(init);
+    ref.run();
+
+    cfg.n_threads = 3;
+    sim::BasicSimulation<sim::BrownianStep, ReflectingWorld, sim::PhiloxRng> fixed(w, cfg);
+    fixed.set_positions(init);
+    fixed.run();
+    for (std::size_t i = 0; i < cfg.n_particles; ++i) {
+        EXPECT_EQ(ref.positions()[i].x, fixed.positions()[i].x);
+        EXPECT_EQ(ref.positions()[i].y, fixed.positions()[i].y);
+    }
+    ASSERT_EQ(ref.history().size(), fixed.history().size());
+    for (std::size_t i = 0; i < ref.history().size(); ++i) {
+        ASSERT_EQ(ref.history()[i].size(), fixed.history()[i].size());
+        for (std::size_t f = 0; f < ref.history()[i].size(); ++f) {
+            EXPECT_EQ(ref.history()[i][f].x, fixed.history()[i][f].x);
+            EXPECT_EQ(ref.history()[i][f].y, fixed.history()[i][f].y);
+        }
+    }
+}
+
+TEST(BasicSimulation, InlineCallbackInAnalyticBox) {
+    SimulationConfig cfg;
+    cfg.n_particles = 4;
+    cfg.n_steps = 25;
+    cfg.record_history = false;
+
+    // Lambda policy (inlined): 25 steps of +0.1 in x from 0.5 reach 3.0, which folds to 1.0.
+    const auto right = sim::make_callback_step(
+        [](std::size_t, std::size_t, const Vec2&, sim::RNG&) { return Vec2{0.1, 0.0}; });
+    const sim::BoxWorld box{0.0, 1.0, 0.0, 1.0};
+    sim::BasicSimulation<decltype(right), sim::BoxWorld> s(box, cfg, right);
+    s.set_positions(std::vector<Vec2>(cfg.n_particles, Vec2{0.5, 0.5}));
+    s.run();
+    for (Vec2 p : s.positions()) {
+        EXPECT_NEAR(p.x, 1.0, 1e-12);
+        EXPECT_DOUBLE_EQ(p.y, 0.5);
+    }
+}
+
+TEST(BasicSimulation, GroupedRunMatchesMixedDispatch) {
+    auto w = makeUnitBox();
+    SimulationConfig cfg = makeBoxBrownianConfig();
+    cfg.n_particles = 200;
+    cfg.n_steps = 40;
+    cfg.store_every = 3;
+
+    // Callback depends on the particle index, so a wrong index mapping changes the result.
+    const sim::SpecifiedCallback cb = [](std::size_t i, std::size_t, const Vec2&, sim::RNG& rng) {
+        return Vec2{0.002 * static_cast<double>(i % 5) - 0.004, 0.01 * rng.gauss()};
+    };
+    using Core = sim::BasicSimulation<sim::MixedStep, ReflectingWorld>;
+    Core mixed(w, cfg, sim::MixedStep{cb});
+    cfg.n_threads = 3;
+    Core grouped(w, cfg, sim::MixedStep{cb});
+    for (Core* s : {&mixed, &grouped}) {
+        s->set_positions(std::vector<Vec2>(cfg.n_particles, Vec2{0.5, 0.5}));
+        for (std::size_t i = 0; i < cfg.n_particles; ++i) {
+            if (i % 3 == 0) {
+                s->set_step_type(i, StepType::Specified);
+            } else if (i % 2 == 0) {
+                sim::BrownianParams p = cfg.brownian;
+                p.D *= 2.0;
+                s->set_brownian_params(i, p);   // second params group (>= kMinParamGroup)
+            }
+        }
+    }
+
+    // Two runs: the second continues from restored state and appends to history.
+    for (int r = 0; r < 2; ++r) {
+        mixed.run();
+        grouped.run_grouped(sim::BrownianStep{}, sim::CallbackStep<const sim::SpecifiedCallback&>{cb});
+    }
+    for (std::size_t i = 0; i < cfg.n_particles; ++i) {
+        EXPECT_EQ(mixed.positions()[i].x, grouped.positions()[i].x) << "particle " << i;
+        EXPECT_EQ(mixed.positions()[i].y, grouped.positions()[i].y) << "particle " << i;
+        EXPECT_EQ(mixed.particles().step_type[i], grouped.particles().step_type[i]);
+        EXPECT_EQ(mixed.particles().D[i], grouped.particles().D[i]);
+    }
+    ASSERT_EQ(mixed.history().size(), grouped.history().size());
+    for (std::size_t i = 0; i < mixed.history().size(); ++i) {
+        ASSERT_EQ(mixed.history()[i].size(), grouped.history()[i].size());
+        for (std::size_t f = 0; f < mixed.history()[i].size(); ++f) {
+            EXPECT_EQ(mixed.history()[i][f].x, grouped.history()[i][f].x);
+            EXPECT_EQ(mixed.history()[i][f].y, grouped.history()[i][f].y);
+        }
+    }
+}
+
+// Absorbing right wall: retired particles stop at the wall with their exit step and wall id.
+TEST(SimulationAbsorbing, ExitRecordsAreScheduleIndependent) {
+    auto w = makeUnitBox();
+    w.set_absorbing(1);
+    SimulationConfig cfg = makeBoxBrownianConfig();
+    cfg.n_particles = 101;
+    cfg.n_steps = 60;
+    cfg.store_every = 4;
+
+    Simulation ref(w, cfg);
+    ref.set_positions(std::vector<Vec2>(cfg.n_particles, Vec2{0.5, 0.5}));
+    ref.run();
+    ref.run();
+    const auto& st = ref.particles();
+    ASSERT_GT(ref.n_absorbed(), 10u);
+    ASSERT_LT(ref.n_absorbed(), cfg.n_particles);
+    for (std::size_t i = 0; i < cfg.n_particles; ++i) {
+        const Vec2 p = ref.positions()[i];
+        const auto& h = ref.history()[i];
+        ASSERT_EQ(h.size(), 1 + 2 * cfg.n_steps / cfg.store_every);
+        if (st.alive[i]) {
+            EXPECT_EQ(st.exit_wall[i], -1);
+            EXPECT_LT(st.exit_step[i], 0.0);
+            EXPECT_LT(p.x, 1.0);
+            continue;
+        }
+        EXPECT_EQ(st.exit_wall[i], 1);
+        EXPECT_NEAR(p.x, 1.0, 1e-9);
+        EXPECT_GT(st.exit_step[i], 0.0);
+        EXPECT_LE(st.exit_step[i], 2.0 * static_cast<double>(cfg.n_steps));
+        // Frozen at the exit point in every frame recorded after the exit.
+        for (std::size_t f = 0; f < h.size(); ++f) {
+            if (static_cast<double>(f * cfg.store_every) >= st.exit_step[i]) {
+                EXPECT_EQ(h[f].x, p.x);
+                EXPECT_EQ(h[f].y, p.y);
+            } else {
+                EXPECT_LT(h[f].x, 1.0);
+            }
+        }
+    }
+
+    // Threads, loop order and mixed step models give the same exits.
+    const Simulation::SpecifiedCallback drift = [](std::size_t, std::size_t, const Vec2&, sim::RNG& rng) {
+        return Vec2{0.02 + 0.05 * rng.gauss(), 0.05 * rng.gauss()};
+    };
+    for (int variant = 0; variant < 3; ++variant) {
+        SimulationConfig c = cfg;
+        c.n_threads = variant == 0 ? 1 : 3;
+        c.loop_order = variant == 2 ? sim::LoopOrder::ParticleMajor : sim::LoopOrder::StepMajor;
+        c.tile_size = 5;
+        Simulation a(w, c), b(w, cfg);
+        for (Simulation* s : {&a, &b}) {
+            s->set_positions(std::vector<Vec2>(cfg.n_particles, Vec2{0.5, 0.5}));
+            if (variant > 0) {
+                s->set_specified_callback(drift);
+                for (std::size_t i = 0; i < cfg.n_particles; i += 4) s->set_step_type(i, StepType::Specified);
+            }
+            s->run();
+            s->run();
+        }
+        ExpectBitIdentical(a, b);
+        EXPECT_EQ(a.particles().alive, b.particles().alive);
+        EXPECT_EQ(a.particles().exit_step, b.particles().exit_step);
+        EXPECT_EQ(a.particles().exit_wall, b.particles().exit_wall);
+    }
+}
+
+// Partial absorption draws from each particle's stream; observers only see active particles.
+TEST(SimulationAbsorbing, PartialWallsAndObservers) {
+    auto w = makeUnitBox();
+    w.set_absorbing(1, 0.3);
+    SimulationConfig cfg = makeBoxBrownianConfig();
+    cfg.n_particles = 80;
+    cfg.n_steps = 50;
+    cfg.record_history = false;
+
+    auto hist = sim::HistogramObserver::grid(0.0, 1.0, 4, 0.0, 1.0, 4, 10);
+    Simulation a(w, cfg);
+    a.add_observer(&hist);
+    a.set_positions(std::vector<Vec2>(cfg.n_particles, Vec2{0.8, 0.5}));
+    a.run();
+    ASSERT_GT(a.n_absorbed(), 0u);
+    EXPECT_EQ(hist.total(0), cfg.n_particles);
+    EXPECT_EQ(hist.total(cfg.n_steps / 10), cfg.n_particles - a.n_absorbed());
+
+    cfg.n_threads = 4;
+    Simulation b(w, cfg);
+    b.set_positions(std::vector<Vec2>(cfg.n_particles, Vec2{0.8, 0.5}));
+    b.run();
+    EXPECT_EQ(a.particles().exit_step, b.particles().exit_step);
+    for (std::size_t i = 0; i < cfg.n_particles; ++i) {
+        EXPECT_EQ(a.positions()[i].x, b.positions()[i].x);
+    }
+
+    // Placing an absorbed particle again brings it back.
+    std::size_t dead = 0;
+    while (b.particles().alive[dead]) ++dead;
+    b.set_position(dead, Vec2{0.5, 0.5});
+    EXPECT_EQ(b.particles().alive[dead], 1);
+    EXPECT_EQ(b.n_absorbed(), a.n_absorbed() - 1);
+}
+
+// ------------------- Segmented runs (run_until / run_steps) -------------------
+
+// A run split into segments is bit-identical to run(): callback step index, absorption,
+// history stride, observer outputs and (with a sink) the streamed frames.
+TEST(SimulationSegments, SplitRunsMatchWholeRuns) {
+    auto w = makeUnitBox();
+    w.set_absorbing(1);
+    SimulationConfig cfg = makeBoxBrownianConfig();
+    cfg.n_particles = 61;
+    cfg.n_steps = 30;
+    cfg.store_every = 4;
+    cfg.n_threads = 3;
+
+    // Drift grows with the step index, so a shifted k would move the particles elsewhere.
+    const Simulation::SpecifiedCallback drift = [](std::size_t, std::size_t k, const Vec2&, sim::RNG& rng) {
+        return Vec2{0.002 * static_cast<double>(k) + 0.03 * rng.gauss(), 0.03 * rng.gauss()};
+    };
+    for (auto engine : {sim::RngEngine::MT19937, sim::RngEngine::Philox4x32}) {
+        SimulationConfig c = cfg;
+        c.rng_engine = engine;
+        auto ha = sim::HistogramObserver::grid(0.0, 1.0, 3, 0.0, 1.0, 3, 5);
+        auto hb = ha;
+        sim::MomentObserver ma(3), mb(3);
+        Simulation a(w, c), b(w, c);
+        for (Simulation* s : {&a, &b}) {
+            s->set_positions(std::vector<Vec2>(c.n_particles, Vec2{0.7, 0.5}));
+            s->set_specified_callback(drift);
+            for (std::size_t i = 0; i < c.n_particles; i += 2) s->set_step_type(i, StepType::Specified);
+        }
+        a.add_observer(&ha);
+        a.add_observer(&ma);
+        b.add_observer(&hb);
+        b.add_observer(&mb);
+
+        a.run();
+        a.run();
+        b.run_until(7);
+        EXPECT_EQ(b.run_position(), 7u);
+        EXPECT_EQ(b.history()[0].size(), 1u + 7 / c.store_every);
+        EXPECT_EQ(hb.n_outputs(), 1u + 7 / 5);
+        EXPECT_THROW(b.run_until(7), std::out_of_range);              // not ahead of the position
+        EXPECT_THROW(b.run_until(c.n_steps + 1), std::out_of_range);  // past the end of the run
+        EXPECT_EQ(b.run_position(), 7u);
+        b.run_until(13);
+        b.run_steps(c.n_steps - 13 + 11);   // completes run 1, then 11 steps of run 2
+        EXPECT_EQ(b.run_position(), 11u);
+        b.run_steps(c.n_steps - 11);
+        EXPECT_EQ(b.run_position(), 0u);
+
+        ASSERT_GT(a.n_absorbed(), 0u);
+        ExpectBitIdentical(a, b);
+        EXPECT_EQ(a.particles().exit_step, b.particles().exit_step);
+        ASSERT_EQ(ha.n_outputs(), hb.n_outputs());
+        for (std::size_t f = 0; f < ha.n_outputs(); ++f) {
+            for (std::size_t k = 0; k <= ha.n_bins(); ++k) EXPECT_EQ(ha.count(f, k), hb.count(f, k));
+            EXPECT_EQ(ma.moments(f, sim::MomentObserver::R).mean, mb.moments(f, sim::MomentObserver::R).mean);
+            EXPECT_EQ(ma.moments(f, sim::MomentObserver::R).m2, mb.moments(f, sim::MomentObserver::R).m2);
+        }
+    }
+}
+
+TEST(SimulationSegments, StreamedFramesKeepTheirNumbering) {
+    const auto w = makeUnitBox();
+    SimulationConfig cfg = makeBoxBrownianConfig();
+    cfg.n_steps = 50;
+    cfg.store_every = 6;
+    cfg.history_buffer_bytes = 2048;
+
+    std::vector<std::vector<double>> frames[2];
+    for (int v = 0; v < 2; ++v) {
+        sim::CallbackHistorySink sink([&frames, v](const sim::HistoryFrames& f) {
+            for (std::size_t j = 0; j < f.n_frames; ++j) {
+                ASSERT_EQ(f.first_frame + j, frames[v].size());
+                frames[v].emplace_back(f.x + j * f.n_particles, f.x + (j + 1) * f.n_particles);
+            }
+        });
+        Simulation s(w, cfg);
+        s.set_positions(std::vector<Vec2>(cfg.n_particles, Vec2{0.5, 0.5}));
+        s.set_history_sink(&sink);
+        if (v == 0) {
+            s.run();
+        } else {
+            for (std::size_t k : {1u, 5u, 7u, 20u, 17u}) s.run_steps(k);
+        }
+    }
+    EXPECT_EQ(frames[0].size(), 1u + cfg.n_steps / cfg.store_every);
+    EXPECT_EQ(frames[0], frames[1]);
+}
+
+// One-step segments keep the run's writer and fill buffer: the sink sees the same blocks and a
+// single flush, as for run(). Buffered frames are delivered before a checkpoint, when the sink
+// changes and when a paused simulation is destroyed.
+TEST(SimulationSegments, SegmentsShareTheRunsHistoryWriter) {
+    struct CountingSink : sim::HistorySink {
+        std::vector<std::size_t> blocks;
+        std::size_t frames = 0, flushes = 0;
+        void write(const sim::HistoryFrames& f) override {
+            blocks.push_back(f.n_frames);
+            frames += f.n_frames;
+        }
+        void flush() override { ++flushes; }
+    };
+    const auto w = makeUnitBox();
+    SimulationConfig cfg = makeBoxBrownianConfig();
+    cfg.n_steps = 120;
+    cfg.store_every = 3;
+    cfg.history_buffer_bytes = 2 * 16 * 2 * sizeof(double) * cfg.n_particles;    // two buffers of 16 frames
+
+    CountingSink whole, split;
+    for (CountingSink* sink : {&whole, &split}) {
+        Simulation s(w, cfg);
+        s.set_history_sink(sink);
+        if (sink == &whole) {
+            s.run();
+        } else {
+            for (std::size_t k = 0; k < cfg.n_steps; ++k) s.run_steps(1);
+        }
+    }
+    EXPECT_EQ(split.blocks, whole.blocks);
+    EXPECT_EQ(split.flushes, 1u);
+
+    const std::string path = ::testing::TempDir() + "segments_writer.ckp";
+    CountingSink paused, next;
+    {
+        Simulation s(w, cfg);
+        s.set_history_sink(&paused);
+        s.run_until(20);
+        EXPECT_LT(paused.frames, 1u + 20 / cfg.store_every);      // still in the fill buffer
+        s.save_checkpoint(path);
+        EXPECT_EQ(paused.frames, 1u + 20 / cfg.store_every);
+        EXPECT_EQ(s.streamed_frames(), paused.frames);
+        s.run_until(40);
+        s.set_history_sink(&next, s.streamed_frames());
+        EXPECT_EQ(paused.frames, 1u + 40 / cfg.store_every);
+        s.run_until(50);
+    }
+    EXPECT_EQ(next.frames, 50 / cfg.store_every - 40 / cfg.store_every);
+    std::remove(path.c_str());
+}
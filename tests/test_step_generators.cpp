@@ -111,4 +111,45 @@ TEST(Simulation, E2E_WithSpecifiedStep) {
 #else
   // original E2E assertions
 #endif
-}
\ No newline at end of file
+}
+// ------------------------- Brownian: batched kernels -------------------------
+TEST(BrownianFill, HomogeneousMatchesPerParticleStep) {
+    BrownianParams p;
+    p.dt = 0.05; p.D = 1.7; p.mu_x = 0.4; p.mu_y = -2.0;
+
+    const std::size_t N = 37;  // exercises SIMD body and scalar tail
+    RNG r_ref(99), r_batch(99);
+    std::vector<double> gx(N), gy(N), dx(N), dy(N);
+    for (std::size_t j = 0; j < N; ++j) { gx[j] = r_batch.gauss(); gy[j] = r_batch.gauss(); }
+
+    sim::brownian_fill(sim::brownian_coeffs(p), N, gx.data(), gy.data(), dx.data(), dy.data());
+    for (std::size_t j = 0; j < N; ++j) {
+        Vec2 d = brownian_step(p, r_ref);
+        EXPECT_DOUBLE_EQ(dx[j], d.x) << "j=" << j << " isa=" << sim::brownian_fill_isa();
+        EXPECT_DOUBLE_EQ(dy[j], d.y) << "j=" << j << " isa=" << sim::brownian_fill_isa();
+    }
+}
+
+TEST(BrownianFill, PerEntryColumnsMatchPerParticleStep) {
+    const std::size_t N = 21;
+    std::vector<double> dt(N), D(N), mux(N), muy(N), gx(N), gy(N), dx(N), dy(N);
+    RNG r_ref(5), r_batch(5);
+    for (std::size_t j = 0; j < N; ++j) {
+        dt[j]  = 0.01 * (j + 1);
+        D[j]   = 0.5 + 0.1 * j;
+        mux[j] = 0.1 * j;
+        muy[j] = -0.2 * j;
+        gx[j] = r_batch.gauss();
+        gy[j] = r_batch.gauss();
+    }
+
+    sim::brownian_fill(N, dt.data(), D.data(), mux.data(), muy.data(),
+                       gx.data(), gy.data(), dx.data(), dy.data());
+    for (std::size_t j = 0; j < N; ++j) {
+        BrownianParams p;
+        p.dt = dt[j]; p.D = D[j]; p.mu_x = mux[j]; p.mu_y = muy[j];
+        Vec2 d = brownian_step(p, r_ref);
+        EXPECT_DOUBLE_EQ(dx[j], d.x) << "j=" << j;
+        EXPECT_DOUBLE_EQ(dy[j], d.y) << "j=" << j;
+    }
+}
@@ -0,0 +1,215 @@
+// tests/test_sweep.cpp
+#include <gtest/gtest.h>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "sim/sweep.hpp"
+
+using sim::SweepGeometry;
+using sim::SweepOptions;
+using sim::SweepParams;
+
+// 1. Rows parse like the SLURM scripts read them; the output path keeps the fields verbatim.
+TEST(SweepTest, ParsesRowsAndBuildsOutputLayout) {
+    std::istringstream list("# tf d x0 y0 nsteps nreals nbins\n"
+                            "0.05 1.0 0.10 0.10 500 1000 50\n"
+                            "\n"
+                            "  0.1 5 0.5 0.50 200 5000 40\r\n");
+    const auto rows = sim::read_params_list(list);
+    ASSERT_EQ(rows.size(), 2u);
+    EXPECT_EQ(rows[0].tf, 0.05);
+    EXPECT_EQ(rows[0].x0, 0.1);
+    EXPECT_EQ(rows[0].nsteps, 500u);
+    EXPECT_EQ(rows[0].nreals, 1000u);
+    EXPECT_EQ(rows[1].d, 5.0);
+    EXPECT_EQ(rows[1].nbins, 40u);
+    EXPECT_EQ(sim::sweep_output_dir(rows[0], SweepGeometry::Quarter, "out"),
+              "out/Quarter_plane/1000_realizations/500_time_steps/Initial_pos_X0_0.10_Y0_0.10/t_0.05/d_1.0");
+    EXPECT_EQ(sim::sweep_output_dir(rows[1], SweepGeometry::Eighth, "."),
+              "./Eighth_Wedge/5000_realizations/200_time_steps/Initial_pos_X0_0.5_Y0_0.50/t_0.1/d_5");
+
+    EXPECT_THROW(sim::parse_sweep_row("0.05 1.0 0.1 0.1 500 1000"), std::runtime_error);
+    EXPECT_THROW(sim::parse_sweep_row("0.05 1.0 0.1 0.1 500 1000 50 7"), std::runtime_error);
+    EXPECT_THROW(sim::parse_sweep_row("0.05 1.0 0.1 0.1 500.5 1000 50"), std::runtime_error);
+    EXPECT_THROW(sim::parse_sweep_row("0.05 abc 0.1 0.1 500 1000 50"), std::runtime_error);
+    EXPECT_THROW(sim::parse_sweep_row("1 0 0 0 10 10 4"), std::runtime_error);     // empty grid: L = 0
+    EXPECT_NO_THROW(sim::parse_sweep_row("1 0 0.5 0 10 10 4"));
+}
+
+// 2. Rows run in-process: particles stay in the domain, results are thread-count independent.
+TEST(SweepTest, RowsRunInDomainAndReproducibly) {
+    const SweepParams p = sim::parse_sweep_row("0.2 0.5 0.3 0.1 100 3000 8");
+    for (auto geometry : {SweepGeometry::Quarter, SweepGeometry::Eighth}) {
+        SweepOptions opt;
+        opt.geometry = geometry;
+        const auto a = sim::run_sweep_row(p, opt);
+        opt.n_threads = 3;
+        const auto b = sim::run_sweep_row(p, opt);
+
+        const auto& h = a.histogram;
+        ASSERT_EQ(h.n_outputs(), 2u);
+        EXPECT_EQ(h.total(1), p.nreals);
+        EXPECT_LT(h.outside(1), p.nreals / 100);
+        for (std::size_t k = 0; k <= h.n_bins(); ++k) EXPECT_EQ(h.count(1, k), b.histogram.count(1, k));
+        if (geometry == SweepGeometry::Eighth) {
+            // Bins entirely above the diagonal lie outside the wedge.
+            for (std::size_t iy = 1; iy < h.ny(); ++iy) EXPECT_EQ(h.count(1, iy * h.nx() + iy - 1), 0u);
+        }
+        // Quarter plane: reflecting walls keep E[y] above the free-space value y0.
+        const auto& my = a.moments.moments(1, sim::MomentObserver::Y);
+        EXPECT_GT(my.mean, p.y0);
+    }
+}
+
+// 3. run_sweep_task() writes results.txt: header, then nbins^2 "x y count density" lines.
+TEST(SweepTest, WritesResultsFile) {
+    const std::string root = ::testing::TempDir() + "sweep_test";
+    const SweepParams p = sim::parse_sweep_row("0.05 1.0 0.10 0.20 50 500 4");
+    SweepOptions opt;
+    opt.out_root = root;
+    const std::string path = sim::run_sweep_task(p, opt);
+    EXPECT_EQ(path, sim::sweep_output_dir(p, SweepGeometry::Quarter, root) + "/results.txt");
+
+    std::ifstream in(path);
+    std::string line;
+    std::size_t header = 0, bins = 0;
+    std::uint64_t total = 0;
+    double mass = 0.0;
+    const double extent = 0.2 + 6.0 * std::sqrt(2.0 * 1.0 * 0.05);
+    const double area = (extent / 4) * (extent / 4);
+    while (std::getline(in, line)) {
+        if (line[0] == '#') {
+            ++header;
+            continue;
+        }
+        std::istringstream row(line);
+        double x, y, density;
+        std::uint64_t count;
+        ASSERT_TRUE(static_cast<bool>(row >> x >> y >> count >> density));
+        ++bins;
+        total += count;
+        mass += density * area;
+    }
+    EXPECT_GE(header, 4u);
+    EXPECT_EQ(bins, 16u);
+    EXPECT_LE(total, p.nreals);
+    EXPECT_NEAR(mass, static_cast<double>(total) / p.nreals, 1e-12);
+    std::filesystem::remove_all(root);
+}
+
+// 4. Packed rows give each row exactly what it gets when run alone.
+TEST(SweepTest, PackedRowsMatchSeparateRuns) {
+    std::istringstream list("0.2 0.5 0.3 0.1 60 700 6\n"
+                            "0.1 2.0 0.4 0.05 60 300 5\n"
+                            "0.4 0.1 0.2 0.2 60 1100 7\n");
+    const auto rows = sim::read_params_list(list);
+    for (auto geometry : {SweepGeometry::Quarter, SweepGeometry::Eighth}) {
+        SweepOptions opt;
+        opt.geometry = geometry;
+        opt.n_threads = 3;
+        const auto packed = sim::run_sweep_pack(rows, opt);
+        ASSERT_EQ(packed.size(), rows.size());
+        for (std::size_t r = 0; r < rows.size(); ++r) {
+            opt.n_threads = 1;
+            const auto alone = sim::run_sweep_row(rows[r], opt);
+            std::ostringstream a, b;
+            sim::write_sweep_results(a, rows[r], geometry, packed[r]);
+            sim::write_sweep_results(b, rows[r], geometry, alone);
+            EXPECT_EQ(a.str(), b.str()) << "row " << r;
+            EXPECT_EQ(packed[r].histogram.total(1), rows[r].nreals);
+        }
+    }
+    std::vector<SweepParams> mixed = rows;
+    mixed[1].nsteps = 61;
+    EXPECT_THROW(sim::run_sweep_pack(mixed, SweepOptions{}), std::invalid_argument);
+}
+
+// 5. Packs group rows of equal nsteps in order, up to the particle cap.
+TEST(SweepTest, PlansPacksByStepsAndSize) {
+    std::vector<SweepParams> rows(6);
+    const std::size_t nsteps[] = {100, 100, 200, 100, 200, 100};
+    const std::size_t nreals[] = {400, 500, 300, 200, 900, 2000};
+    for (std::size_t r = 0; r < rows.size(); ++r) {
+        rows[r].nsteps = nsteps[r];
+        rows[r].nreals = nreals[r];
+    }
+    const auto packs = sim::plan_sweep_packs(rows, 1000);
+    const std::vector<std::vector<std::size_t>> expected{{0, 1}, {2}, {3}, {4}, {5}};
+    EXPECT_EQ(packs, expected);
+    EXPECT_EQ(sim::plan_sweep_packs(rows, 0).size(), rows.size());
+    EXPECT_EQ(sim::plan_sweep_packs(rows, 5000),
+              (std::vector<std::vector<std::size_t>>{{0, 1, 3, 5}, {2, 4}}));
+}
+
+// 6. The local scheduler splits rows into chunks; merged rows do not depend on the thread count
+//    and have the histogram of the whole-row run.
+TEST(SweepTest, LocalSchedulerMergesChunksReproducibly) {
+    std::istringstream list("0.2 0.5 0.3 0.1 40 1700 6\n"
+                            "0.1 2.0 0.4 0.05 90 120 5\n"
+                            "0.4 0.1 0.2 0.2 20 650 7\n");
+    const auto rows = sim::read_params_list(list);
+    SweepOptions opt;
+    opt.geometry = SweepGeometry::Eighth;
+    opt.chunk_particles = 256;
+    EXPECT_EQ(sim::plan_sweep_chunks(rows, opt.chunk_particles).size(), 7u + 1u + 3u);
+    EXPECT_EQ(sim::plan_sweep_chunks(rows, 0).size(), rows.size());
+
+    const auto run_local = [&](std::size_t threads) {
+        opt.n_threads = threads;
+        std::vector<std::string> text(rows.size());
+        std::vector<int> calls(rows.size(), 0);
+        sim::run_sweep_local(rows, opt, [&](std::size_t r, const sim::SweepResult& result) {
+            std::ostringstream os;
+            sim::write_sweep_results(os, rows[r], opt.geometry, result);
+            text[r] = os.str();
+            ++calls[r];
+
+            const auto alone = sim::run_sweep_row(rows[r], SweepOptions{opt.geometry});
+            for (std::size_t k = 0; k <= result.histogram.n_bins(); ++k) {
+                EXPECT_EQ(result.histogram.count(1, k), alone.histogram.count(1, k));
+            }
+            const auto& m = result.moments.moments(1, sim::MomentObserver::R);
+            EXPECT_EQ(m.n, rows[r].nreals);
+            EXPECT_NEAR(m.mean, alone.moments.moments(1, sim::MomentObserver::R).mean, 1e-12);
+        });
+        EXPECT_EQ(calls, std::vector<int>(rows.size(), 1));
+        return text;
+    };
+    EXPECT_EQ(run_local(1), run_local(4));
+
+    EXPECT_THROW(sim::run_sweep_local(rows, opt, [](std::size_t r, const sim::SweepResult&) {
+                     if (r == 1) throw std::runtime_error("write failed");
+                 }),
+                 std::runtime_error);
+}
+
+// 7. Rows starting outside the domain are rejected when run, for the pack and the local paths.
+TEST(SweepTest, RejectsStartsOutsideTheDomain) {
+    const auto none = [](std::size_t, const sim::SweepResult&) { FAIL() << "no row should run"; };
+    const SweepParams ok = sim::parse_sweep_row("0.1 0.5 0.3 0.1 20 50 4");
+
+    SweepOptions quarter;
+    const SweepParams left = sim::parse_sweep_row("0.1 0.5 -0.1 0.2 20 50 4");      // x0 < 0
+    EXPECT_NO_THROW(sim::run_sweep_row(ok, quarter));
+    EXPECT_THROW(sim::run_sweep_row(left, quarter), std::runtime_error);
+    EXPECT_THROW(sim::run_sweep_pack({ok, left}, quarter), std::runtime_error);
+    EXPECT_THROW(sim::run_sweep_local({ok, left}, quarter, none), std::runtime_error);
+
+    SweepOptions eighth;
+    eighth.geometry = SweepGeometry::Eighth;
+    const SweepParams above = sim::parse_sweep_row("0.1 0.5 0.1 0.2 20 50 4");      // y0 > x0
+    EXPECT_NO_THROW(sim::run_sweep_row(ok, eighth));
+    EXPECT_NO_THROW(sim::run_sweep_row(above, quarter));
+    EXPECT_THROW(sim::run_sweep_row(above, eighth), std::runtime_error);
+    EXPECT_THROW(sim::run_sweep_pack({ok, above}, eighth), std::runtime_error);
+    EXPECT_THROW(sim::run_sweep_local({ok, above}, eighth, none), std::runtime_error);
+    try {
+        sim::run_sweep_row(above, eighth);
+    } catch (const std::runtime_error& e) {
+        EXPECT_NE(std::string(e.what()).find("0.1 0.5 0.1 0.2 20 50 4"), std::string::npos) << e.what();
+    }
+}
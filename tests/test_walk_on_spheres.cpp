@@ -0,0 +1,105 @@
+// tests/test_walk_on_spheres.cpp
+#include <gtest/gtest.h>
+#include <cmath>
+#include <random>
+#include <vector>
+#include "sim/walk_on_spheres.hpp"
+#include "sim/reflecting_world.hpp"
+#include "test_fixtures.hpp"
+
+using sim::ReflectingWorld;
+using sim::Vec2;
+using sim::WalkOnSpheres;
+using sim::WosConfig;
+
+namespace {
+
+// Regular polygon approximating the unit disk, one wall id per edge.
+ReflectingWorld makePolygon(int n) {
+    ReflectingWorld w;
+    const double pi = std::acos(-1.0);
+    for (int k = 0; k < n; ++k) {
+        const double a0 = 2.0 * pi * k / n, a1 = 2.0 * pi * (k + 1) / n;
+        w.add_segment_auto(Vec2{std::cos(a0), std::sin(a0)}, Vec2{std::cos(a1), std::sin(a1)}, true, k);
+    }
+    return w;
+}
+
+// u(x, y) = x*y + x is harmonic; it is also its own boundary data.
+double Harmonic(const Vec2& p, int /*wall_id*/) { return p.x * p.y + p.x; }
+
+} // namespace
+
+// 1. The indexed distance query returns exactly the brute-force nearest wall.
+TEST(WalkOnSpheresTest, IndexedNearestWallMatchesScan) {
+    ReflectingWorld plain = makePolygon(300);
+    ReflectingWorld indexed = plain;
+    indexed.build_index();
+    ASSERT_TRUE(indexed.has_index());
+
+    std::mt19937 gen(11);
+    std::uniform_real_distribution<double> U(-1.2, 1.2);
+    for (int s = 0; s < 3000; ++s) {
+        const Vec2 p{U(gen), U(gen)};
+        const auto a = plain.nearest_wall(p);
+        const auto b = indexed.nearest_wall(p);
+        ASSERT_EQ(a.wall, b.wall) << "sample " << s;
+        ASSERT_EQ(a.distance, b.distance);
+        ASSERT_EQ(a.point.x, b.point.x);
+        EXPECT_LE(plain.clearance(p), a.distance);
+    }
+    EXPECT_EQ(ReflectingWorld{}.nearest_wall({0.0, 0.0}).wall, -1);
+}
+
+// 2. The estimate of a harmonic function agrees with its value within the reported error.
+TEST(WalkOnSpheresTest, EstimatesHarmonicFunction) {
+    auto w = makeUnitBox();
+    w.build_index();
+    WosConfig cfg;
+    cfg.n_walks = 4000;
+    cfg.epsilon = 1e-5;
+    WalkOnSpheres wos(w, cfg);
+
+    const Vec2 x0{0.3, 0.6};
+    const auto est = wos.estimate(x0, Harmonic);
+    EXPECT_EQ(est.n_unfinished, 0u);
+    EXPECT_EQ(est.value.n, cfg.n_walks);
+    EXPECT_NEAR(est.value.mean, Harmonic(x0, 0), 5.0 * est.value.std_error() + 1e-4);
+    EXPECT_GT(est.steps.mean, 2.0);
+    EXPECT_LT(est.steps.mean, 60.0);
+
+    // Harmonic measure from the centre: each side gets about a quarter of the walks.
+    const auto centre = wos.estimate(Vec2{0.5, 0.5}, Harmonic);
+    ASSERT_EQ(centre.exits.size(), 4u);
+    for (std::uint64_t e : centre.exits) EXPECT_NEAR(static_cast<double>(e) / cfg.n_walks, 0.25, 0.04);
+}
+
+// 3. Results are bit-identical across thread counts, index use and per-point calls.
+TEST(WalkOnSpheresTest, ReproducibleAcrossThreadsAndIndex) {
+    for (auto engine : {sim::RngEngine::MT19937, sim::RngEngine::Philox4x32}) {
+        auto plain = makePolygon(64);
+        auto indexed = plain;
+        indexed.build_index();
+        WosConfig cfg;
+        cfg.n_walks = 700;       // not a multiple of the chunk size
+        cfg.epsilon = 1e-4;
+        cfg.rng_engine = engine;
+        WalkOnSpheres serial(plain, cfg);
+        cfg.n_threads = 3;
+        WalkOnSpheres threaded(indexed, cfg);
+
+        const std::vector<Vec2> points{{0.0, 0.0}, {0.4, -0.3}};
+        const auto a = serial.estimate(points, Harmonic);
+        const auto b = threaded.estimate(points, Harmonic);
+        ASSERT_EQ(a.size(), 2u);
+        for (std::size_t q = 0; q < 2; ++q) {
+            EXPECT_EQ(a[q].value.mean, b[q].value.mean);
+            EXPECT_EQ(a[q].value.m2, b[q].value.m2);
+            EXPECT_EQ(a[q].steps.mean, b[q].steps.mean);
+            EXPECT_EQ(a[q].exits, b[q].exits);
+        }
+        const auto single = threaded.estimate(points[1], Harmonic, 1);
+        EXPECT_EQ(single.value.mean, a[1].value.mean);
+        EXPECT_NE(a[0].value.mean, serial.estimate(points[0], Harmonic, 1).value.mean);
+    }
+}